@@ -0,0 +1,167 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_arena.hpp"
+#include "cppspt/cppspt_relocate.hpp"
+
+#include "cppspt_bench.hpp"
+#include "cppspt_tracking.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+
+    Per-request allocation cost: a handler copies a request's header values & body (lvalue in parameters)
+    into request-scoped storage, reads them, and drops everything at the end of the request.
+
+        heap: uninit_vector<std::string>, every copy through the global heap
+        arena: arena_vector of arena_allocator strings, with one arena reset per request
+        pmr (C++17): a std::pmr::vector of uninit std::pmr::strings over a std::pmr::monotonic_buffer_resource, released per request
+            (release() returns its chunks to the heap, unlike arena::reset())
+
+    Prints the time, and the heap allocations & bytes, per request
+
+*/
+
+#if defined (_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+using arena_string = std::basic_string<char, std::char_traits<char>, cppspt::arena_allocator<char>>;
+
+const std::size_t header_count = 24;
+const std::size_t request_count = 200000;
+
+template<typename String, typename Alloc>
+std::vector<String> make_request(const Alloc& alloc)
+{
+    std::vector<String> values;
+    for (std::size_t i = 0; i < header_count; i++)
+    {
+        values.push_back(String(24 + (i * 37) % 100, static_cast<char>('a' + i % 26), alloc));
+    }
+    values.push_back(String(1024, 'b', alloc));
+    return values;
+}
+
+//The handler only reads its values, so sums their sizes
+template<typename Vector>
+std::size_t read_all(const Vector& values)
+{
+    std::size_t total = 0;
+    for (const auto& value : values)
+    {
+        total += value->size();
+    }
+    return total;
+}
+
+BENCH_NOINLINE std::size_t handle_heap(const std::vector<std::string>& request)
+{
+    cppspt::uninit_vector<std::string> values;
+    for (const std::string& value : request)
+    {
+        values.push_back(value);
+    }
+    return read_all(values);
+}
+
+BENCH_NOINLINE std::size_t handle_arena(const std::vector<arena_string>& request, cppspt::arena& scratch)
+{
+    std::size_t total;
+    {
+        cppspt::arena_vector<arena_string> values(scratch);
+        for (const arena_string& value : request)
+        {
+            values.push_back(value);
+        }
+        total = read_all(values);
+    }
+    scratch.reset();
+    return total;
+}
+
+#if defined (CPPSPT_HAS_MEMORY_RESOURCE)
+
+BENCH_NOINLINE std::size_t handle_pmr(const std::vector<std::pmr::string>& request, std::pmr::monotonic_buffer_resource& scratch)
+{
+    std::size_t total = 0;
+    {
+        std::pmr::vector<cppspt::uninit<std::pmr::string>> values(&scratch);
+        for (const std::pmr::string& value : request)
+        {
+            cppspt::in<std::pmr::string> param(value);
+            values.emplace_back();
+            cppspt::assign_with_allocator(values.back(), std::move(param), &scratch);
+        }
+        for (const cppspt::uninit<std::pmr::string>& value : values)
+        {
+            total += value->size();
+        }
+    }
+    scratch.release();
+    return total;
+}
+
+#endif
+
+template<typename Handle>
+void run(const char* name, Handle handle)
+{
+    std::size_t total = 0;
+
+    //One request first, so any chunks kept between requests already exist
+    total += handle();
+
+    cppspt_tracking::tracking_scope scope;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < request_count; i++)
+    {
+        total += handle();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    cppspt_tracking::counts counts = scope.delta();
+    cppspt_bench::do_not_optimize(total);
+
+    std::printf("%-32s %10.1f ns/request %8.2f heap allocations/request %10.1f heap bytes/request\n", name,
+        ns / request_count,
+        static_cast<double>(counts.allocations) / request_count,
+        static_cast<double>(counts.allocated_bytes) / request_count);
+}
+
+int main()
+{
+    std::printf("%u header values & a 1 KiB body per request\n", static_cast<unsigned>(header_count));
+
+    std::vector<std::string> heap_request = make_request<std::string>(std::allocator<char>());
+    run("heap", [&] { return handle_heap(heap_request); });
+
+    cppspt::arena connection;
+    std::vector<arena_string> arena_request = make_request<arena_string>(cppspt::arena_allocator<char>(connection));
+
+    cppspt::arena scratch(16384);
+    run("arena", [&] { return handle_arena(arena_request, scratch); });
+
+    //With the first chunk on the stack, nothing is left to allocate
+    alignas(std::max_align_t) char buffer[16384];
+    cppspt::arena stack_scratch(buffer, sizeof(buffer));
+    run("arena, stack buffer", [&] { return handle_arena(arena_request, stack_scratch); });
+
+#if defined (CPPSPT_HAS_MEMORY_RESOURCE)
+    std::vector<std::pmr::string> pmr_request = make_request<std::pmr::string>(std::pmr::polymorphic_allocator<char>());
+    std::pmr::monotonic_buffer_resource pmr_scratch(16384);
+    run("pmr monotonic_buffer_resource", [&] { return handle_pmr(pmr_request, pmr_scratch); });
+
+    alignas(std::max_align_t) char pmr_buffer[16384];
+    std::pmr::monotonic_buffer_resource pmr_stack_scratch(pmr_buffer, sizeof(pmr_buffer));
+    run("pmr, stack buffer", [&] { return handle_pmr(pmr_request, pmr_stack_scratch); });
+#endif
+    return 0;
+}
@@ -0,0 +1,53 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+/*
+
+    Minimal timing helpers for the benchmarks
+
+*/
+
+namespace cppspt_bench
+{
+    /// <summary>
+    /// Prevents the compiler from optimizing away a value
+    /// </summary>
+    template<typename T>
+    inline void do_not_optimize(const T& val)
+    {
+#if defined (_MSC_VER)
+        const volatile char* ptr = reinterpret_cast<const volatile char*>(&val);
+        (void)*ptr;
+#else
+        asm volatile("" : : "r"(&val) : "memory");
+#endif
+    }
+
+    /// <summary>
+    /// Runs func iterations times and returns the average nanoseconds per call
+    /// </summary>
+    template<typename Func>
+    double measure_ns(std::size_t iterations, Func func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; i++)
+        {
+            func(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    }
+
+    inline void report(const char* name, double ns_per_op)
+    {
+        std::printf("%-48s %12.3f ns/op\n", name, ns_per_op);
+    }
+}
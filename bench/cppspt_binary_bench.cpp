@@ -0,0 +1,202 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_binary.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+
+    Decodes batches of messages with binary_reader, against a decoder that default constructs
+    each message and then assigns every decoded field. Times are per message
+
+*/
+
+struct sample
+{
+    std::uint64_t timestamp;
+    double values[8];
+};
+
+struct channel
+{
+    std::string name;
+    std::vector<sample> samples;
+};
+
+struct message
+{
+    std::uint64_t id;
+    std::string source;
+    std::vector<std::int32_t> counters;
+    std::vector<channel> channels;
+    sample summary;
+};
+
+namespace cppspt
+{
+    template<>
+    struct binary_fields<channel>
+    {
+        static auto fields() { return binary_members(&channel::name, &channel::samples); }
+    };
+
+    template<>
+    struct binary_fields<message>
+    {
+        static auto fields() { return binary_members(&message::id, &message::source, &message::counters, &message::channels, &message::summary); }
+    };
+}
+
+/*
+
+    The assigning decoder: each field is decoded into a temporary, then assigned
+
+*/
+
+class assigning_decoder
+{
+private:
+    const unsigned char* m_pos;
+
+    template<typename T>
+    T raw()
+    {
+        T result;
+        std::memcpy(&result, m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return result;
+    }
+
+    std::uint32_t length()
+    {
+        return raw<std::uint32_t>();
+    }
+
+    std::string string()
+    {
+        std::uint32_t size = length();
+        std::string result(reinterpret_cast<const char*>(m_pos), size);
+        m_pos += size;
+        return result;
+    }
+
+    template<typename T>
+    std::vector<T> raw_vector()
+    {
+        std::vector<T> result;
+        std::uint32_t count = length();
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            result.push_back(raw<T>());
+        }
+        return result;
+    }
+
+public:
+    explicit assigning_decoder(const unsigned char* data) : m_pos(data) {}
+
+    void decode(message& result)
+    {
+        result.id = raw<std::uint64_t>();
+        result.source = string();
+        result.counters = raw_vector<std::int32_t>();
+
+        std::uint32_t count = length();
+        result.channels.clear();
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            channel decoded;
+            decoded.name = string();
+            decoded.samples = raw_vector<sample>();
+            result.channels.push_back(decoded);
+        }
+
+        result.summary = raw<sample>();
+    }
+};
+
+message make_message(std::size_t i, std::size_t counters, std::size_t channels, std::size_t samples)
+{
+    message result;
+    result.id = i;
+    result.source = "sensor-array/building-" + std::to_string(i % 97) + "/floor-" + std::to_string(i % 13);
+    result.counters.assign(counters, static_cast<std::int32_t>(i));
+    for (std::size_t c = 0; c < channels; c++)
+    {
+        channel ch;
+        ch.name = "channel-with-a-long-descriptive-name-" + std::to_string(c);
+        ch.samples.resize(samples);
+        for (std::size_t s = 0; s < samples; s++)
+        {
+            ch.samples[s].timestamp = i + s;
+            ch.samples[s].values[0] = static_cast<double>(s);
+        }
+        result.channels.push_back(ch);
+    }
+    result.summary.timestamp = i;
+    return result;
+}
+
+void run(std::size_t counters, std::size_t channels, std::size_t samples)
+{
+    const std::size_t batch_size = 2000;
+    const std::size_t batches = 20;
+
+    cppspt::binary_writer writer;
+    for (std::size_t i = 0; i < batch_size; i++)
+    {
+        writer.write(make_message(i, counters, channels, samples));
+    }
+
+    char label[96];
+    std::uint64_t sum = 0;
+
+    std::snprintf(label, sizeof(label), "%u counters, %ux%u samples, assign",
+        static_cast<unsigned>(counters), static_cast<unsigned>(channels), static_cast<unsigned>(samples));
+    double ns = cppspt_bench::measure_ns(batches, [&](std::size_t)
+    {
+        std::vector<message> batch(batch_size);
+        assigning_decoder decoder(writer.data());
+        for (std::size_t i = 0; i < batch_size; i++)
+        {
+            decoder.decode(batch[i]);
+        }
+        sum += batch.back().id;
+        cppspt_bench::do_not_optimize(batch);
+    });
+    cppspt_bench::report(label, ns / batch_size);
+
+    std::snprintf(label, sizeof(label), "%u counters, %ux%u samples, binary_reader",
+        static_cast<unsigned>(counters), static_cast<unsigned>(channels), static_cast<unsigned>(samples));
+    ns = cppspt_bench::measure_ns(batches, [&](std::size_t)
+    {
+        std::vector<cppspt::uninit<message>> batch(batch_size);
+        cppspt::binary_reader reader(writer.data(), writer.size());
+        for (std::size_t i = 0; i < batch_size; i++)
+        {
+            reader.read(batch[i]);
+        }
+        sum += batch.back()->id;
+        cppspt_bench::do_not_optimize(batch);
+    });
+    cppspt_bench::report(label, ns / batch_size);
+
+    cppspt_bench::do_not_optimize(sum);
+}
+
+int main()
+{
+    run(16, 1, 4);
+    run(256, 4, 64);
+    run(4096, 16, 256);
+    return 0;
+}
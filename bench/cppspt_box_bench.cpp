@@ -0,0 +1,94 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_box.hpp"
+
+#include "cppspt_bench.hpp"
+#include "cppspt_tracking.hpp"
+
+#include <cstdio>
+#include <vector>
+
+/*
+
+    Memory footprint and scan time of sparse tables, whose records hold several optional big members,
+    stored as uninit<T> against uninit_box<T>
+
+*/
+
+struct big_struct
+{
+    double values[32];
+    long long id;
+};
+
+static const std::size_t fields = 8;
+
+template<template<typename> class Slot>
+struct record
+{
+    Slot<big_struct> members[fields];
+};
+
+template<typename T>
+using uninit_slot = cppspt::uninit<T>;
+
+template<typename T>
+using box_slot = cppspt::uninit_box<T>;
+
+//Fills one member in every `stride` slots, and reports the bytes used and the time to sum the filled members
+template<template<typename> class Slot>
+void run_table(const char* name, std::size_t rows, std::size_t stride)
+{
+    cppspt_tracking::tracking_scope scope;
+
+    std::vector<record<Slot>> table(rows);
+    for (std::size_t slot = 0; slot < rows * fields; slot += stride)
+    {
+        big_struct val;
+        val.id = static_cast<long long>(slot);
+        table[slot / fields].members[slot % fields] = val;
+    }
+
+    cppspt_tracking::counts allocated = scope.delta();
+    double megabytes = static_cast<double>(allocated.allocated_bytes - allocated.deallocated_bytes) / (1024.0 * 1024.0);
+
+    char label[96];
+    std::snprintf(label, sizeof(label), "%s, 1/%u filled", name, static_cast<unsigned>(stride));
+    std::printf("%-48s %12.1f MB\n", label, megabytes);
+
+    long long sum = 0;
+    double ns = cppspt_bench::measure_ns(rows, [&](std::size_t row)
+    {
+        for (std::size_t i = 0; i < fields; i++)
+        {
+            if (table[row].members[i].was_initialized())
+            {
+                sum += table[row].members[i]->id;
+            }
+        }
+    });
+    cppspt_bench::do_not_optimize(sum);
+
+    std::snprintf(label, sizeof(label), "%s, 1/%u filled, scan per row", name, static_cast<unsigned>(stride));
+    cppspt_bench::report(label, ns);
+}
+
+int main()
+{
+    const std::size_t rows = 100000;
+
+    std::printf("sizeof(uninit<big_struct>) = %u, sizeof(uninit_box<big_struct>) = %u\n",
+        static_cast<unsigned>(sizeof(cppspt::uninit<big_struct>)), static_cast<unsigned>(sizeof(cppspt::uninit_box<big_struct>)));
+
+    const std::size_t strides[] = { 1, 4, 32, 256 };
+    for (std::size_t stride : strides)
+    {
+        run_table<uninit_slot>("uninit", rows, stride);
+        run_table<box_slot>("uninit_box", rows, stride);
+    }
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_cache.hpp"
+
+#include "cppspt_bench.hpp"
+#include "cppspt_tracking.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+
+    Read-through caching of a Zipfian key stream: on a miss, the value is built and put.
+    Reports the hit rate, the time per lookup and the allocations per lookup once warm,
+    for clock_cache against a std::list + std::unordered_map LRU, then the throughput of sharded_clock_cache over several threads
+
+*/
+
+const std::size_t key_count = 100000;
+const std::size_t cache_capacity = key_count / 10;
+const std::size_t stream_length = 2000000;
+
+//Keys drawn with probability proportional to 1 / rank^skew
+std::vector<std::uint32_t> zipf_stream(std::size_t length, double skew, std::uint32_t seed)
+{
+    std::vector<double> cdf(key_count);
+    double total = 0.0;
+    for (std::size_t i = 0; i < key_count; i++)
+    {
+        total += 1.0 / std::pow(static_cast<double>(i + 1), skew);
+        cdf[i] = total;
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(0.0, total);
+    std::vector<std::uint32_t> stream(length);
+    for (std::size_t i = 0; i < length; i++)
+    {
+        stream[i] = static_cast<std::uint32_t>(std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin());
+    }
+    return stream;
+}
+
+//Values are long enough to need a heap buffer, like a cached row or response
+std::string make_value(std::uint32_t key)
+{
+    std::string val(64, 'v');
+    val[0] = static_cast<char>('a' + key % 26);
+    return val;
+}
+
+class list_lru_cache
+{
+private:
+    using entry = std::pair<std::uint32_t, std::string>;
+
+    std::list<entry> m_order;
+    std::unordered_map<std::uint32_t, std::list<entry>::iterator> m_lookup;
+    std::size_t m_capacity;
+
+public:
+    explicit list_lru_cache(std::size_t capacity) : m_capacity(capacity)
+    {
+        m_lookup.reserve(capacity);
+    }
+
+    bool get(std::uint32_t key, std::string& dest)
+    {
+        auto it = m_lookup.find(key);
+        if (it == m_lookup.end())
+        {
+            return false;
+        }
+        m_order.splice(m_order.begin(), m_order, it->second);
+        dest = it->second->second;
+        return true;
+    }
+
+    void put(std::uint32_t key, std::string&& value)
+    {
+        if (m_lookup.size() == m_capacity)
+        {
+            m_lookup.erase(m_order.back().first);
+            m_order.pop_back();
+        }
+        m_order.emplace_front(key, std::move(value));
+        m_lookup.emplace(key, m_order.begin());
+    }
+};
+
+template<typename Cache>
+void run_stream(const char* name, const std::vector<std::uint32_t>& stream)
+{
+    Cache cache(cache_capacity);
+    std::string result;
+
+    //Warm with the first half, measure the second
+    std::size_t half = stream.size() / 2;
+    for (std::size_t i = 0; i < half; i++)
+    {
+        if (!cache.get(stream[i], result))
+        {
+            cache.put(stream[i], make_value(stream[i]));
+        }
+    }
+
+    std::size_t hits = 0;
+    cppspt_tracking::tracking_scope scope;
+    double ns = cppspt_bench::measure_ns(half, [&](std::size_t i)
+    {
+        std::uint32_t key = stream[half + i];
+        if (cache.get(key, result))
+        {
+            hits++;
+        }
+        else
+        {
+            cache.put(key, make_value(key));
+        }
+    });
+    cppspt_tracking::counts counts = scope.delta();
+    cppspt_bench::do_not_optimize(result);
+
+    //make_value allocates once per miss, whichever the cache
+    double misses = static_cast<double>(half - hits);
+    double cache_allocations = static_cast<double>(counts.allocations) - misses;
+
+    cppspt_bench::report(name, ns);
+    std::printf("%-48s %12.3f %% hits, %.3f allocations/op besides the value\n", "", 100.0 * hits / half, cache_allocations / half);
+}
+
+using cppspt_cache = cppspt::clock_cache<std::uint32_t, std::string>;
+
+void run_threads(const std::vector<std::uint32_t>& stream, std::size_t thread_count, std::size_t shard_count)
+{
+    cppspt::sharded_clock_cache<std::uint32_t, std::string> cache(cache_capacity, shard_count);
+    std::size_t per_thread = stream.size() / thread_count;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back([&cache, &stream, per_thread, t]
+        {
+            std::string result;
+            for (std::size_t i = t * per_thread; i < (t + 1) * per_thread; i++)
+            {
+                if (!cache.get(stream[i], result))
+                {
+                    cache.put(stream[i], make_value(stream[i]));
+                }
+            }
+            cppspt_bench::do_not_optimize(result);
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    char label[96];
+    std::snprintf(label, sizeof(label), "sharded, %u threads, %u shards", static_cast<unsigned>(thread_count), static_cast<unsigned>(shard_count));
+    std::printf("%-48s %12.3f Mops/s\n", label, per_thread * thread_count / seconds / 1e6);
+}
+
+int main()
+{
+    const double skews[] = { 0.8, 0.99, 1.2 };
+    for (double skew : skews)
+    {
+        std::vector<std::uint32_t> stream = zipf_stream(stream_length, skew, 42);
+        std::printf("zipf skew %.2f, %u keys, capacity %u\n", skew, static_cast<unsigned>(key_count), static_cast<unsigned>(cache_capacity));
+        run_stream<cppspt_cache>("  clock_cache", stream);
+        run_stream<list_lru_cache>("  std::list + std::unordered_map LRU", stream);
+    }
+
+    std::vector<std::uint32_t> stream = zipf_stream(stream_length, 0.99, 7);
+    const std::size_t thread_counts[] = { 1, 2, 4, 8 };
+    for (std::size_t threads : thread_counts)
+    {
+        run_threads(stream, threads, 1);
+        run_threads(stream, threads, 16);
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_column.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <functional>
+#include <vector>
+
+/*
+
+    Compares uninit_column bulk operations against a loop over std::vector<uninit<T>>,
+    which is how the single value fapply is applied to many values
+
+*/
+
+int main()
+{
+    const std::size_t size = 10000000;
+    const std::size_t repeats = 10;
+
+    std::vector<cppspt::uninit<float>> rows(size);
+    cppspt::uninit_column<float> column;
+    column.reserve(size);
+
+    //About a quarter of the values are uninitialized
+    for (std::size_t i = 0; i < size; i++)
+    {
+        if ((i * 2654435761u) % 4 == 0)
+        {
+            column.push_back(cppspt::unitialized_t);
+        }
+        else
+        {
+            float val = static_cast<float>(i % 1000);
+            rows[i] = val;
+            column.push_back(val);
+        }
+    }
+
+    std::function<float(cppspt::in<float>)> scale = [](cppspt::in<float> x) { return *x * 1.5f + 2.0f; };
+
+    cppspt_bench::report("fapply: vector<uninit<float>> + std::function", cppspt_bench::measure_ns(repeats, [&](std::size_t)
+    {
+        std::vector<cppspt::uninit<float>> row_result(size);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            if (rows[i].was_initialized())
+            {
+                row_result[i] = scale(*rows[i]);
+            }
+        }
+        cppspt_bench::do_not_optimize(row_result);
+    }) / size);
+
+    cppspt_bench::report("fapply: uninit_column", cppspt_bench::measure_ns(repeats, [&](std::size_t)
+    {
+        cppspt::uninit_column<float> result = cppspt::fapply([](float x) { return x * 1.5f + 2.0f; }, column);
+        cppspt_bench::do_not_optimize(result);
+    }) / size);
+
+    cppspt_bench::report("filter: vector<uninit<float>>", cppspt_bench::measure_ns(repeats, [&](std::size_t)
+    {
+        std::vector<cppspt::uninit<float>> result(size);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            if (rows[i].was_initialized() && *rows[i] > 500.0f)
+            {
+                result[i] = *rows[i];
+            }
+        }
+        cppspt_bench::do_not_optimize(result);
+    }) / size);
+
+    cppspt_bench::report("filter: uninit_column", cppspt_bench::measure_ns(repeats, [&](std::size_t)
+    {
+        cppspt::uninit_column<float> result = cppspt::filter(column, [](float x) { return x > 500.0f; });
+        cppspt_bench::do_not_optimize(result);
+    }) / size);
+
+    cppspt_bench::report("reduce: vector<uninit<float>>", cppspt_bench::measure_ns(repeats, [&](std::size_t)
+    {
+        float sum = 0.0f;
+        for (std::size_t i = 0; i < size; i++)
+        {
+            if (rows[i].was_initialized())
+            {
+                sum += *rows[i];
+            }
+        }
+        cppspt_bench::do_not_optimize(sum);
+    }) / size);
+
+    cppspt_bench::report("reduce: uninit_column", cppspt_bench::measure_ns(repeats, [&](std::size_t)
+    {
+        float sum = cppspt::reduce(column, 0.0f, [](float acc, float x) { return acc + x; });
+        cppspt_bench::do_not_optimize(sum);
+    }) / size);
+
+    return 0;
+}
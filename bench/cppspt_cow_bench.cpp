@@ -0,0 +1,115 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_cow.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+
+    Functions that only modify their input on a rare branch:
+    resolving a local copy of an in<T> up front, against copying an in_cow<T> on write
+
+*/
+
+#if defined (_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+//Modifies one call in every 64
+static bool should_modify(std::size_t i)
+{
+    return (i & 63) == 0;
+}
+
+BENCH_NOINLINE std::size_t checksum_resolve(cppspt::in<std::string> str, std::size_t i)
+{
+    std::string local = cppspt::resolve(str);
+    if (should_modify(i))
+    {
+        local += '!';
+    }
+    return local.size() + static_cast<unsigned char>(local[0]);
+}
+
+BENCH_NOINLINE std::size_t checksum_cow(cppspt::in_cow<std::string> str, std::size_t i)
+{
+    if (should_modify(i))
+    {
+        str.mut() += '!';
+    }
+    return str->size() + static_cast<unsigned char>((*str)[0]);
+}
+
+BENCH_NOINLINE std::size_t checksum_resolve(cppspt::in<std::vector<int>> vec, std::size_t i)
+{
+    std::vector<int> local = cppspt::resolve(vec);
+    if (should_modify(i))
+    {
+        local.push_back(1);
+    }
+    return local.size() + static_cast<std::size_t>(local[0]);
+}
+
+BENCH_NOINLINE std::size_t checksum_cow(cppspt::in_cow<std::vector<int>> vec, std::size_t i)
+{
+    if (should_modify(i))
+    {
+        vec.mut().push_back(1);
+    }
+    return vec->size() + static_cast<std::size_t>((*vec)[0]);
+}
+
+template<typename T>
+void run(const char* type_name, const T& val, std::size_t iterations)
+{
+    char label[96];
+    std::size_t sum = 0;
+
+    std::snprintf(label, sizeof(label), "%s, lvalue, resolve", type_name);
+    cppspt_bench::report(label, cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+    {
+        sum += checksum_resolve(val, i);
+    }));
+
+    std::snprintf(label, sizeof(label), "%s, lvalue, in_cow", type_name);
+    cppspt_bench::report(label, cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+    {
+        sum += checksum_cow(val, i);
+    }));
+
+    //Callers that move pay for building the value either way; in_cow skips the move into the local
+    std::snprintf(label, sizeof(label), "%s, rvalue, resolve", type_name);
+    cppspt_bench::report(label, cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+    {
+        T temp = val;
+        sum += checksum_resolve(std::move(temp), i);
+    }));
+
+    std::snprintf(label, sizeof(label), "%s, rvalue, in_cow", type_name);
+    cppspt_bench::report(label, cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+    {
+        T temp = val;
+        sum += checksum_cow(std::move(temp), i);
+    }));
+
+    cppspt_bench::do_not_optimize(sum);
+}
+
+int main()
+{
+    const std::size_t iterations = 2000000;
+
+    run("string(4096)", std::string(4096, 'x'), iterations);
+    run("vector<int>(4096)", std::vector<int>(4096, 1), iterations);
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_format.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+/*
+
+    Compares printing uninit values by value (the old stream operator) against the const reference operator,
+    to_chars and std::format, in a tight logging loop
+
+*/
+
+//A stream buffer that counts characters and throws them away, so the benchmark measures formatting, not I/O
+class counting_buffer : public std::streambuf
+{
+public:
+    std::size_t count = 0;
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        count++;
+        return ch;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize n) override
+    {
+        count += static_cast<std::size_t>(n);
+        return n;
+    }
+};
+
+//The old stream operator, which copied the uninit (and its value) for every line
+template<typename T>
+std::ostream& print_by_value(std::ostream& out, cppspt::uninit<T> val)
+{
+    if (val.was_initialized())
+    {
+        return out << *val;
+    }
+    return out << "[Uninitialized]";
+}
+
+int main()
+{
+    const std::size_t iterations = 10000000;
+
+    counting_buffer buffer;
+    std::ostream log(&buffer);
+
+    cppspt::uninit<std::string> message(std::string("a log message long enough to need a heap allocation"));
+    cppspt::uninit<int> number(123456);
+
+    cppspt_bench::report("ostream, uninit<std::string> by value", cppspt_bench::measure_ns(iterations, [&](std::size_t)
+    {
+        print_by_value(log, message) << '\n';
+    }));
+
+    cppspt_bench::report("ostream, uninit<std::string> by const ref", cppspt_bench::measure_ns(iterations, [&](std::size_t)
+    {
+        log << message << '\n';
+    }));
+
+    cppspt_bench::report("ostream, uninit<int> by value", cppspt_bench::measure_ns(iterations, [&](std::size_t)
+    {
+        print_by_value(log, number) << '\n';
+    }));
+
+    cppspt_bench::report("ostream, uninit<int> by const ref", cppspt_bench::measure_ns(iterations, [&](std::size_t)
+    {
+        log << number << '\n';
+    }));
+
+    char line[64];
+    cppspt_bench::report("to_chars, uninit<int>", cppspt_bench::measure_ns(iterations, [&](std::size_t)
+    {
+        std::to_chars_result result = cppspt::to_chars(line, line + sizeof(line), number);
+        cppspt_bench::do_not_optimize(result.ptr);
+    }));
+
+#if defined (__cpp_lib_format)
+    cppspt_bench::report("std::format_to, uninit<std::string>", cppspt_bench::measure_ns(iterations, [&](std::size_t)
+    {
+        char* end = std::format_to(line, "{:.32}", message);
+        cppspt_bench::do_not_optimize(end);
+    }));
+
+    cppspt_bench::report("std::format_to, uninit<int>", cppspt_bench::measure_ns(iterations, [&](std::size_t)
+    {
+        char* end = std::format_to(line, "{}", number);
+        cppspt_bench::do_not_optimize(end);
+    }));
+#endif
+
+    cppspt_bench::do_not_optimize(buffer.count);
+    return 0;
+}
@@ -0,0 +1,128 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_hashed.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+
+    Looks long string keys up through three layers of hash maps (a cache, a map and an index),
+    hashing the key in every layer against hashing it once in a hashed_in
+
+*/
+
+#if defined (__cpp_lib_generic_unordered_lookup)
+
+using plain_map = std::unordered_map<std::string, int>;
+using hashed_map = std::unordered_map<std::string, int, cppspt::hashed_in_hash<std::string>, cppspt::hashed_in_equal<std::string>>;
+
+struct plain_layers
+{
+    plain_map cache;
+    plain_map map;
+    plain_map index;
+
+    int lookup(const std::string& key) const
+    {
+        int result = 0;
+        auto it = cache.find(key);
+        result += (it != cache.end()) ? it->second : 0;
+        it = map.find(key);
+        result += (it != map.end()) ? it->second : 0;
+        it = index.find(key);
+        result += (it != index.end()) ? it->second : 0;
+        return result;
+    }
+};
+
+struct hashed_layers
+{
+    hashed_map cache;
+    hashed_map map;
+    hashed_map index;
+
+    int lookup(cppspt::hashed_in<std::string> key) const
+    {
+        int result = 0;
+        auto it = cache.find(key);
+        result += (it != cache.end()) ? it->second : 0;
+        it = map.find(key);
+        result += (it != map.end()) ? it->second : 0;
+        it = index.find(key);
+        result += (it != index.end()) ? it->second : 0;
+        return result;
+    }
+};
+
+void run(std::size_t key_length)
+{
+    const std::size_t key_count = 10000;
+    const std::size_t iterations = 2000000;
+
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < key_count; i++)
+    {
+        std::string key(key_length, 'k');
+        key += std::to_string(i);
+        keys.push_back(key);
+    }
+
+    plain_layers plain;
+    hashed_layers hashed;
+    for (std::size_t i = 0; i < key_count; i++)
+    {
+        //The cache only holds every 4th key
+        if (i % 4 == 0)
+        {
+            plain.cache.emplace(keys[i], 1);
+            hashed.cache.emplace(keys[i], 1);
+        }
+        plain.map.emplace(keys[i], 2);
+        hashed.map.emplace(keys[i], 2);
+        plain.index.emplace(keys[i], 3);
+        hashed.index.emplace(keys[i], 3);
+    }
+
+    char label[96];
+    int sum = 0;
+
+    std::snprintf(label, sizeof(label), "3 layers, %u char keys, hash per layer", static_cast<unsigned>(key_length));
+    cppspt_bench::report(label, cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+    {
+        sum += plain.lookup(keys[(i * 7919) % key_count]);
+    }));
+
+    std::snprintf(label, sizeof(label), "3 layers, %u char keys, hashed_in", static_cast<unsigned>(key_length));
+    cppspt_bench::report(label, cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+    {
+        sum += hashed.lookup(keys[(i * 7919) % key_count]);
+    }));
+
+    cppspt_bench::do_not_optimize(sum);
+}
+
+int main()
+{
+    run(16);
+    run(256);
+    run(4096);
+    return 0;
+}
+
+#else
+
+int main()
+{
+    std::printf("Heterogeneous unordered lookup (C++20) is not available\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,243 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_ipc.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+
+    Passes 64 byte records to a second (forked) process through an ipc_ring, against a Unix domain socket:
+    streaming throughput, and the round trip time of a ping-pong
+
+*/
+
+struct record
+{
+    std::uint64_t sequence;
+    std::uint64_t payload[7];
+};
+
+const std::size_t stream_count = 2000000;
+const std::size_t round_trips = 100000;
+
+std::string ring_name(const char* name)
+{
+    return std::string("/cppspt_ipc_bench_") + name + "_" + std::to_string(::getpid());
+}
+
+bool read_fully(int fd, void* data, std::size_t size)
+{
+    unsigned char* bytes = static_cast<unsigned char*>(data);
+    while (size > 0)
+    {
+        ssize_t count = ::read(fd, bytes, size);
+        if (count <= 0)
+        {
+            return false;
+        }
+        bytes += count;
+        size -= static_cast<std::size_t>(count);
+    }
+    return true;
+}
+
+bool write_fully(int fd, const void* data, std::size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    while (size > 0)
+    {
+        ssize_t count = ::write(fd, bytes, size);
+        if (count <= 0)
+        {
+            return false;
+        }
+        bytes += count;
+        size -= static_cast<std::size_t>(count);
+    }
+    return true;
+}
+
+void stream_ring()
+{
+    std::string name = ring_name("stream");
+    cppspt::ipc_ring<record> ring;
+    ring.create(name.c_str(), 4096);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        cppspt::ipc_ring<record> consumer;
+        if (!consumer.open(name.c_str()))
+        {
+            std::_Exit(1);
+        }
+
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < stream_count; i++)
+        {
+            sum += consumer.wait_front().sequence;
+            consumer.pop_front();
+        }
+        std::_Exit(sum == stream_count * (stream_count - 1) / 2 ? 0 : 1);
+    }
+
+    for (std::size_t i = 0; i < stream_count; i++)
+    {
+        ring.push_with([i](cppspt::out<record> slot)
+        {
+            record r;
+            r.sequence = i;
+            r.payload[0] = i;
+            slot = r;
+        });
+    }
+
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / stream_count;
+    cppspt_bench::report(WEXITSTATUS(status) == 0 ? "stream, ipc_ring" : "stream, ipc_ring (FAILED)", ns);
+}
+
+void stream_socket()
+{
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        ::close(fds[0]);
+        std::uint64_t sum = 0;
+        record r;
+        for (std::size_t i = 0; i < stream_count; i++)
+        {
+            if (!read_fully(fds[1], &r, sizeof(r)))
+            {
+                std::_Exit(1);
+            }
+            sum += r.sequence;
+        }
+        std::_Exit(sum == stream_count * (stream_count - 1) / 2 ? 0 : 1);
+    }
+
+    ::close(fds[1]);
+    for (std::size_t i = 0; i < stream_count; i++)
+    {
+        record r;
+        r.sequence = i;
+        r.payload[0] = i;
+        write_fully(fds[0], &r, sizeof(r));
+    }
+    ::close(fds[0]);
+
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / stream_count;
+    cppspt_bench::report(WEXITSTATUS(status) == 0 ? "stream, unix socket" : "stream, unix socket (FAILED)", ns);
+}
+
+void ping_pong_ring()
+{
+    std::string ping_name = ring_name("ping");
+    std::string pong_name = ring_name("pong");
+    cppspt::ipc_ring<record> ping;
+    cppspt::ipc_ring<record> pong;
+    ping.create(ping_name.c_str(), 64);
+    pong.create(pong_name.c_str(), 64);
+
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        cppspt::ipc_ring<record> in_ring;
+        cppspt::ipc_ring<record> out_ring;
+        if (!in_ring.open(ping_name.c_str()) || !out_ring.open(pong_name.c_str()))
+        {
+            std::_Exit(1);
+        }
+
+        for (std::size_t i = 0; i < round_trips; i++)
+        {
+            record r;
+            in_ring.pop(r);
+            r.sequence++;
+            out_ring.push(r);
+        }
+        std::_Exit(0);
+    }
+
+    bool ok = true;
+    double ns = cppspt_bench::measure_ns(round_trips, [&](std::size_t i)
+    {
+        record r;
+        r.sequence = i;
+        ping.push(r);
+        pong.pop(r);
+        ok = ok && (r.sequence == i + 1);
+    });
+
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    cppspt_bench::report(ok && WEXITSTATUS(status) == 0 ? "round trip, ipc_ring" : "round trip, ipc_ring (FAILED)", ns);
+}
+
+void ping_pong_socket()
+{
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        ::close(fds[0]);
+        for (std::size_t i = 0; i < round_trips; i++)
+        {
+            record r;
+            if (!read_fully(fds[1], &r, sizeof(r)))
+            {
+                std::_Exit(1);
+            }
+            r.sequence++;
+            write_fully(fds[1], &r, sizeof(r));
+        }
+        std::_Exit(0);
+    }
+
+    ::close(fds[1]);
+    bool ok = true;
+    double ns = cppspt_bench::measure_ns(round_trips, [&](std::size_t i)
+    {
+        record r;
+        r.sequence = i;
+        write_fully(fds[0], &r, sizeof(r));
+        ok = read_fully(fds[0], &r, sizeof(r)) && ok && (r.sequence == i + 1);
+    });
+    ::close(fds[0]);
+
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    cppspt_bench::report(ok && WEXITSTATUS(status) == 0 ? "round trip, unix socket" : "round trip, unix socket (FAILED)", ns);
+}
+
+int main()
+{
+    stream_ring();
+    stream_socket();
+    ping_pong_ring();
+    ping_pong_socket();
+    return 0;
+}
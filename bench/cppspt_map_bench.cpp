@@ -0,0 +1,334 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_cache.hpp"
+#include "cppspt/cppspt_containers.hpp"
+
+#include "cppspt_bench.hpp"
+#include "cppspt_tracking.hpp"
+#include "simple_map.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined (__unix__) || defined (__APPLE__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define CPPSPT_MAP_BENCH_FORK
+#endif
+
+/*
+
+    The example's simple_map, std::map, std::unordered_map and the cppspt containers under string key-value workloads.
+    Every combination of:
+        workload: insert-heavy (90% puts), mixed (50%), lookup-heavy (10%)
+        keys: short (fit in the small string buffer) or long (48+ characters)
+        put arguments: lvalues (the map copies), or rvalues (the caller builds fresh strings, which the map can take)
+        distribution: uniform or Zipfian (skew 0.99) over the key set
+
+    Each combination is run in its own (forked) process, so the peak RSS is that run's alone.
+    Prints one JSON object per line:
+        {"container": ..., "workload": ..., "keys": ..., "args": ..., "distribution": ...,
+         "ops_per_sec": ..., "allocations_per_op": ..., "allocated_bytes_per_op": ..., "peak_rss_kb": ...}
+    (peak_rss_kb is -1 where it can't be measured)
+
+    Usage: cppspt_map_bench [key count] [operation count]
+
+*/
+
+struct options
+{
+    std::size_t key_count = 1024;
+    std::size_t op_count = 200000;
+};
+
+struct workload
+{
+    const char* name;
+    unsigned put_percent;
+};
+
+struct run_config
+{
+    workload load;
+    bool long_keys;
+    bool rvalue_args;
+    bool zipf;
+};
+
+struct operation
+{
+    std::uint32_t key;
+    bool put;
+};
+
+std::vector<std::string> make_keys(std::size_t count, bool long_keys)
+{
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string key = long_keys ? "service/region-eu-west/tenant/settings/profile/" : "k";
+        key += std::to_string(i);
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+std::vector<operation> make_operations(const options& opts, const run_config& config)
+{
+    std::mt19937 rng(1234);
+    std::vector<operation> ops(opts.op_count);
+
+    std::vector<double> cdf(opts.key_count);
+    double total = 0.0;
+    for (std::size_t i = 0; i < opts.key_count; i++)
+    {
+        total += config.zipf ? 1.0 / std::pow(static_cast<double>(i + 1), 0.99) : 1.0;
+        cdf[i] = total;
+    }
+
+    //Ranks are shuffled over the keys, so the popular keys aren't the first inserted
+    std::vector<std::uint32_t> rank_to_key(opts.key_count);
+    for (std::size_t i = 0; i < opts.key_count; i++)
+    {
+        rank_to_key[i] = static_cast<std::uint32_t>(i);
+    }
+    std::shuffle(rank_to_key.begin(), rank_to_key.end(), rng);
+
+    std::uniform_real_distribution<double> pick(0.0, total);
+    std::uniform_int_distribution<unsigned> percent(0, 99);
+    for (operation& op : ops)
+    {
+        std::size_t rank = static_cast<std::size_t>(std::lower_bound(cdf.begin(), cdf.end(), pick(rng)) - cdf.begin());
+        op.key = rank_to_key[std::min(rank, opts.key_count - 1)];
+        op.put = percent(rng) < config.load.put_percent;
+    }
+    return ops;
+}
+
+/*
+
+    The containers, behind a common put(key, value) (insert or replace) and find(key)
+
+*/
+
+class example_map
+{
+private:
+    simple_map<std::string, std::string> m_map;
+
+public:
+    explicit example_map(std::size_t) {}
+
+    void put(cppspt::in<std::string> key, cppspt::in<std::string> value) { m_map.put(std::move(key), std::move(value)); }
+
+    const std::string* find(const std::string& key)
+    {
+        auto it = m_map.find(key);
+        return it != m_map.end() ? &*it->second : nullptr;
+    }
+};
+
+//Without in parameters: a find, then an assignment or an emplace of the forwarded arguments
+template<typename Map>
+class std_map
+{
+private:
+    Map m_map;
+
+public:
+    explicit std_map(std::size_t) {}
+
+    template<typename K, typename V>
+    void put(K&& key, V&& value)
+    {
+        auto it = m_map.find(key);
+        if (it != m_map.end())
+        {
+            it->second = std::forward<V>(value);
+            return;
+        }
+        m_map.emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+
+    const std::string* find(const std::string& key)
+    {
+        auto it = m_map.find(key);
+        return it != m_map.end() ? &it->second : nullptr;
+    }
+};
+
+//std::unordered_map through cppspt::try_emplace_in, which constructs a new key & value once, from the ins
+class in_unordered_map
+{
+private:
+    std::unordered_map<std::string, std::string> m_map;
+
+public:
+    explicit in_unordered_map(std::size_t) {}
+
+    void put(cppspt::in<std::string> key, cppspt::in<std::string> value)
+    {
+        auto result = cppspt::try_emplace_in(m_map, std::move(key), value);
+        if (result.second)
+        {
+            return;
+        }
+
+        if (value.was_moved())
+        {
+            result.first->second = value.move_out();
+        }
+        else
+        {
+            result.first->second = value.unmoved_ref();
+        }
+    }
+
+    const std::string* find(const std::string& key)
+    {
+        auto it = m_map.find(key);
+        return it != m_map.end() ? &it->second : nullptr;
+    }
+};
+
+//A clock_cache large enough to hold every key, so it never evicts
+class cache_map
+{
+private:
+    cppspt::clock_cache<std::string, std::string> m_cache;
+
+public:
+    explicit cache_map(std::size_t key_count) : m_cache(key_count) {}
+
+    void put(cppspt::hashed_in<std::string> key, cppspt::in<std::string> value) { m_cache.put(std::move(key), std::move(value)); }
+
+    const std::string* find(const std::string& key) { return m_cache.find(key); }
+};
+
+long peak_rss_kb()
+{
+#if defined (CPPSPT_MAP_BENCH_FORK)
+    struct rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+#if defined (__APPLE__)
+    return static_cast<long>(usage.ru_maxrss / 1024);
+#else
+    return static_cast<long>(usage.ru_maxrss);
+#endif
+#else
+    return -1;
+#endif
+}
+
+template<typename Map>
+void run(const char* container, const options& opts, const run_config& config)
+{
+    std::vector<std::string> keys = make_keys(opts.key_count, config.long_keys);
+    std::vector<operation> ops = make_operations(opts, config);
+    const std::string value(32, 'v');
+
+    std::size_t found = 0;
+    cppspt_tracking::tracking_scope scope;
+    auto start = std::chrono::steady_clock::now();
+    {
+        Map map(opts.key_count);
+        for (const operation& op : ops)
+        {
+            if (op.put)
+            {
+                if (config.rvalue_args)
+                {
+                    map.put(std::string(keys[op.key]), std::string(value));
+                }
+                else
+                {
+                    map.put(keys[op.key], value);
+                }
+            }
+            else if (map.find(keys[op.key]) != nullptr)
+            {
+                found++;
+            }
+        }
+        cppspt_bench::do_not_optimize(map);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cppspt_tracking::counts counts = scope.delta();
+    cppspt_bench::do_not_optimize(found);
+
+    std::printf("{\"container\": \"%s\", \"workload\": \"%s\", \"keys\": \"%s\", \"args\": \"%s\", \"distribution\": \"%s\", "
+        "\"ops_per_sec\": %.0f, \"allocations_per_op\": %.4f, \"allocated_bytes_per_op\": %.1f, \"peak_rss_kb\": %ld}\n",
+        container, config.load.name, config.long_keys ? "long" : "short", config.rvalue_args ? "rvalue" : "lvalue", config.zipf ? "zipf" : "uniform",
+        opts.op_count / seconds,
+        static_cast<double>(counts.allocations) / opts.op_count,
+        static_cast<double>(counts.allocated_bytes) / opts.op_count,
+        peak_rss_kb());
+    std::fflush(stdout);
+}
+
+//Runs in a child process where possible, so each run's peak RSS starts from the same small baseline
+template<typename Map>
+void run_isolated(const char* container, const options& opts, const run_config& config)
+{
+#if defined (CPPSPT_MAP_BENCH_FORK)
+    std::fflush(stdout);
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        run<Map>(container, opts, config);
+        std::_Exit(0);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+#else
+    run<Map>(container, opts, config);
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+    if (argc > 1)
+    {
+        opts.key_count = static_cast<std::size_t>(std::strtoul(argv[1], nullptr, 10));
+    }
+    if (argc > 2)
+    {
+        opts.op_count = static_cast<std::size_t>(std::strtoul(argv[2], nullptr, 10));
+    }
+
+    const workload workloads[] = { { "insert-heavy", 90 }, { "mixed", 50 }, { "lookup-heavy", 10 } };
+    for (const workload& load : workloads)
+    {
+        for (int long_keys = 0; long_keys < 2; long_keys++)
+        {
+            for (int rvalue_args = 0; rvalue_args < 2; rvalue_args++)
+            {
+                for (int zipf = 0; zipf < 2; zipf++)
+                {
+                    run_config config = { load, long_keys != 0, rvalue_args != 0, zipf != 0 };
+                    run_isolated<example_map>("simple_map", opts, config);
+                    run_isolated<std_map<std::map<std::string, std::string>>>("std::map", opts, config);
+                    run_isolated<std_map<std::unordered_map<std::string, std::string>>>("std::unordered_map", opts, config);
+                    run_isolated<in_unordered_map>("std::unordered_map + try_emplace_in", opts, config);
+                    run_isolated<cache_map>("clock_cache", opts, config);
+                }
+            }
+        }
+    }
+    return 0;
+}
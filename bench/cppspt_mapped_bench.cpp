@@ -0,0 +1,136 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_mapped.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+
+    Startup cost of a large table of trivially copyable records:
+    rebuilding it in memory, versus reopening a mapped_uninit_array (cold & warm page cache)
+
+*/
+
+struct record
+{
+    double weight;
+    double score;
+    long long key;
+    int bucket;
+    int flags;
+};
+
+record build_record(std::size_t i)
+{
+    record r;
+    r.weight = std::sqrt(static_cast<double>(i));
+    r.score = std::sin(static_cast<double>(i)) * 100.0;
+    r.key = static_cast<long long>(i * 2654435761u);
+    r.bucket = static_cast<int>(i % 1024);
+    r.flags = static_cast<int>(i & 7);
+    return r;
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//Reads every record, as startup code using the table would
+double checksum(const cppspt::mapped_uninit_array<record>& table)
+{
+    double sum = 0;
+    for (std::size_t i = 0; i < table.size(); i++)
+    {
+        sum += table[i].score;
+    }
+    return sum;
+}
+
+//Drops the file from the page cache, so the next open is cold
+void evict(const char* path)
+{
+#if defined (POSIX_FADV_DONTNEED)
+    int file = ::open(path, O_RDONLY);
+    ::fdatasync(file);
+    ::posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(file);
+#else
+    (void)path;
+#endif
+}
+
+void measure_open(const char* name, const char* path, const cppspt::mapped_options& options, bool cold)
+{
+    if (cold)
+    {
+        evict(path);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    cppspt::mapped_uninit_array<record> table;
+    table.open(path, 0, options);
+    double open_ms = elapsed_ms(start);
+    double sum = checksum(table);
+    double total_ms = elapsed_ms(start);
+    cppspt_bench::do_not_optimize(sum);
+
+    std::printf("%-48s %12.3f ms open %12.3f ms open + read\n", name, open_ms, total_ms);
+}
+
+int main()
+{
+    const std::size_t size = 8 * 1024 * 1024;
+    const char* path = "/tmp/cppspt_mapped_bench.bin";
+    ::unlink(path);
+
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<record> table;
+        table.reserve(size);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            table.push_back(build_record(i));
+        }
+        cppspt_bench::do_not_optimize(table);
+        std::printf("%-48s %12.3f ms\n", "rebuild in memory", elapsed_ms(start));
+    }
+
+    {
+        auto start = std::chrono::steady_clock::now();
+        cppspt::mapped_uninit_array<record> table;
+        table.open(path, size);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            table.push_back(build_record(i));
+        }
+        table.sync();
+        std::printf("%-48s %12.3f ms\n", "build into mapped file (first run)", elapsed_ms(start));
+    }
+
+    cppspt::mapped_options lazy;
+    cppspt::mapped_options populate;
+    populate.populate = true;
+    cppspt::mapped_options huge;
+    huge.huge_pages = true;
+
+    measure_open("reopen cold, lazy", path, lazy, true);
+    measure_open("reopen cold, populate", path, populate, true);
+    measure_open("reopen warm, lazy", path, lazy, false);
+    measure_open("reopen warm, populate", path, populate, false);
+    measure_open("reopen warm, huge pages", path, huge, false);
+
+    ::unlink(path);
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <cstdio>
+#include <string>
+
+/*
+
+    Compares functions with several out parameters against plain references
+
+*/
+
+#if defined (_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+BENCH_NOINLINE void write_refs(std::size_t i, int& a, double& b, long long& c, float& d)
+{
+    a = static_cast<int>(i);
+    b = static_cast<double>(i) * 0.5;
+    c = static_cast<long long>(i) * 3;
+    d = static_cast<float>(i);
+}
+
+BENCH_NOINLINE void write_outs(std::size_t i, cppspt::out<int> a, cppspt::out<double> b, cppspt::out<long long> c, cppspt::out<float> d)
+{
+    a = static_cast<int>(i);
+    b = static_cast<double>(i) * 0.5;
+    c = static_cast<long long>(i) * 3;
+    d = static_cast<float>(i);
+}
+
+BENCH_NOINLINE void write_string_outs(std::size_t i, cppspt::out<std::string> a, cppspt::out<std::string> b)
+{
+    a = std::string(1 + (i & 7), 'a');
+    b = std::string(1 + (i & 7), 'b');
+}
+
+int main()
+{
+    const std::size_t iterations = 50000000;
+
+    std::printf("sizeof(out<int>) = %u, sizeof(out<std::string>) = %u\n",
+        static_cast<unsigned>(sizeof(cppspt::out<int>)), static_cast<unsigned>(sizeof(cppspt::out<std::string>)));
+
+    int a = 0; double b = 0; long long c = 0; float d = 0;
+
+    cppspt_bench::report("4 refs", cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+    {
+        write_refs(i, a, b, c, d);
+        cppspt_bench::do_not_optimize(a);
+    }));
+
+    cppspt_bench::report("4 outs (direct)", cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+    {
+        write_outs(i, a, b, c, d);
+        cppspt_bench::do_not_optimize(a);
+    }));
+
+    cppspt_bench::report("4 outs (uninit)", cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+    {
+        cppspt::uninit<int> ua; cppspt::uninit<double> ub; cppspt::uninit<long long> uc; cppspt::uninit<float> ud;
+        write_outs(i, ua, ub, uc, ud);
+        cppspt_bench::do_not_optimize(ua);
+    }));
+
+    std::string sa, sb;
+    cppspt_bench::report("2 string outs (direct)", cppspt_bench::measure_ns(iterations / 10, [&](std::size_t i)
+    {
+        write_string_outs(i, sa, sb);
+        cppspt_bench::do_not_optimize(sa);
+    }));
+
+    return 0;
+}
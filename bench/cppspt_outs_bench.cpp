@@ -0,0 +1,114 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_outs.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <cstdio>
+#include <string>
+#include <tuple>
+
+/*
+
+    Compares three ways of returning several results (an int, a string too long for the small buffer, and a double):
+    an out<T> for each, a returned std::tuple, and one outs<Ts...>.
+    Each is written into live variables (which are reused across calls), and into fresh uninits
+
+*/
+
+#if defined (_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+static const char* const long_name = "a name that is much too long for the small string buffer";
+
+BENCH_NOINLINE void parse_outs(std::size_t i, cppspt::out<int> id, cppspt::out<std::string> name, cppspt::out<double> weight)
+{
+    id = static_cast<int>(i);
+    name.assign_from([] { return std::string(long_name); });
+    weight = static_cast<double>(i) * 0.5;
+}
+
+BENCH_NOINLINE std::tuple<int, std::string, double> parse_tuple(std::size_t i)
+{
+    return std::tuple<int, std::string, double>(static_cast<int>(i), long_name, static_cast<double>(i) * 0.5);
+}
+
+BENCH_NOINLINE void parse_multi(std::size_t i, cppspt::outs<int, std::string, double> results)
+{
+    results.set<0>(static_cast<int>(i));
+    results.emplace<1>(long_name);
+    results.set<2>(static_cast<double>(i) * 0.5);
+}
+
+int main()
+{
+    const std::size_t iterations = 10000000;
+
+    std::printf("sizeof(out<int>) + sizeof(out<std::string>) + sizeof(out<double>) = %u, sizeof(outs<int, std::string, double>) = %u\n",
+        static_cast<unsigned>(sizeof(cppspt::out<int>) + sizeof(cppspt::out<std::string>) + sizeof(cppspt::out<double>)),
+        static_cast<unsigned>(sizeof(cppspt::outs<int, std::string, double>)));
+    std::printf("sizeof(out<bool>) + sizeof(out<char>) + sizeof(out<short>) = %u, sizeof(outs<bool, char, short>) = %u\n",
+        static_cast<unsigned>(sizeof(cppspt::out<bool>) + sizeof(cppspt::out<char>) + sizeof(cppspt::out<short>)),
+        static_cast<unsigned>(sizeof(cppspt::outs<bool, char, short>)));
+
+    {
+        std::printf("into live variables\n");
+        int id = 0;
+        std::string name;
+        double weight = 0.0;
+
+        cppspt_bench::report("  3 outs", cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+        {
+            parse_outs(i, id, name, weight);
+            cppspt_bench::do_not_optimize(name);
+        }));
+
+        cppspt_bench::report("  std::tie = tuple", cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+        {
+            std::tie(id, name, weight) = parse_tuple(i);
+            cppspt_bench::do_not_optimize(name);
+        }));
+
+        cppspt_bench::report("  outs", cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+        {
+            parse_multi(i, { id, name, weight });
+            cppspt_bench::do_not_optimize(name);
+        }));
+    }
+
+    {
+        std::printf("into fresh variables\n");
+
+        cppspt_bench::report("  3 outs, into uninits", cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+        {
+            cppspt::uninit<int> id;
+            cppspt::uninit<std::string> name;
+            cppspt::uninit<double> weight;
+            parse_outs(i, id, name, weight);
+            cppspt_bench::do_not_optimize(name);
+        }));
+
+        cppspt_bench::report("  tuple, moved into locals", cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+        {
+            std::tuple<int, std::string, double> results = parse_tuple(i);
+            std::string name = std::move(std::get<1>(results));
+            cppspt_bench::do_not_optimize(name);
+        }));
+
+        cppspt_bench::report("  outs, into uninits", cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+        {
+            cppspt::uninit<int> id;
+            cppspt::uninit<std::string> name;
+            cppspt::uninit<double> weight;
+            parse_multi(i, { id, name, weight });
+            cppspt_bench::do_not_optimize(name);
+        }));
+    }
+    return 0;
+}
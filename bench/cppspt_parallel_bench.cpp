@@ -0,0 +1,103 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_parallel.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+/*
+
+    Measures initialization time of a large uninit_array, and the bandwidth of later parallel readers,
+    when the array was initialized by a single thread versus by the (pinned) reader threads
+
+*/
+
+struct record
+{
+    double values[8];
+
+    record() {}
+    record(double seed)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            values[i] = seed + i;
+        }
+    }
+};
+
+double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//Returns GB/s of reading the whole array with the given options
+double read_bandwidth(cppspt::uninit_array<record>& values, const cppspt::parallel_options& options)
+{
+    std::atomic<long long> checksum(0);
+
+    auto start = std::chrono::steady_clock::now();
+    const int passes = 5;
+    for (int pass = 0; pass < passes; pass++)
+    {
+        values.parallel_for(options, [&](const cppspt::uninit<record>* first, const cppspt::uninit<record>* last)
+        {
+            double sum = 0;
+            for (; first != last; ++first)
+            {
+                sum += (*first)->values[0] + (*first)->values[7];
+            }
+            checksum += static_cast<long long>(sum);
+        });
+    }
+    double seconds = elapsed_ms(start) / 1000.0;
+    cppspt_bench::do_not_optimize(checksum);
+
+    return (passes * values.size() * sizeof(cppspt::uninit<record>)) / seconds / 1e9;
+}
+
+int main()
+{
+    //About 1.2GB of records
+    const std::size_t size = 16 * 1024 * 1024;
+
+    const cppspt::parallel_options single(1);
+    const cppspt::parallel_options parallel(0, true);
+
+    std::printf("threads: %u\n", parallel.thread_count());
+
+    {
+        auto start = std::chrono::steady_clock::now();
+        cppspt::uninit_array<record> values(size, single);
+        values.parallel_init(single, 1.0);
+        std::printf("%-48s %12.3f ms\n", "init: 1 thread", elapsed_ms(start));
+
+        std::printf("%-48s %12.3f GB/s\n", "read after 1 thread init", read_bandwidth(values, parallel));
+
+        start = std::chrono::steady_clock::now();
+        values.parallel_destroy(single);
+        std::printf("%-48s %12.3f ms\n", "destroy: 1 thread", elapsed_ms(start));
+    }
+
+    {
+        auto start = std::chrono::steady_clock::now();
+        cppspt::uninit_array<record> values(size, parallel);
+        values.parallel_init(parallel, 1.0);
+        std::printf("%-48s %12.3f ms\n", "init: all threads, pinned", elapsed_ms(start));
+
+        std::printf("%-48s %12.3f GB/s\n", "read after parallel init", read_bandwidth(values, parallel));
+
+        start = std::chrono::steady_clock::now();
+        values.parallel_destroy(parallel);
+        std::printf("%-48s %12.3f ms\n", "destroy: all threads, pinned", elapsed_ms(start));
+    }
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_queue.hpp"
+
+#include "cppspt_bench.hpp"
+#include "cppspt_tracking.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+
+    Throughput and latency of the uninit slot queues, against a ring of default constructed values that are assigned
+
+*/
+
+//The baseline: every slot holds a T, values are assigned in and out
+template<typename T>
+class assign_ring
+{
+private:
+    cppspt::detail::padded_index m_head;
+    cppspt::detail::padded_index m_tail;
+    std::unique_ptr<T[]> m_slots;
+    std::size_t m_mask;
+
+public:
+    explicit assign_ring(std::size_t capacity) : m_slots(new T[capacity]), m_mask(capacity - 1) {}
+
+    bool try_push(const T& val)
+    {
+        std::size_t tail = m_tail.value.load(std::memory_order_relaxed);
+        if (tail - m_head.value.load(std::memory_order_acquire) > m_mask)
+        {
+            return false;
+        }
+        m_slots[tail & m_mask] = val;
+        m_tail.value.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& dest)
+    {
+        std::size_t head = m_head.value.load(std::memory_order_relaxed);
+        if (head == m_tail.value.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        dest = std::move(m_slots[head & m_mask]);
+        m_head.value.store(head + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+//Reports ns & allocations per value, with one producer and one consumer
+template<typename Queue>
+void spsc_throughput(const char* name, const std::string& payload, std::size_t count)
+{
+    Queue q(1024);
+    cppspt_tracking::tracking_scope scope(true);
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread producer([&]
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            while (!q.try_push(payload))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::string dest;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        while (!q.try_pop(dest))
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    cppspt_bench::do_not_optimize(dest);
+
+    cppspt_bench::report(name, elapsed_ns(start) / count);
+    std::printf("%-48s %12.3f allocations/op\n", "", static_cast<double>(scope.delta().allocations) / count);
+}
+
+//ns per value, with threads producers and threads consumers
+double mpmc_throughput(unsigned threads, std::size_t count)
+{
+    cppspt::mpmc_queue<std::string> q(1024);
+    std::string payload(64, 'x');
+    std::size_t per_thread = count / threads;
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&]
+        {
+            for (std::size_t i = 0; i < per_thread; i++)
+            {
+                q.push(payload);
+            }
+        });
+        workers.emplace_back([&]
+        {
+            std::string dest;
+            for (std::size_t i = 0; i < per_thread; i++)
+            {
+                q.pop(dest);
+            }
+            cppspt_bench::do_not_optimize(dest);
+        });
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    return elapsed_ns(start) / (per_thread * threads);
+}
+
+//Round trip ns between two threads
+double spsc_latency(std::size_t count)
+{
+    cppspt::spsc_queue<int> ping(16);
+    cppspt::spsc_queue<int> pong(16);
+
+    std::thread echo([&]
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            int x;
+            ping.pop(x);
+            pong.push(x);
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; i++)
+    {
+        int x;
+        ping.push(static_cast<int>(i));
+        pong.pop(x);
+    }
+    double total = elapsed_ns(start);
+    echo.join();
+
+    return total / count;
+}
+
+int main()
+{
+    const std::size_t count = 2000000;
+
+    const std::string small = "small";
+    const std::string large(256, 'x');
+
+    spsc_throughput<assign_ring<std::string>>("spsc small string: assign ring", small, count);
+    spsc_throughput<cppspt::spsc_queue<std::string>>("spsc small string: spsc_queue", small, count);
+    spsc_throughput<assign_ring<std::string>>("spsc large string: assign ring", large, count);
+    spsc_throughput<cppspt::spsc_queue<std::string>>("spsc large string: spsc_queue", large, count);
+
+    unsigned hardware = std::thread::hardware_concurrency();
+    for (unsigned threads = 1; threads <= 8 && threads <= (hardware > 1 ? hardware / 2 : 1); threads *= 2)
+    {
+        char name[64];
+        std::snprintf(name, sizeof(name), "mpmc: %u producers, %u consumers", threads, threads);
+        cppspt_bench::report(name, mpmc_throughput(threads, count));
+    }
+
+    cppspt_bench::report("spsc round trip latency", spsc_latency(count / 10));
+
+    return 0;
+}
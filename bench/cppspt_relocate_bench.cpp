@@ -0,0 +1,182 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_relocate.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+
+    Growing (by push_back, without reserving), reallocating and erasing from the front of vectors of handles:
+    std::vector<T>, std::vector<uninit<T>>, and uninit_vector<T> with & without the handle opted in to trivial relocation
+
+*/
+
+//A handle with a user-written move & destructor, so the compiler can't see that relocating it is a copy of its bytes
+template<bool Relocatable>
+class handle
+{
+private:
+    int* m_resource;
+
+public:
+    explicit handle(int val) : m_resource(new int(val)) {}
+
+    handle(handle&& other) noexcept : m_resource(other.m_resource)
+    {
+        other.m_resource = nullptr;
+    }
+
+    handle& operator=(handle&& other) noexcept
+    {
+        delete m_resource;
+        m_resource = other.m_resource;
+        other.m_resource = nullptr;
+        return *this;
+    }
+
+    ~handle()
+    {
+        delete m_resource;
+    }
+
+    int get() const { return *m_resource; }
+};
+
+using relocatable_handle = handle<true>;
+using plain_handle = handle<false>;
+
+namespace cppspt
+{
+    template<>
+    struct is_trivially_relocatable<relocatable_handle> : std::true_type {};
+}
+
+const std::size_t grow_count = 4096;
+const int grow_repeats = 256;
+const std::size_t erase_count = 1 << 13;
+
+//Handles are created outside the timed loops, so only the containers' own moves are measured
+template<typename Handle>
+std::vector<Handle> make_handles(std::size_t count)
+{
+    std::vector<Handle> handles;
+    handles.reserve(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        handles.emplace_back(static_cast<int>(i));
+    }
+    return handles;
+}
+
+//Many small vectors, each grown one push_back at a time
+template<typename Vector, typename Handle, typename Push>
+void grow(const char* name, Push push)
+{
+    std::vector<std::vector<Handle>> sources;
+    for (int repeat = 0; repeat < grow_repeats; repeat++)
+    {
+        sources.push_back(make_handles<Handle>(grow_count));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::vector<Handle>& source : sources)
+    {
+        Vector vec;
+        for (Handle& h : source)
+        {
+            push(vec, h);
+        }
+        cppspt_bench::do_not_optimize(vec);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    cppspt_bench::report(name, ns / (grow_count * grow_repeats));
+}
+
+//One reallocation of a full vector to twice its capacity, per element
+template<typename Vector, typename Handle>
+void reallocate(const char* name, std::size_t count)
+{
+    const int repeats = 16;
+    double ns = 0.0;
+    for (int repeat = 0; repeat < repeats; repeat++)
+    {
+        Vector vec;
+        vec.reserve(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            vec.emplace_back(static_cast<int>(i));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        vec.reserve(count * 2);
+        ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        cppspt_bench::do_not_optimize(vec);
+    }
+
+    char label[96];
+    std::snprintf(label, sizeof(label), "  %s, %u handles", name, static_cast<unsigned>(count));
+    cppspt_bench::report(label, ns / (repeats * count));
+}
+
+template<typename Handle>
+void erase_std_vector(const char* name)
+{
+    std::vector<Handle> vec = make_handles<Handle>(erase_count);
+    double ns = cppspt_bench::measure_ns(erase_count, [&](std::size_t) { vec.erase(vec.begin()); });
+    cppspt_bench::report(name, ns);
+}
+
+template<typename Handle>
+void erase_uninit_vector(const char* name)
+{
+    std::vector<Handle> source = make_handles<Handle>(erase_count);
+    cppspt::uninit_vector<Handle> vec;
+    for (Handle& h : source)
+    {
+        vec.emplace_back(std::move(h));
+    }
+    double ns = cppspt_bench::measure_ns(erase_count, [&](std::size_t) { vec.erase(0); });
+    cppspt_bench::report(name, ns);
+}
+
+int main()
+{
+    auto push_std = [](std::vector<plain_handle>& vec, plain_handle& h) { vec.push_back(std::move(h)); };
+    auto push_std_uninit = [](std::vector<cppspt::uninit<plain_handle>>& vec, plain_handle& h)
+    {
+        vec.emplace_back();
+        vec.back().init(std::move(h));
+    };
+    auto push_plain = [](cppspt::uninit_vector<plain_handle>& vec, plain_handle& h) { vec.emplace_back(std::move(h)); };
+    auto push_relocatable = [](cppspt::uninit_vector<relocatable_handle>& vec, relocatable_handle& h) { vec.emplace_back(std::move(h)); };
+
+    std::printf("push_back %u handles without reserving, into %u vectors (ns per push)\n", static_cast<unsigned>(grow_count), static_cast<unsigned>(grow_repeats));
+    grow<std::vector<plain_handle>, plain_handle>("  std::vector<T>", push_std);
+    grow<std::vector<cppspt::uninit<plain_handle>>, plain_handle>("  std::vector<uninit<T>>", push_std_uninit);
+    grow<cppspt::uninit_vector<plain_handle>, plain_handle>("  uninit_vector<T>", push_plain);
+    grow<cppspt::uninit_vector<relocatable_handle>, relocatable_handle>("  uninit_vector<T>, relocatable", push_relocatable);
+
+    std::printf("reserve twice the capacity of a full vector (ns per element)\n");
+    const std::size_t sizes[] = { 1024, 65536, 1048576 };
+    for (std::size_t size : sizes)
+    {
+        reallocate<std::vector<plain_handle>, plain_handle>("std::vector<T>", size);
+        reallocate<cppspt::uninit_vector<plain_handle>, plain_handle>("uninit_vector<T>", size);
+        reallocate<cppspt::uninit_vector<relocatable_handle>, relocatable_handle>("uninit_vector<T>, relocatable", size);
+    }
+
+    std::printf("erase the first of %u handles, until empty\n", static_cast<unsigned>(erase_count));
+    erase_std_vector<plain_handle>("  std::vector<T>");
+    erase_uninit_vector<plain_handle>("  uninit_vector<T>");
+    erase_uninit_vector<relocatable_handle>("  uninit_vector<T>, relocatable");
+    return 0;
+}
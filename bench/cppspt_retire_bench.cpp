@@ -0,0 +1,117 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_retire.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+
+    Latency of a request handler that replaces a large value on each request:
+    destroying the old value in place, against retiring it to a background thread or to a drain at a safe point
+
+*/
+
+using payload = std::vector<std::string>;
+
+static payload make_payload(std::size_t strings)
+{
+    return payload(strings, std::string(64, 'p'));
+}
+
+//Runs rounds of requests, timing each one, and reports the median and 99th percentile
+template<typename Handle, typename SafePoint>
+void run(const char* name, Handle handle, SafePoint safe_point)
+{
+    const std::size_t rounds = 20;
+    const std::size_t requests = 256;
+    const std::size_t strings = 1000;
+
+    std::vector<double> latencies;
+    latencies.reserve(rounds * requests);
+
+    for (std::size_t round = 0; round < rounds; round++)
+    {
+        //The new values are built outside of the timed requests
+        std::vector<payload> incoming;
+        for (std::size_t i = 0; i < requests; i++)
+        {
+            incoming.push_back(make_payload(strings));
+        }
+
+        for (std::size_t i = 0; i < requests; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            handle(std::move(incoming[i]));
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+
+        safe_point();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    char label[96];
+    std::snprintf(label, sizeof(label), "%s, p50", name);
+    cppspt_bench::report(label, latencies[latencies.size() / 2]);
+    std::snprintf(label, sizeof(label), "%s, p99", name);
+    cppspt_bench::report(label, latencies[latencies.size() * 99 / 100]);
+}
+
+int main()
+{
+    {
+        cppspt::uninit<payload> state;
+        run("destroy in place", [&](payload&& val)
+        {
+            state = std::move(val);
+        }, [] {});
+    }
+
+    {
+        cppspt::retire_queue queue;
+        queue.start();
+        cppspt::retire_buffer<payload> buffer(queue);
+        cppspt::uninit<payload> state;
+        run("retire, background thread", [&](payload&& val)
+        {
+            buffer.assign(state, std::move(val));
+        }, [] {});
+    }
+
+    {
+        cppspt::retire_queue queue;
+        cppspt::retire_buffer<payload> buffer(queue);
+        cppspt::uninit<payload> state;
+        run("retire, drain between rounds", [&](payload&& val)
+        {
+            buffer.assign(state, std::move(val));
+        }, [&]
+        {
+            buffer.flush();
+            queue.drain();
+        });
+    }
+
+    {
+        //A queue that only holds 2 batches, so most retiring threads pay for their own batch
+        cppspt::retire_queue queue(cppspt::retire_options(64, 128));
+        cppspt::retire_buffer<payload> buffer(queue);
+        cppspt::uninit<payload> state;
+        run("retire, bounded, no drain", [&](payload&& val)
+        {
+            buffer.assign(state, std::move(val));
+        }, [] {});
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_parallel.hpp"
+#include "cppspt/cppspt_sharded.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+/*
+
+    A parallel sum, written into one result from 1 to 64 threads:
+        atomic: a fetch_add on a shared std::atomic per value
+        mutex: a shared out<T>, locked for every value
+        adjacent uninits: one uninit<T> per thread, packed next to each other (so neighbours share cache lines)
+        sharded_out: one uninit<T> per thread, each on its own cache line, reduced at the end
+
+    Every thread adds the same number of values; prints the nanoseconds per value, over all threads
+
+*/
+
+const std::uint64_t values_per_thread = 1 << 20;
+
+template<typename Body>
+double time_parallel(unsigned threads, Body body)
+{
+    auto start = std::chrono::steady_clock::now();
+    cppspt::run_parallel(cppspt::parallel_options(threads), body);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / (values_per_thread * threads);
+}
+
+double run_atomic(unsigned threads, std::uint64_t& total)
+{
+    std::atomic<std::uint64_t> sum(0);
+    double ns = time_parallel(threads, [&](unsigned index)
+    {
+        for (std::uint64_t i = 0; i < values_per_thread; i++)
+        {
+            sum.fetch_add(i ^ index, std::memory_order_relaxed);
+        }
+    });
+    total = sum.load();
+    return ns;
+}
+
+void add_locked(cppspt::out<std::uint64_t> sum, std::mutex& lock, std::uint64_t value)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    *sum += value;
+}
+
+double run_mutex(unsigned threads, std::uint64_t& total)
+{
+    std::mutex lock;
+    std::uint64_t sum = 0;
+    double ns = time_parallel(threads, [&](unsigned index)
+    {
+        for (std::uint64_t i = 0; i < values_per_thread; i++)
+        {
+            add_locked(sum, lock, i ^ index);
+        }
+    });
+    total = sum;
+    return ns;
+}
+
+//Each add is stored to memory (do_not_optimize), as it would be if the loop called out to other code
+double run_adjacent(unsigned threads, std::uint64_t& total)
+{
+    std::unique_ptr<cppspt::uninit<std::uint64_t>[]> slots(new cppspt::uninit<std::uint64_t>[threads]);
+    double ns = time_parallel(threads, [&](unsigned index)
+    {
+        cppspt::uninit<std::uint64_t>& slot = slots[index];
+        for (std::uint64_t i = 0; i < values_per_thread; i++)
+        {
+            if (!slot.was_initialized())
+            {
+                slot = i ^ index;
+            }
+            else
+            {
+                *slot += i ^ index;
+            }
+            cppspt_bench::do_not_optimize(slot);
+        }
+    });
+
+    total = 0;
+    for (unsigned i = 0; i < threads; i++)
+    {
+        total += *slots[i];
+    }
+    return ns;
+}
+
+double run_sharded(unsigned threads, std::uint64_t& total)
+{
+    cppspt::sharded_out<std::uint64_t> sum(threads);
+    double ns = time_parallel(threads, [&](unsigned index)
+    {
+        for (std::uint64_t i = 0; i < values_per_thread; i++)
+        {
+            sum.accumulate(index, i ^ index, std::plus<std::uint64_t>());
+            cppspt_bench::do_not_optimize(sum.local(index));
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    sum.reduce(total, std::plus<std::uint64_t>());
+    double reduce_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns + reduce_ns / (values_per_thread * threads);
+}
+
+int main()
+{
+    std::printf("%u hardware threads, %u values per thread (ns per value)\n",
+        std::thread::hardware_concurrency(), static_cast<unsigned>(values_per_thread));
+    std::printf("%8s %12s %12s %18s %12s\n", "threads", "atomic", "mutex", "adjacent uninits", "sharded_out");
+
+    const unsigned thread_counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    for (unsigned threads : thread_counts)
+    {
+        std::uint64_t totals[4];
+        double atomic_ns = run_atomic(threads, totals[0]);
+        double mutex_ns = run_mutex(threads, totals[1]);
+        double adjacent_ns = run_adjacent(threads, totals[2]);
+        double sharded_ns = run_sharded(threads, totals[3]);
+
+        bool agree = totals[0] == totals[1] && totals[1] == totals[2] && totals[2] == totals[3];
+        std::printf("%8u %12.3f %12.3f %18.3f %12.3f%s\n", threads, atomic_ns, mutex_ns, adjacent_ns, sharded_ns, agree ? "" : "  (sums differ!)");
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <cstdio>
+#include <string>
+#include <utility>
+
+/*
+
+    Code size per instantiated type
+
+    Exercises uninit, in and out for CPPSPT_SIZE_INSTANTIATIONS distinct types.
+    The size report (cppspt_size_report) builds this with 1 and with 64 types,
+    and divides the difference in .text bytes by the number of extra types.
+
+*/
+
+#if !defined (CPPSPT_SIZE_INSTANTIATIONS)
+#define CPPSPT_SIZE_INSTANTIATIONS 64
+#endif
+
+#if defined (_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+template<std::size_t N>
+struct payload
+{
+    std::string text;
+    std::size_t values[N + 1];
+};
+
+template<std::size_t N>
+BENCH_NOINLINE void produce(cppspt::out<payload<N>> result, cppspt::in<payload<N>> source)
+{
+    result = std::move(source);
+}
+
+template<std::size_t N>
+BENCH_NOINLINE std::size_t exercise(std::size_t i)
+{
+    payload<N> p;
+    p.text = "payload";
+    p.values[0] = i;
+
+    cppspt::uninit<payload<N>> value;
+    value = p;
+    value = std::move(p);
+
+    cppspt::uninit<payload<N>> copy(value);
+    copy = value;
+
+    payload<N> result;
+    produce<N>(result, *value);
+
+    cppspt::uninit<payload<N>> target;
+    produce<N>(target, std::move(*copy));
+
+    return value->text.size() + result.values[0] + target->values[0];
+}
+
+template<std::size_t ... Ns>
+std::size_t exercise_all(std::size_t i, std::index_sequence<Ns...>)
+{
+    std::size_t sum = 0;
+    int expand[] = { 0, ((sum += exercise<Ns>(i)), 0)... };
+    (void)expand;
+    return sum;
+}
+
+int main()
+{
+    const std::size_t iterations = 100000;
+
+    std::size_t sum = 0;
+    double ns = cppspt_bench::measure_ns(iterations, [&](std::size_t i)
+    {
+        sum += exercise_all(i, std::make_index_sequence<CPPSPT_SIZE_INSTANTIATIONS>());
+    });
+    cppspt_bench::do_not_optimize(sum);
+
+    char label[96];
+    std::snprintf(label, sizeof(label), "exercise %u types", static_cast<unsigned>(CPPSPT_SIZE_INSTANTIATIONS));
+    cppspt_bench::report(label, ns);
+    return 0;
+}
@@ -0,0 +1,25 @@
+# Copyright(C) 2020 Henry Bullingham
+# This file is subject to the license terms in the LICENSE file
+# found in the top - level directory of this distribution.
+
+# Prints the .text bytes per instantiated type, from the size benchmark built for 1 (ONE) and for COUNT (MANY) types
+# Usage: cmake -DSIZE_TOOL=size -DONE=<exe> -DMANY=<exe> -DCOUNT=64 -P cppspt_size_report.cmake
+
+function(cppspt_text_size exe result)
+    execute_process(COMMAND ${SIZE_TOOL} -A ${exe} OUTPUT_VARIABLE sections RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "CPPSPT: ${SIZE_TOOL} failed on ${exe}")
+    endif()
+    if(NOT sections MATCHES "\n\\.text[ \t]+([0-9]+)")
+        message(FATAL_ERROR "CPPSPT: no .text section in ${exe}")
+    endif()
+    set(${result} ${CMAKE_MATCH_1} PARENT_SCOPE)
+endfunction()
+
+cppspt_text_size(${ONE} one_size)
+cppspt_text_size(${MANY} many_size)
+math(EXPR per_type "(${many_size} - ${one_size}) / (${COUNT} - 1)")
+
+message(".text with 1 type: ${one_size} bytes")
+message(".text with ${COUNT} types: ${many_size} bytes")
+message(".text per instantiated type: ${per_type} bytes")
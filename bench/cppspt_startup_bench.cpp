@@ -0,0 +1,91 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_startup.hpp"
+
+#include "cppspt_bench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+/*
+
+    Startup time of a dozen expensive globals (sorted tables, each built from a random seed and maybe another table),
+    constructed serially against across every hardware thread, with the per-global times of the parallel run
+
+*/
+
+using table = std::vector<std::uint32_t>;
+
+static table build_table(std::uint32_t seed, const table* base)
+{
+    std::mt19937 rng(seed);
+    table values(400000);
+    for (std::uint32_t& val : values)
+    {
+        val = rng();
+    }
+    if (base != nullptr)
+    {
+        for (std::size_t i = 0; i < values.size(); i++)
+        {
+            values[i] ^= (*base)[i % base->size()];
+        }
+    }
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+static cppspt::startup_global<table> g_words("words", {}, [](cppspt::out<table> dest) { dest = build_table(1, nullptr); });
+static cppspt::startup_global<table> g_stems("stems", { "words" }, [](cppspt::out<table> dest) { dest = build_table(2, &*g_words); });
+static cppspt::startup_global<table> g_synonyms("synonyms", { "words", "stems" }, [](cppspt::out<table> dest) { dest = build_table(3, &*g_stems); });
+static cppspt::startup_global<table> g_units("units", {}, [](cppspt::out<table> dest) { dest = build_table(4, nullptr); });
+static cppspt::startup_global<table> g_currencies("currencies", {}, [](cppspt::out<table> dest) { dest = build_table(5, nullptr); });
+static cppspt::startup_global<table> g_rates("rates", { "currencies" }, [](cppspt::out<table> dest) { dest = build_table(6, &*g_currencies); });
+static cppspt::startup_global<table> g_grammar("grammar", {}, [](cppspt::out<table> dest) { dest = build_table(7, nullptr); });
+static cppspt::startup_global<table> g_parser("parser", { "grammar", "units" }, [](cppspt::out<table> dest) { dest = build_table(8, &*g_grammar); });
+static cppspt::startup_global<table> g_geo("geo", {}, [](cppspt::out<table> dest) { dest = build_table(9, nullptr); });
+static cppspt::startup_global<table> g_timezones("timezones", { "geo" }, [](cppspt::out<table> dest) { dest = build_table(10, &*g_geo); });
+static cppspt::startup_global<table> g_routes("routes", { "geo" }, [](cppspt::out<table> dest) { dest = build_table(11, &*g_geo); });
+static cppspt::startup_global<table> g_index("index", { "synonyms", "parser", "rates", "timezones" }, [](cppspt::out<table> dest) { dest = build_table(12, &*g_synonyms); });
+
+double run_startup(const cppspt::parallel_options& options)
+{
+    cppspt::startup_registry::global().destroy_all();
+
+    auto start = std::chrono::steady_clock::now();
+    cppspt::startup_registry::global().run(options);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    double serial = run_startup(cppspt::parallel_options(1));
+    double parallel = run_startup(cppspt::parallel_options());
+
+    char label[96];
+    std::printf("%-48s %12.3f ms\n", "startup, 1 thread", serial);
+    std::snprintf(label, sizeof(label), "startup, %u threads", cppspt::parallel_options().thread_count());
+    std::printf("%-48s %12.3f ms\n", label, parallel);
+
+    //A use after startup is only an atomic load
+    double ns = cppspt_bench::measure_ns(10000000, [](std::size_t)
+    {
+        cppspt_bench::do_not_optimize(g_index->front());
+    });
+    cppspt_bench::report("get() once constructed", ns);
+
+    std::printf("\nper global:\n");
+    for (const cppspt::startup_timing& timing : cppspt::startup_registry::global().timings())
+    {
+        std::printf("  %-46s %12.3f ms%s\n", timing.name, timing.nanoseconds / 1e6, timing.forced ? " (forced)" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_queue.hpp"
+#include "cppspt/cppspt_task.hpp"
+
+#include "cppspt_bench.hpp"
+#include "cppspt_tracking.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+/*
+
+    Enqueue latency: building a task for f(name, count) and pushing it onto an mpmc_queue, with name a 40 character string
+    passed as an lvalue (which every design must copy) and as an rvalue (which it can move)
+
+        cppspt::task: make_task(f, name, count), arguments captured as in parameters, stored inline
+        std::function<void()>: a lambda with init-captures (copying or moving name), on the heap past libstdc++'s 16 byte buffer
+        std::packaged_task<void()>: the same lambda, plus its shared state
+
+    The queue is drained (running every task) between batches, outside the timing.
+    Each enqueue is timed on its own, so the times include a steady_clock read; prints the average, median & 99th percentile,
+    and the heap allocations per enqueue. Then the same for cppspt::thread_pool::submit, with one worker
+
+*/
+
+#if defined (_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+const std::size_t batch_size = 1024;
+const std::size_t batch_count = 200;
+
+static std::size_t s_consumed = 0;
+
+BENCH_NOINLINE void consume(const std::string& name, int count)
+{
+    s_consumed += name.size() + static_cast<std::size_t>(count);
+}
+
+struct enqueue_stats
+{
+    double average_ns = 0;
+    double median_ns = 0;
+    double p99_ns = 0;
+    double allocations = 0;
+};
+
+//Times enqueue(name, i) for each of a batch, then drain() outside the timing
+template<typename Enqueue, typename Drain>
+enqueue_stats measure(bool move_name, Enqueue enqueue, Drain drain)
+{
+    const std::string source(40, 'n');
+    std::vector<double> times;
+    times.reserve(batch_size * batch_count);
+
+    //Names to move from are made before the timing
+    std::vector<std::string> names(batch_size);
+
+    cppspt_tracking::counts allocations;
+    for (std::size_t batch = 0; batch < batch_count; batch++)
+    {
+        std::fill(names.begin(), names.end(), source);
+
+        cppspt_tracking::tracking_scope scope;
+        for (std::size_t i = 0; i < batch_size; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            if (move_name)
+            {
+                enqueue(std::move(names[i]), static_cast<int>(i));
+            }
+            else
+            {
+                enqueue(source, static_cast<int>(i));
+            }
+            times.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        }
+        allocations.allocations += scope.delta().allocations;
+
+        drain();
+    }
+
+    enqueue_stats stats;
+    for (double time : times)
+    {
+        stats.average_ns += time;
+    }
+    stats.average_ns /= times.size();
+
+    std::sort(times.begin(), times.end());
+    stats.median_ns = times[times.size() / 2];
+    stats.p99_ns = times[times.size() * 99 / 100];
+    stats.allocations = static_cast<double>(allocations.allocations) / times.size();
+    return stats;
+}
+
+void print(const char* name, const enqueue_stats& stats)
+{
+    std::printf("%-40s %10.1f %10.1f %10.1f %14.2f\n", name, stats.average_ns, stats.median_ns, stats.p99_ns, stats.allocations);
+}
+
+template<typename Task>
+void drain(cppspt::mpmc_queue<Task>& queue)
+{
+    cppspt::uninit<Task> next;
+    while (queue.try_pop(next))
+    {
+        (*next)();
+        next.reset();
+    }
+}
+
+void run_task(const char* name, bool move_name)
+{
+    cppspt::mpmc_queue<cppspt::task> queue(batch_size);
+    print(name, measure(move_name, [&](cppspt::in<std::string> value, int count)
+    {
+        queue.try_push(cppspt::make_task(&consume, value, count));
+    }, [&] { drain(queue); }));
+}
+
+void run_function(const char* name, bool move_name)
+{
+    cppspt::mpmc_queue<std::function<void()>> queue(batch_size);
+    print(name, measure(move_name, [&](cppspt::in<std::string> value, int count)
+    {
+        if (value.was_moved())
+        {
+            queue.try_push(std::function<void()>([v = value.move_out(), count] { consume(v, count); }));
+        }
+        else
+        {
+            queue.try_push(std::function<void()>([v = *value, count] { consume(v, count); }));
+        }
+    }, [&] { drain(queue); }));
+}
+
+void run_packaged_task(const char* name, bool move_name)
+{
+    cppspt::mpmc_queue<std::packaged_task<void()>> queue(batch_size);
+    print(name, measure(move_name, [&](cppspt::in<std::string> value, int count)
+    {
+        if (value.was_moved())
+        {
+            queue.try_push(std::packaged_task<void()>([v = value.move_out(), count] { consume(v, count); }));
+        }
+        else
+        {
+            queue.try_push(std::packaged_task<void()>([v = *value, count] { consume(v, count); }));
+        }
+    }, [&] { drain(queue); }));
+}
+
+void run_pool(const char* name, bool move_name)
+{
+    cppspt::thread_pool pool(1, batch_size);
+    print(name, measure(move_name, [&](cppspt::in<std::string> value, int count)
+    {
+        pool.submit(&consume, value, count);
+    }, [&] { pool.wait(); }));
+}
+
+int main()
+{
+    std::printf("%u batches of %u enqueues, 40 character name\n", static_cast<unsigned>(batch_count), static_cast<unsigned>(batch_size));
+    std::printf("%-40s %10s %10s %10s %14s\n", "", "avg ns", "p50 ns", "p99 ns", "allocs/enqueue");
+
+    run_task("cppspt::task, lvalue", false);
+    run_task("cppspt::task, rvalue", true);
+    run_function("std::function, lvalue", false);
+    run_function("std::function, rvalue", true);
+    run_packaged_task("std::packaged_task, lvalue", false);
+    run_packaged_task("std::packaged_task, rvalue", true);
+    run_pool("thread_pool::submit, lvalue", false);
+    run_pool("thread_pool::submit, rvalue", true);
+
+    cppspt_bench::do_not_optimize(s_consumed);
+    return 0;
+}
@@ -0,0 +1,71 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_EXAMPLES_SIMPLE_MAP_HPP)
+#define CPPSPT_EXAMPLES_SIMPLE_MAP_HPP
+
+/*
+
+    The example map: a vector of uninit key-value pairs, searched linearly.
+    Shared by the example and the container benchmarks (see bench/cppspt_map_bench.cpp for where it falls over)
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+template<typename K, typename V>
+class simple_map
+{
+public:
+    using pair_type = std::pair<cppspt::uninit<K>, cppspt::uninit<V>>;
+
+    using iterator = typename std::vector<pair_type>::iterator;
+
+private:
+    std::vector<pair_type> m_pairs;
+
+public:
+
+    void put(cppspt::in<K> key, cppspt::in<V> value)
+    {
+        auto it = find(key);
+        if (it != end())
+        {
+            it->second = std::move(value);
+            return;
+        }
+
+        m_pairs.emplace_back();
+        m_pairs.back().first = std::move(key);
+        m_pairs.back().second = std::move(value);
+    }
+
+    iterator begin()
+    {
+        return m_pairs.begin();
+    }
+
+    iterator end()
+    {
+        return m_pairs.end();
+    }
+
+    iterator find(cppspt::in<K> key)
+    {
+        return std::find_if(begin(), end(), [&](const pair_type& p) { return *p.first == *key; });
+    }
+
+    void erase(iterator it)
+    {
+        m_pairs.erase(it);
+    }
+};
+
+#endif //CPPSPT_EXAMPLES_SIMPLE_MAP_HPP
@@ -7,21 +7,77 @@
 #if !defined (CPPSPT_INCLUDE_CPPSPT_HPP)
 #define CPPSPT_INCLUDE_CPPSPT_HPP
 
+//Branch hints, and attributes for code that is rarely run
+#if defined (__GNUC__) || defined (__clang__)
+#define CPPSPT_LIKELY(x_) __builtin_expect(!!(x_), 1)
+#define CPPSPT_UNLIKELY(x_) __builtin_expect(!!(x_), 0)
+#define CPPSPT_COLD __attribute__((noinline, cold))
+#elif defined (_MSC_VER)
+#define CPPSPT_LIKELY(x_) (x_)
+#define CPPSPT_UNLIKELY(x_) (x_)
+#define CPPSPT_COLD __declspec(noinline)
+#else
+#define CPPSPT_LIKELY(x_) (x_)
+#define CPPSPT_UNLIKELY(x_) (x_)
+#define CPPSPT_COLD
+#endif
+
+//The state asserts check (such as whether an out was written) is kept unless CPPSPT_DISABLE_ASSERTS is defined.
+//This changes the size of types, so it must not depend on NDEBUG, which may differ between translation units
 #if !defined (CPPSPT_DISABLE_ASSERTS)
-#include <cassert>
+#define CPPSPT_ASSERT_STATE
+#endif
+
+//Asserts are on unless CPPSPT_DISABLE_ASSERTS (or, like assert, NDEBUG) is defined.
+//A failure calls one shared function with the expression, file & line (assert's message names the function,
+//which for a template is different for every T)
+#if !defined (CPPSPT_DISABLE_ASSERTS) && !defined (NDEBUG)
+
+#define CPPSPT_ASSERTS_ENABLED
+
+#define CPPSPT_ASSERT(x_) (CPPSPT_LIKELY(x_) ? (void)0 : ::cppspt::detail::assert_failure(#x_, __FILE__, __LINE__))
 
-#define CPPSPT_ASSERT(x_) assert(x_)
 #else
 
-#define CPPSPT_ASSERT(x_) 
+#define CPPSPT_ASSERT(x_) ((void)0)
+
+#endif
+
+//Always checked, even with asserts disabled: for conditions where carrying on would be undefined behaviour
+#define CPPSPT_VERIFY(x_) (CPPSPT_LIKELY(x_) ? (void)0 : ::cppspt::detail::assert_failure(#x_, __FILE__, __LINE__))
 
+//The language version (MSVC only reports it in __cplusplus with /Zc:__cplusplus)
+#if defined (_MSVC_LANG)
+#define CPPSPT_CPLUSPLUS _MSVC_LANG
+#else
+#define CPPSPT_CPLUSPLUS __cplusplus
 #endif
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
 #include <type_traits>
 #include <ostream>
+#include <utility>
 
 namespace cppspt
 {
+    namespace detail
+    {
+        //Reports a failed assert and aborts. Shared by every assert, and kept out of line
+        CPPSPT_COLD inline void assert_failure(const char* expression, const char* file, int line)
+        {
+            std::fprintf(stderr, "CPPSPT: assertion failed: %s (%s:%d)\n", expression, file, line);
+            std::abort();
+        }
+
+        //The size of a cache line, for keeping data written by different threads (or processes) apart.
+        //Shared by every header, as a process & its shared memory peers must agree on it
+        static const std::size_t cache_line_size = 64;
+    }
+
     /*
     
         Standard parameter types: in, out, inout, move and forward
@@ -61,7 +117,7 @@ namespace cppspt
     using in = detail::in<T>;
 
     /// <summary>
-    /// A write-only output parameter. Captures a direct reference or a reference to an uninitialized T
+    /// A write-only output parameter. Captures a direct reference, or a reference to an uninitialized T (uninit or uninit_box)
     /// </summary>
     /// <typeparam name="T"></typeparam>
     template<typename T>
@@ -124,6 +180,10 @@ namespace cppspt
     template<typename T, typename std::enable_if< std::is_copy_constructible<T>::value && !std::is_move_constructible<T>::value, int>::type = 2 >
     const T& resolve(inout<in<T>> param);
 
+    //An in parameter passed on with std::move resolves the same as one passed by name
+    template<typename T>
+    auto resolve(in<T>&& param) -> decltype(resolve(static_cast<in<T>&>(param)));
+
 #define cppspt_declare_copy_constructors_from_in(_type)\
 public:\
     _type(const _type& other) : _type(cppspt::in<_type>(other)){}\
@@ -139,66 +199,41 @@ public:\
         class in final
         {
         private:
-            /*
-                The purpose of this struct is twofold:
-                a) it allows us to put an rvalue reference in a union
-                b) it allows us to construct an rvalue reference
-            */
-            struct move_type_container
-            {
-                move<T> val;
-                move_type_container(move<T> ref) : val(std::move(ref)) { }
-            };
-
-            union {
-                move_type_container m_temp;     //Captures a move
-                const T* m_ptr;                 //Captures a reference (as a ptr)
-            };
+            //Both captures are kept as a pointer, so reading never branches on how the value was captured
+            //(A captured move points at the caller's rvalue, which is not const)
+            const T* m_ptr;
             const bool m_was_moved;
 
             const T& to_ref() const
             {
-                return (m_was_moved) ? m_temp.val : *m_ptr;
+                return *m_ptr;
             }
 
         public:
 
             in(const_ref<T> val) :
-                m_was_moved(false),
-                m_ptr(&val)
+                m_ptr(&val),
+                m_was_moved(false)
             {
             }
 
             in(move<T> val) :
-                m_was_moved(true),
-                m_temp(std::move(val))
+                m_ptr(&val),
+                m_was_moved(true)
             {
             }
 
+            //A copy of an in only borrows the value
             in(const_ref<in<T>> other) :
+                m_ptr(other.m_ptr),
                 m_was_moved(false)
             {
-                if (other.m_was_moved)
-                {
-                    m_ptr = &other.m_temp.val;
-                }
-                else
-                {
-                    m_ptr = other.m_ptr;
-                }
             }
 
             in(move<in<T>> other) :
+                m_ptr(other.m_ptr),
                 m_was_moved(other.m_was_moved)
             {
-                if (other.m_was_moved)
-                {
-                    new (&m_temp) move_type_container(std::move(other.m_temp.val));
-                }
-                else
-                {
-                    m_ptr = other.m_ptr;
-                }
             }
 
             //No assignment operators
@@ -223,10 +258,79 @@ public:\
             //Need these to write good constructors
             bool was_moved() const { return m_was_moved; }
             const T & unmoved_ref() { return *m_ptr; }
-            move<T> move_out() { return std::move(m_temp.val); }
+            move<T> move_out() { return std::move(*const_cast<T*>(m_ptr)); }
+
+            friend std::ostream& operator<< (std::ostream& out, const in<T>& val)
+            {
+                return out << val.to_ref();
+            }
         };
 
 
+        /*
+
+            Constructing & assigning from an in: copies unless the value was moved.
+            A solely move constructible (or assignable) type can only come from a moved in
+
+        */
+
+        template<typename T, typename std::enable_if< std::is_copy_constructible<T>::value, int>::type = 0 >
+        void construct_from_in(void* where, in<T>& val)
+        {
+            if (val.was_moved())
+            {
+                new (where) T(val.move_out());
+            }
+            else
+            {
+                new (where) T(val.unmoved_ref());
+            }
+        }
+
+        template<typename T, typename std::enable_if< !std::is_copy_constructible<T>::value, int>::type = 0 >
+        void construct_from_in(void* where, in<T>& val)
+        {
+            CPPSPT_VERIFY(val.was_moved() && "Copying a solely move constructible type!");
+
+            new (where) T(val.move_out());
+        }
+
+        template<typename T, typename std::enable_if< std::is_copy_constructible<T>::value, int>::type = 0 >
+        T* new_from_in(in<T>& val)
+        {
+            return val.was_moved() ? new T(val.move_out()) : new T(val.unmoved_ref());
+        }
+
+        template<typename T, typename std::enable_if< !std::is_copy_constructible<T>::value, int>::type = 0 >
+        T* new_from_in(in<T>& val)
+        {
+            CPPSPT_VERIFY(val.was_moved() && "Copying a solely move constructible type!");
+
+            return new T(val.move_out());
+        }
+
+        template<typename T, typename std::enable_if< std::is_copy_assignable<T>::value, int>::type = 0 >
+        void assign_from_in(T& target, in<T>& val)
+        {
+            if (val.was_moved())
+            {
+                target = val.move_out();
+            }
+            else
+            {
+                target = val.unmoved_ref();
+            }
+        }
+
+        template<typename T, typename std::enable_if< !std::is_copy_assignable<T>::value, int>::type = 0 >
+        void assign_from_in(T& target, in<T>& val)
+        {
+            CPPSPT_VERIFY(val.was_moved() && "Copying a solely move assignable type!");
+
+            target = val.move_out();
+        }
+
+
 
         /*
         
@@ -258,14 +362,7 @@ public:\
 
             uninit(in<T> value) : m_was_initialized(true)
             {
-                if (value.was_moved())
-                {
-                    new (&m_val) T(value.move_out());
-                }
-                else
-                {
-                    new (&m_val) T(value.unmoved_ref());
-                }
+                construct_from_in(&m_val, value);
             }
 
             //We have to manually specify the copy constructors & move assignment, because 
@@ -279,7 +376,8 @@ public:\
                 }
             }
 
-            uninit(move<uninit<T>> other) :
+            //noexcept when T's move is, so that std::vector moves (rather than copies) uninits when it grows
+            uninit(move<uninit<T>> other) noexcept(std::is_nothrow_move_constructible<T>::value) :
                 m_was_initialized(other.m_was_initialized)
             {
                 if (other.m_was_initialized)
@@ -292,25 +390,11 @@ public:\
             {
                 if (m_was_initialized)
                 {
-                    if (val.was_moved())
-                    {
-                        m_val = val.move_out();
-                    }
-                    else
-                    {
-                        m_val = val.unmoved_ref();
-                    }
+                    assign_from_in(m_val, val);
                 }
                 else
                 {
-                    if (val.was_moved())
-                    {
-                        new (&m_val) T(val.move_out());
-                    }
-                    else
-                    {
-                        new (&m_val) T(val.unmoved_ref());
-                    }
+                    construct_from_in(&m_val, val);
                     m_was_initialized = true;
                 }
                 return *this;
@@ -318,68 +402,38 @@ public:\
 
             uninit& operator=(const_ref<uninit<T>> other)
             {
-                if (&other == this)
+                if (CPPSPT_UNLIKELY(&other == this))
                 {
-                    return;
+                    return *this;
                 }
 
-                if (m_was_initialized)
+                if (other.m_was_initialized)
                 {
-                    if (other.m_was_initialized)
-                    {
-                        m_val = other.m_val;
-                    }
-                    else
-                    {
-                        m_val.~T();
-                    }
+                    *this = in<T>(other.m_val);
                 }
                 else
                 {
-                    if (other.m_was_initialized)
-                    {
-                        new (&m_val) T(other.m_val);
-                    }
-                    else
-                    {
-                        //Do nothing (both uninitialized)
-                    }
+                    reset();
                 }
-
-                m_was_initialized = other.m_was_initialized;
+                return *this;
             }
 
-            uninit& operator=(move<uninit<T>> other)
+            uninit& operator=(move<uninit<T>> other) noexcept(std::is_nothrow_move_constructible<T>::value && std::is_nothrow_move_assignable<T>::value)
             {
-                if (&other == this)
+                if (CPPSPT_UNLIKELY(&other == this))
                 {
-                    return;
+                    return *this;
                 }
 
-                if (m_was_initialized)
+                if (other.m_was_initialized)
                 {
-                    if (other.m_was_initialized)
-                    {
-                        m_val = std::move(other.m_val);
-                    }
-                    else
-                    {
-                        m_val.~T();
-                    }
+                    *this = in<T>(std::move(other.m_val));
                 }
                 else
                 {
-                    if (other.m_was_initialized)
-                    {
-                        new (&m_val) T(std::move(other.m_val));
-                    }
-                    else
-                    {
-                        //Do nothing (both uninitialized)
-                    }
+                    reset();
                 }
-
-                m_was_initialized = other.m_was_initialized;
+                return *this;
             }
 
             void init()
@@ -392,15 +446,38 @@ public:\
             }
 
             template<typename ... Args>
-            void init(Args ... args)
+            void init(Args&& ... args)
             {
                 if (!m_was_initialized)
                 {
-                    new (&m_val)T(std::forward<Args...>(args...));
+                    new (&m_val)T(std::forward<Args>(args)...);
                     m_was_initialized = true;
                 }
             }
 
+            /// <summary>
+            /// Replaces the value (if any) with the T returned by factory(). The call is made inside the placement new,
+            /// so from C++17 the result is constructed directly in this storage: no temporary, no move, even if T can't be moved
+            /// </summary>
+            template<typename F>
+            T& init_with(F&& factory)
+            {
+                reset();
+                new (&m_val)T(std::forward<F>(factory)());
+                m_was_initialized = true;
+                return m_val;
+            }
+
+            //Destroys the value (if any), leaving the uninit uninitialized
+            void reset()
+            {
+                if (m_was_initialized)
+                {
+                    m_val.~T();
+                    m_was_initialized = false;
+                }
+            }
+
             operator const T& () const
             {
                 CPPSPT_ASSERT(m_was_initialized && "Attempting to read from uninit value!");
@@ -441,7 +518,8 @@ public:\
             }
 
             public:
-                friend std::ostream& operator<< (std::ostream& out, uninit<T> val)
+                //Reads through a const reference, so printing never copies the value
+                friend std::ostream& operator<< (std::ostream& out, const uninit<T>& val)
                 {
                     if (val.was_initialized())
                     {
@@ -452,6 +530,112 @@ public:\
         };
 
 
+        /*
+        
+            Output target: a pointer to a T, to an uninit<T>, to the heap pointer of a boxed value
+            (Which is null until the first write allocates the value), or to a sink
+
+            When T is at least 4-byte aligned, so are uninit<T> and T*, and the target kind is packed into
+            the low 2 bits of the pointer. Otherwise, the kind is stored beside the pointer.
+
+        */
+
+        enum class out_kind : unsigned char
+        {
+            direct = 0,
+            uninitialized = 1,
+            boxed = 2,
+            sink = 3
+        };
+
+        /// <summary>
+        /// The heap pointer of a boxed value, as an out target
+        /// </summary>
+        template<typename T>
+        struct box_slot
+        {
+            T** ptr;
+        };
+
+        /// <summary>
+        /// Storage for a T whose initialized flag is kept elsewhere (such as one bit of a shared mask), as an out target
+        /// </summary>
+        template<typename T>
+        struct out_sink
+        {
+            T* value;
+            void* flags;
+            unsigned index;
+            bool (*is_set)(const void* flags, unsigned index);
+            void (*set)(void* flags, unsigned index);
+        };
+
+        //The same pointer, but the optimizer no longer knows which object it points at (the empty asm emits no code).
+        //Targets are reached through this: GCC can't always tell a target's kind before it checks accesses,
+        //and would warn (-Warray-bounds, -Wmaybe-uninitialized) about the other kinds' accesses to a known object
+        template<typename P>
+        P* hide_target(P* ptr)
+        {
+#if defined (__GNUC__)
+            __asm__("" : "+r"(ptr));
+#endif
+            return ptr;
+        }
+
+        template<typename T, bool Packed = (alignof(T) >= 4)>
+        class out_target;
+
+        template<typename T>
+        class out_target<T, true>
+        {
+        private:
+            static const std::uintptr_t kind_mask = 3;
+
+            std::uintptr_t m_bits;
+
+            static std::uintptr_t pack(const void* ptr, out_kind kind)
+            {
+                return reinterpret_cast<std::uintptr_t>(ptr) | static_cast<std::uintptr_t>(kind);
+            }
+
+            void* untagged() const
+            {
+                return hide_target(reinterpret_cast<void*>(m_bits & ~kind_mask));
+            }
+
+        public:
+            out_target(T* direct) : m_bits(pack(direct, out_kind::direct)) {}
+            out_target(uninit<T>* uninitialized) : m_bits(pack(uninitialized, out_kind::uninitialized)) {}
+            out_target(T** boxed) : m_bits(pack(boxed, out_kind::boxed)) {}
+            out_target(out_sink<T>* sink) : m_bits(pack(sink, out_kind::sink)) {}
+
+            out_kind kind() const { return static_cast<out_kind>(m_bits & kind_mask); }
+            T* direct() const { return static_cast<T*>(untagged()); }
+            uninit<T>* uninitialized() const { return static_cast<uninit<T>*>(untagged()); }
+            T** boxed() const { return static_cast<T**>(untagged()); }
+            out_sink<T>* sink() const { return static_cast<out_sink<T>*>(untagged()); }
+        };
+
+        template<typename T>
+        class out_target<T, false>
+        {
+        private:
+            void* m_ptr;
+            out_kind m_kind;
+
+        public:
+            out_target(T* direct) : m_ptr(direct), m_kind(out_kind::direct) {}
+            out_target(uninit<T>* uninitialized) : m_ptr(uninitialized), m_kind(out_kind::uninitialized) {}
+            out_target(T** boxed) : m_ptr(boxed), m_kind(out_kind::boxed) {}
+            out_target(out_sink<T>* sink) : m_ptr(sink), m_kind(out_kind::sink) {}
+
+            out_kind kind() const { return m_kind; }
+            T* direct() const { return static_cast<T*>(m_ptr); }
+            uninit<T>* uninitialized() const { return static_cast<uninit<T>*>(m_ptr); }
+            T** boxed() const { return static_cast<T**>(m_ptr); }
+            out_sink<T>* sink() const { return static_cast<out_sink<T>*>(m_ptr); }
+        };
+
         /*
         
             Output only-type
@@ -462,67 +646,178 @@ public:\
         class out final
         {
         private:
-            union {
-                T* m_direct;
-                uninit<T>* m_uninit;
-            };
+            out_target<T> m_target;
 
-            const bool m_is_direct;
+            //Only needed to check reads, so not stored when CPPSPT_DISABLE_ASSERTS is defined
+#if defined (CPPSPT_ASSERT_STATE)
             bool m_was_written = false;
+#endif
+
+            template<typename F>
+            static void assign_result(T& dest, F& factory, std::true_type)
+            {
+                dest = factory();
+            }
+
+            //Rebuilt in place: the old value is destroyed first, so nothing after that may throw
+            template<typename F>
+            static void assign_result(T& dest, F& factory, std::false_type)
+            {
+                rebuild_result(dest, factory, std::integral_constant<bool, noexcept(T(factory()))>());
+            }
+
+            template<typename F>
+            static void rebuild_result(T& dest, F& factory, std::true_type)
+            {
+                dest.~T();
+                new (&dest) T(factory());
+            }
+
+            //The result may throw, so it's built in a temporary while the old value is still alive
+            template<typename F>
+            static void rebuild_result(T& dest, F& factory, std::false_type)
+            {
+                static_assert(std::is_nothrow_move_constructible<T>::value,
+                    "CPPSPT: rebuilding a value that can't be assigned needs a noexcept factory or a noexcept move constructor!");
+
+                T result(factory());
+                dest.~T();
+                new (&dest) T(std::move(result));
+            }
 
         public:
-            ~out(){}
+            out(T& direct) : m_target(&direct) 
+            {
+#if !defined (CPPSPT_ASSERT_STATE)
+                static_assert(alignof(T) < 4 || sizeof(out<T>) == sizeof(void*), "CPPSPT: out<T> should be a single tagged pointer!");
+#endif
+            }
 
-            out(T& direct) : m_is_direct(true), m_direct(&direct) {}
-            out(uninit<T>& uninitialized) : m_is_direct(false), m_uninit(&uninitialized) {}
+            out(uninit<T>& uninitialized) : m_target(&uninitialized) {}
 
-            //Unfortunately, we can't specify an 'in' copy constructor; 
-            //We still have to manually specify the const ref & move constructors individually
-            //If we don't, we get compilation errors for ambiguous overloads
-            out(const out<T>& other) : m_is_direct(other.m_is_direct)
+            out(box_slot<T> boxed) : m_target(boxed.ptr) {}
+
+            //The sink must outlive the out
+            out(out_sink<T>& sink) : m_target(&sink) {}
+
+            //Copying an out only copies the target, so these are trivial
+            //(Which also lets an out be passed in a register)
+            out(const out<T>& other) = default;
+            out(out<T>&& other) = default;
+            ~out() = default;
+
+            out<T>& operator=(in<T> val)
             {
-                if (other.m_is_direct)
+                switch (m_target.kind())
                 {
-                    m_direct = other.m_direct;
-                }
-                else
+                case out_kind::direct:
+                    assign_from_in(*m_target.direct(), val);
+                    break;
+
+                case out_kind::uninitialized:
+                    *m_target.uninitialized() = std::move(val);
+                    break;
+
+                case out_kind::boxed:
                 {
-                    m_uninit = other.m_uninit;
+                    T*& boxed = *m_target.boxed();
+                    if (boxed != nullptr)
+                    {
+                        assign_from_in(*boxed, val);
+                    }
+                    else
+                    {
+                        boxed = new_from_in(val);
+                    }
+                    break;
                 }
-            }
 
-            out(out<T>&& other) : m_is_direct(other.m_is_direct)
-            {
-                if (other.m_is_direct)
+                case out_kind::sink:
                 {
-                    m_direct = other.m_direct;
+                    out_sink<T>& sink = *m_target.sink();
+                    if (sink.is_set(sink.flags, sink.index))
+                    {
+                        assign_from_in(*sink.value, val);
+                    }
+                    else
+                    {
+                        construct_from_in(sink.value, val);
+                        sink.set(sink.flags, sink.index);
+                    }
+                    break;
                 }
-                else
-                {
-                    m_uninit = other.m_uninit;
                 }
+
+#if defined (CPPSPT_ASSERT_STATE)
+                m_was_written = true;
+#endif
+
+                return *this;
             }
 
-            out<T>& operator=(in<T> val)
+            /// <summary>
+            /// Writes the T returned by factory(). Targets without a value (an uninitialized uninit, an empty box, an unset sink)
+            /// construct it in place like uninit::init_with. Every live T, whatever the target, is assigned the result,
+            /// or, if T can't be assigned from it, destroyed and rebuilt in place (which needs a noexcept factory, or a noexcept move)
+            /// </summary>
+            template<typename F>
+            out<T>& assign_from(F&& factory)
             {
-                if (m_is_direct)
+                using assignable = std::is_assignable<T&, decltype(factory())>;
+
+                switch (m_target.kind())
                 {
+                case out_kind::direct:
+                    assign_result(*m_target.direct(), factory, assignable());
+                    break;
 
-                    if (val.was_moved())
+                case out_kind::uninitialized:
+                {
+                    uninit<T>& uninitialized = *m_target.uninitialized();
+                    if (uninitialized.was_initialized())
                     {
-                        *m_direct = val.move_out();
+                        assign_result(*uninitialized, factory, assignable());
                     }
                     else
                     {
-                        *m_direct = val.unmoved_ref();
+                        uninitialized.init_with(std::forward<F>(factory));
                     }
+                    break;
                 }
-                else
+
+                case out_kind::boxed:
                 {
-                    *m_uninit = std::move(val);
+                    T*& boxed = *m_target.boxed();
+                    if (boxed != nullptr)
+                    {
+                        assign_result(*boxed, factory, assignable());
+                    }
+                    else
+                    {
+                        boxed = new T(factory());
+                    }
+                    break;
+                }
+
+                case out_kind::sink:
+                {
+                    out_sink<T>& sink = *m_target.sink();
+                    if (sink.is_set(sink.flags, sink.index))
+                    {
+                        assign_result(*sink.value, factory, assignable());
+                    }
+                    else
+                    {
+                        new (sink.value) T(factory());
+                        sink.set(sink.flags, sink.index);
+                    }
+                    break;
+                }
                 }
 
+#if defined (CPPSPT_ASSERT_STATE)
                 m_was_written = true;
+#endif
 
                 return *this;
             }
@@ -530,13 +825,16 @@ public:\
             operator T& ()
             {
                 CPPSPT_ASSERT(m_was_written && "CPPSPT: reading from unwritten x!");
-                if (m_is_direct)
-                {
-                    return *m_direct;
-                }
-                else
+                switch (m_target.kind())
                 {
-                    return *m_uninit;
+                case out_kind::direct:
+                    return *m_target.direct();
+                case out_kind::uninitialized:
+                    return *m_target.uninitialized();
+                case out_kind::boxed:
+                    return **m_target.boxed();
+                default:
+                    return *m_target.sink()->value;
                 }
             }
 
@@ -550,6 +848,38 @@ public:\
                 return &static_cast<T&>(*this);
             }
 
+            //The current value at the target, for formatting. Null if the target has no value yet
+            const T* target_value() const
+            {
+                switch (m_target.kind())
+                {
+                case out_kind::direct:
+                    return m_target.direct();
+                case out_kind::uninitialized:
+                {
+                    const uninit<T>* target = m_target.uninitialized();
+                    return target->was_initialized() ? &**target : nullptr;
+                }
+                case out_kind::boxed:
+                    return *m_target.boxed();
+                default:
+                {
+                    const out_sink<T>* sink = m_target.sink();
+                    return sink->is_set(sink->flags, sink->index) ? sink->value : nullptr;
+                }
+                }
+            }
+
+            friend std::ostream& operator<< (std::ostream& out, const detail::out<T>& val)
+            {
+                const T* value = val.target_value();
+                if (value != nullptr)
+                {
+                    return out << *value;
+                }
+                return out << "[Uninitialized]";
+            }
+
         private:
             //In order to prevent ambiguous overloads with operator=
             //(Due to there being conversions from references to BOTH in AND out)
@@ -585,11 +915,16 @@ public:\
     template<typename T, typename std::enable_if< !std::is_copy_constructible<T>::value && std::is_move_constructible<T>::value, int>::type >
     move<T>&& resolve(inout<in<T>> param)
     {
-        CPPSPT_ASSERT(param.was_moved() && "Copying a solely move constructible type!");
+        CPPSPT_VERIFY(param.was_moved() && "Copying a solely move constructible type!");
 
         return param.move_out();
     }
 
+    template<typename T>
+    auto resolve(in<T>&& param) -> decltype(resolve(static_cast<in<T>&>(param)))
+    {
+        return resolve(static_cast<in<T>&>(param));
+    }
 }
 
 #endif
\ No newline at end of file
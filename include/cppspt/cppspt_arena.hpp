@@ -0,0 +1,560 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_ARENA_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_ARENA_HPP
+
+/*
+
+    Allocator-aware in parameters, and a monotonic arena for request-scoped data
+
+    resolve(in<T>) copies (or moves) with T's own allocator. resolve(in<T>, alloc) constructs the T with alloc instead,
+    by uses-allocator construction: T(allocator_arg, alloc, val) or T(val, alloc) when T uses an allocator of that kind,
+    and a plain T(val) otherwise. A copy made from an lvalue in then lands wherever alloc allocates.
+    init_with_allocator & assign_with_allocator do the same for uninits.
+
+    arena is a monotonic allocator: allocations bump a pointer through a list of chunks, deallocations are ignored,
+    and reset() rewinds it (keeping the chunks for reuse) so every allocation of a request is freed in one go.
+    arena_allocator<T> allocates from an arena, and arena_vector<T> is a growable array of uninit<T>
+    whose storage and elements all live in one.
+
+    From C++17 (with <memory_resource>), resolve & the uninit functions also take a std::pmr::memory_resource*,
+    and arena_resource lets std::pmr containers allocate from an arena.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_relocate.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if CPPSPT_CPLUSPLUS >= 201703L && defined (__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#if defined (__cpp_lib_memory_resource)
+#define CPPSPT_HAS_MEMORY_RESOURCE
+#endif
+#endif
+#endif
+
+namespace cppspt
+{
+    namespace detail
+    {
+        class arena;
+
+        template<typename T>
+        class arena_allocator;
+
+        template<typename T>
+        class arena_vector;
+    }
+
+    /// <summary>
+    /// A monotonic allocator: allocating bumps a pointer, deallocating does nothing, and reset() frees everything at once
+    /// </summary>
+    using arena = detail::arena;
+
+    /// <summary>
+    /// A standard allocator which allocates from an arena
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using arena_allocator = detail::arena_allocator<T>;
+
+    /// <summary>
+    /// A growable array of uninit slots, whose storage and values are allocated from an arena
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using arena_vector = detail::arena_vector<T>;
+
+    namespace detail
+    {
+        /*
+
+            Uses-allocator construction (std::make_obj_using_allocator is C++20)
+
+        */
+
+        //0: T doesn't use Alloc, 1: T takes (allocator_arg, alloc, args...), 2: T takes (args..., alloc)
+        template<typename T, typename Alloc, typename ... Args>
+        using uses_allocator_kind = std::integral_constant<int,
+            !std::uses_allocator<T, Alloc>::value ? 0 :
+            std::is_constructible<T, std::allocator_arg_t, const Alloc&, Args...>::value ? 1 :
+            std::is_constructible<T, Args..., const Alloc&>::value ? 2 : 0>;
+
+        template<typename T, typename Alloc, typename ... Args>
+        T make_with_allocator(std::integral_constant<int, 0>, const Alloc&, Args&& ... args)
+        {
+            return T(std::forward<Args>(args)...);
+        }
+
+        template<typename T, typename Alloc, typename ... Args>
+        T make_with_allocator(std::integral_constant<int, 1>, const Alloc& alloc, Args&& ... args)
+        {
+            return T(std::allocator_arg, alloc, std::forward<Args>(args)...);
+        }
+
+        template<typename T, typename Alloc, typename ... Args>
+        T make_with_allocator(std::integral_constant<int, 2>, const Alloc& alloc, Args&& ... args)
+        {
+            return T(std::forward<Args>(args)..., alloc);
+        }
+
+        /// <summary>
+        /// A T constructed from args, using alloc if T uses an allocator of its kind
+        /// </summary>
+        template<typename T, typename Alloc, typename ... Args>
+        T make_with_allocator(const Alloc& alloc, Args&& ... args)
+        {
+            return make_with_allocator<T>(uses_allocator_kind<T, Alloc, Args&&...>(), alloc, std::forward<Args>(args)...);
+        }
+
+        //Keeps a parameter out of template argument deduction, so T comes from the uninit alone
+        template<typename T>
+        struct non_deduced
+        {
+            using type = T;
+        };
+    }
+
+    /// <summary>
+    /// Captures the value from an in parameter, constructing the T with alloc (if T uses an allocator of its kind).
+    /// A const ref is copied into alloc's memory. A move is an allocator-extended move, which copies the contents
+    /// into alloc's memory unless the moved value's allocator compares equal to alloc.
+    /// The in parameter is invalidated after calling this function and can no longer be read from
+    /// </summary>
+    template<typename T, typename Alloc>
+    T resolve(inout<in<T>> param, const Alloc& alloc)
+    {
+        if (param.was_moved())
+        {
+            return detail::make_with_allocator<T>(alloc, param.move_out());
+        }
+        else
+        {
+            return detail::make_with_allocator<T>(alloc, param.unmoved_ref());
+        }
+    }
+
+    /// <summary>
+    /// Constructs the value of an uninitialized uninit from args, using alloc. Does nothing if it is initialized, like uninit::init
+    /// </summary>
+    template<typename T, typename Alloc, typename ... Args>
+    T& init_with_allocator(uninit<T>& dest, const Alloc& alloc, Args&& ... args)
+    {
+        if (!dest.was_initialized())
+        {
+            dest.init_with([&] { return detail::make_with_allocator<T>(alloc, std::forward<Args>(args)...); });
+        }
+        return *dest;
+    }
+
+    /// <summary>
+    /// Writes val to an uninit. A live value is assigned (and keeps its own allocator), otherwise the value is constructed using alloc
+    /// </summary>
+    template<typename T, typename Alloc>
+    T& assign_with_allocator(uninit<T>& dest, in<typename detail::non_deduced<T>::type> val, const Alloc& alloc)
+    {
+        if (dest.was_initialized())
+        {
+            dest = std::move(val);
+        }
+        else
+        {
+            dest.init_with([&] { return cppspt::resolve(val, alloc); });
+        }
+        return *dest;
+    }
+
+#if defined (CPPSPT_HAS_MEMORY_RESOURCE)
+
+    /// <summary>
+    /// Captures the value from an in parameter, constructing the T with a polymorphic allocator over resource
+    /// </summary>
+    template<typename T>
+    T resolve(inout<in<T>> param, std::pmr::memory_resource* resource)
+    {
+        return cppspt::resolve(param, std::pmr::polymorphic_allocator<std::byte>(resource));
+    }
+
+    template<typename T, typename ... Args>
+    T& init_with_allocator(uninit<T>& dest, std::pmr::memory_resource* resource, Args&& ... args)
+    {
+        return cppspt::init_with_allocator(dest, std::pmr::polymorphic_allocator<std::byte>(resource), std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    T& assign_with_allocator(uninit<T>& dest, in<typename detail::non_deduced<T>::type> val, std::pmr::memory_resource* resource)
+    {
+        return cppspt::assign_with_allocator(dest, std::move(val), std::pmr::polymorphic_allocator<std::byte>(resource));
+    }
+
+#endif
+
+    namespace detail
+    {
+        class arena final
+        {
+        private:
+            //Each chunk's memory follows its header
+            struct alignas(std::max_align_t) chunk
+            {
+                chunk* next;
+                std::size_t size;
+            };
+
+            //The caller's initial buffer (if any), used before any chunk
+            char* m_buffer;
+            std::size_t m_buffer_size;
+
+            chunk* m_chunks;
+            chunk* m_current;       //Null while allocating from the initial buffer
+            std::uintptr_t m_pos;
+            std::uintptr_t m_end;
+
+            std::size_t m_next_chunk_size;
+            std::size_t m_allocated;
+
+            static std::uintptr_t align_up(std::uintptr_t pos, std::size_t alignment)
+            {
+                return (pos + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+            }
+
+            static std::uintptr_t chunk_begin(chunk* c) { return reinterpret_cast<std::uintptr_t>(c + 1); }
+
+            //Moves to the next chunk that fits the allocation, reusing the chunks kept by reset() where possible
+            void next_chunk(std::size_t bytes, std::size_t alignment)
+            {
+                std::size_t needed = bytes + alignment;
+                chunk* next = (m_current != nullptr) ? m_current->next : m_chunks;
+                if (next == nullptr || next->size < needed)
+                {
+                    std::size_t size = (m_next_chunk_size > needed) ? m_next_chunk_size : needed;
+                    m_next_chunk_size *= 2;
+
+                    chunk* fresh = static_cast<chunk*>(::operator new(sizeof(chunk) + size));
+                    fresh->size = size;
+                    fresh->next = next;
+                    if (m_current != nullptr)
+                    {
+                        m_current->next = fresh;
+                    }
+                    else
+                    {
+                        m_chunks = fresh;
+                    }
+                    next = fresh;
+                }
+
+                m_current = next;
+                m_pos = chunk_begin(next);
+                m_end = m_pos + next->size;
+            }
+
+        public:
+            /// <summary>
+            /// An arena whose first chunk (allocated on first use) holds first_chunk_size bytes. Later chunks double in size
+            /// </summary>
+            explicit arena(std::size_t first_chunk_size = 4096) :
+                m_buffer(nullptr),
+                m_buffer_size(0),
+                m_chunks(nullptr),
+                m_current(nullptr),
+                m_pos(0),
+                m_end(0),
+                m_next_chunk_size(first_chunk_size != 0 ? first_chunk_size : 1),
+                m_allocated(0)
+            {
+            }
+
+            /// <summary>
+            /// An arena which allocates from buffer (such as an array on the stack) until it is full. The buffer must outlive the arena
+            /// </summary>
+            arena(void* buffer, std::size_t size) : arena(size != 0 ? size : 4096)
+            {
+                m_buffer = static_cast<char*>(buffer);
+                m_buffer_size = size;
+                reset();
+            }
+
+            arena(const arena&) = delete;
+            arena& operator=(const arena&) = delete;
+
+            ~arena()
+            {
+                release();
+            }
+
+            /// <summary>
+            /// Allocates bytes with the given (power of two) alignment. Never returns null
+            /// </summary>
+            void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+            {
+                CPPSPT_ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0 && "CPPSPT: arena alignments must be powers of two!");
+
+                std::uintptr_t pos = align_up(m_pos, alignment);
+                if (m_pos == 0 || pos + bytes > m_end || pos < m_pos)
+                {
+                    next_chunk(bytes, alignment);
+                    pos = align_up(m_pos, alignment);
+                }
+
+                m_pos = pos + bytes;
+                m_allocated += bytes;
+                return reinterpret_cast<void*>(pos);
+            }
+
+            //Memory is only freed by reset() or release()
+            void deallocate(void*, std::size_t) {}
+
+            /// <summary>
+            /// Frees every allocation at once. The chunks are kept, and reused by later allocations
+            /// </summary>
+            void reset()
+            {
+                m_current = nullptr;
+                m_pos = reinterpret_cast<std::uintptr_t>(m_buffer);
+                m_end = m_pos + m_buffer_size;
+                m_allocated = 0;
+            }
+
+            /// <summary>
+            /// Frees every allocation at once, and returns the chunks to the heap
+            /// </summary>
+            void release()
+            {
+                while (m_chunks != nullptr)
+                {
+                    chunk* next = m_chunks->next;
+                    ::operator delete(m_chunks);
+                    m_chunks = next;
+                }
+                reset();
+            }
+
+            //Bytes handed out since the last reset (not counting alignment padding)
+            std::size_t bytes_allocated() const { return m_allocated; }
+        };
+
+        template<typename T>
+        class arena_allocator
+        {
+        private:
+            arena* m_arena;
+
+            template<typename U>
+            friend class arena_allocator;
+
+        public:
+            using value_type = T;
+
+            //The allocator stays with its container: copies & moves of the container keep allocating from the same arena
+            using propagate_on_container_copy_assignment = std::false_type;
+            using propagate_on_container_move_assignment = std::true_type;
+            using propagate_on_container_swap = std::true_type;
+
+            explicit arena_allocator(arena& source) : m_arena(&source) {}
+
+            template<typename U>
+            arena_allocator(const arena_allocator<U>& other) : m_arena(other.m_arena) {}
+
+            T* allocate(std::size_t count)
+            {
+                return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T)));
+            }
+
+            void deallocate(T*, std::size_t) {}
+
+            arena& source() const { return *m_arena; }
+
+            template<typename U>
+            bool operator==(const arena_allocator<U>& other) const { return m_arena == other.m_arena; }
+
+            template<typename U>
+            bool operator!=(const arena_allocator<U>& other) const { return m_arena != other.m_arena; }
+        };
+
+        template<typename T>
+        class arena_vector final
+        {
+        private:
+            arena* m_arena;
+            uninit<T>* m_data;
+            std::size_t m_size;
+            std::size_t m_capacity;
+
+            //The old storage is left to the arena (as is the new storage, if moving the elements throws)
+            void reallocate(std::size_t capacity)
+            {
+                uninit<T>* data = arena_allocator<uninit<T>>(*m_arena).allocate(capacity);
+                transfer_n(m_data, m_size, data, is_nothrow_relocatable<T>());
+                m_data = data;
+                m_capacity = capacity;
+            }
+
+            //Constructs the next value in a new slot. When full, the slot is in new storage, and the elements are only
+            //relocated after the value is constructed (so the value may be built from an element).
+            //If moving the elements throws, they stay where they were, and the new value is destroyed
+            template<typename Construct>
+            uninit<T>& append(Construct construct)
+            {
+                if (m_size < m_capacity)
+                {
+                    uninit<T>* slot = new (m_data + m_size) uninit<T>();
+                    construct(*slot);
+                    m_size++;
+                    return *slot;
+                }
+
+                std::size_t capacity = m_capacity != 0 ? m_capacity * 2 : 4;
+                uninit<T>* data = arena_allocator<uninit<T>>(*m_arena).allocate(capacity);
+                uninit<T>* slot = new (data + m_size) uninit<T>();
+                construct(*slot);
+
+                try
+                {
+                    transfer_n(m_data, m_size, data, is_nothrow_relocatable<T>());
+                }
+                catch (...)
+                {
+                    slot->~uninit<T>();
+                    throw;
+                }
+                m_data = data;
+                m_capacity = capacity;
+                m_size++;
+                return *slot;
+            }
+
+        public:
+            explicit arena_vector(arena& source) :
+                m_arena(&source),
+                m_data(nullptr),
+                m_size(0),
+                m_capacity(0)
+            {
+            }
+
+            arena_vector(const arena_vector<T>&) = delete;
+            arena_vector& operator=(const arena_vector<T>&) = delete;
+
+            //Destroys the values (which may own memory outside the arena), but leaves the storage to the arena
+            ~arena_vector()
+            {
+                clear();
+            }
+
+            std::size_t size() const { return m_size; }
+            std::size_t capacity() const { return m_capacity; }
+            bool empty() const { return m_size == 0; }
+
+            /// <summary>
+            /// The allocator values are constructed with
+            /// </summary>
+            arena_allocator<T> get_allocator() const { return arena_allocator<T>(*m_arena); }
+
+            void reserve(std::size_t capacity)
+            {
+                if (capacity > m_capacity)
+                {
+                    reallocate(capacity);
+                }
+            }
+
+            /// <summary>
+            /// Appends a slot holding val, constructed with the arena's allocator: a copy of an lvalue lands in the arena
+            /// </summary>
+            uninit<T>& push_back(in<T> val)
+            {
+                return append([&](uninit<T>& slot) { slot.init_with([&] { return cppspt::resolve(val, get_allocator()); }); });
+            }
+
+            /// <summary>
+            /// Appends a slot holding a T constructed from args, with the arena's allocator
+            /// </summary>
+            template<typename ... Args>
+            uninit<T>& emplace_back(Args&& ... args)
+            {
+                return append([&](uninit<T>& slot) { cppspt::init_with_allocator(slot, get_allocator(), std::forward<Args>(args)...); });
+            }
+
+            /// <summary>
+            /// Appends an uninitialized slot
+            /// </summary>
+            uninit<T>& push_back_uninit()
+            {
+                return append([](uninit<T>&) {});
+            }
+
+            void clear()
+            {
+                for (std::size_t i = 0; i < m_size; i++)
+                {
+                    m_data[i].~uninit<T>();
+                }
+                m_size = 0;
+            }
+
+            uninit<T>& operator[](std::size_t index) { return m_data[index]; }
+            const uninit<T>& operator[](std::size_t index) const { return m_data[index]; }
+
+            uninit<T>* begin() { return m_data; }
+            uninit<T>* end() { return m_data + m_size; }
+            const uninit<T>* begin() const { return m_data; }
+            const uninit<T>* end() const { return m_data + m_size; }
+        };
+
+#if defined (CPPSPT_HAS_MEMORY_RESOURCE)
+
+        /// <summary>
+        /// An arena, as a std::pmr::memory_resource
+        /// </summary>
+        class arena_resource final : public std::pmr::memory_resource
+        {
+        private:
+            arena* m_arena;
+
+        protected:
+            void* do_allocate(std::size_t bytes, std::size_t alignment) override
+            {
+                return m_arena->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+            {
+                const arena_resource* other_arena = dynamic_cast<const arena_resource*>(&other);
+                return other_arena != nullptr && other_arena->m_arena == m_arena;
+            }
+
+        public:
+            explicit arena_resource(arena& source) : m_arena(&source) {}
+
+            arena& source() const { return *m_arena; }
+        };
+
+#endif
+    }
+
+#if defined (CPPSPT_HAS_MEMORY_RESOURCE)
+
+    /// <summary>
+    /// An arena as a std::pmr::memory_resource, so std::pmr containers can allocate from it
+    /// </summary>
+    using arena_resource = detail::arena_resource;
+
+#endif
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_ARENA_HPP
@@ -0,0 +1,525 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_BINARY_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_BINARY_HPP
+
+/*
+
+    Decoding binary messages straight into out & uninit destinations
+
+    A decoder that default constructs a message and then assigns each decoded field initializes every field twice.
+    binary_reader constructs each value once, from the bytes: a struct is brace-initialized from its decoded fields
+    (which are evaluated in order; from C++17 each is decoded straight into its member, before that it may be moved there),
+    adjacent trivially copyable fields are read with one bounds check, strings & vectors are constructed at their final size,
+    and the result is written to an out<T> (so a T&, or an uninit<T> that the decoded value is constructed in, through out<T>::assign_from).
+
+    Wire format (in the host's byte order, as written by binary_writer):
+        trivially copyable types: their bytes, copied in bulk (so a struct of plain fields is a single copy)
+        std::string: a 32-bit length, then the characters
+        std::vector: a 32-bit count, then the elements (in one copy, if they are trivially copyable)
+        any other type: its fields, in the order listed by binary_fields<T>
+
+    To describe a type, specialize binary_fields with a fields() function that lists its members,
+    in declaration order (the decoded fields initialize the type in that order, which is asserted):
+
+        template<>
+        struct cppspt::binary_fields<message>
+        {
+            static auto fields() { return cppspt::binary_members(&message::id, &message::name, &message::values); }
+        };
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        class binary_reader;
+
+        class binary_writer;
+    }
+
+    /// <summary>
+    /// Decodes values from a byte buffer, constructing each one once
+    /// </summary>
+    using binary_reader = detail::binary_reader;
+
+    /// <summary>
+    /// Encodes values into a growing byte buffer, in the format binary_reader decodes
+    /// </summary>
+    using binary_writer = detail::binary_writer;
+
+    /// <summary>
+    /// Lists the members of a type that isn't trivially copyable. Specialize with a static fields() function returning binary_members(...)
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    struct binary_fields;
+
+    /// <summary>
+    /// The member pointers of a type, in declaration order
+    /// </summary>
+    template<typename ... Members>
+    std::tuple<Members...> binary_members(Members ... members)
+    {
+        return std::tuple<Members...>(members...);
+    }
+
+    namespace detail
+    {
+        using binary_length = std::uint32_t;
+
+        enum class binary_kind
+        {
+            raw,
+            string,
+            vector,
+            described
+        };
+
+        template<typename T>
+        struct binary_kind_of : std::integral_constant<binary_kind, std::is_trivially_copyable<T>::value ? binary_kind::raw : binary_kind::described> {};
+
+        template<typename Traits, typename Alloc>
+        struct binary_kind_of<std::basic_string<char, Traits, Alloc>> : std::integral_constant<binary_kind, binary_kind::string> {};
+
+        template<typename T, typename Alloc>
+        struct binary_kind_of<std::vector<T, Alloc>> : std::integral_constant<binary_kind, binary_kind::vector> {};
+
+        //The type of a member, from its member pointer
+        template<typename Member>
+        struct binary_member_type;
+
+        template<typename T, typename Class>
+        struct binary_member_type<T Class::*>
+        {
+            using type = T;
+        };
+
+        template<typename T, binary_kind Kind = binary_kind_of<T>::value>
+        struct binary_codec;
+
+        class binary_writer final
+        {
+        private:
+            std::vector<unsigned char> m_buffer;
+
+        public:
+            binary_writer() = default;
+
+            /// <summary>
+            /// Appends the encoding of a value
+            /// </summary>
+            template<typename T>
+            void write(const T& val)
+            {
+                binary_codec<T>::write(*this, val);
+            }
+
+            void write_bytes(const void* bytes, std::size_t size)
+            {
+                if (size == 0)
+                {
+                    return;
+                }
+
+                //Grown, then copied into, as GCC (from C++20) warns about inserting a small constant sized range (-Wstringop-overflow)
+                const std::size_t offset = m_buffer.size();
+                m_buffer.resize(offset + size);
+                std::memcpy(m_buffer.data() + offset, bytes, size);
+            }
+
+            void write_length(std::size_t length)
+            {
+                CPPSPT_ASSERT(length <= static_cast<binary_length>(-1) && "CPPSPT: length too long to encode!");
+
+                binary_length encoded = static_cast<binary_length>(length);
+                write_bytes(&encoded, sizeof(encoded));
+            }
+
+            void reserve(std::size_t size) { m_buffer.reserve(size); }
+            void clear() { m_buffer.clear(); }
+
+            const unsigned char* data() const { return m_buffer.data(); }
+            std::size_t size() const { return m_buffer.size(); }
+        };
+
+        class binary_reader final
+        {
+        private:
+            const unsigned char* m_pos;
+            const unsigned char* m_end;
+            bool m_failed;
+
+        public:
+            binary_reader(const void* data, std::size_t size) :
+                m_pos(static_cast<const unsigned char*>(data)),
+                m_end(static_cast<const unsigned char*>(data) + size),
+                m_failed(false)
+            {
+            }
+
+            /// <summary>
+            /// Decodes a value. If the buffer is too short, the reader fails,
+            /// and this (and every later read) returns zeroed & empty values
+            /// </summary>
+            template<typename T>
+            T read()
+            {
+                return binary_codec<T>::read(*this);
+            }
+
+            /// <summary>
+            /// Decodes a value into dest, which is written even on failure. Returns false if the reader has failed
+            /// </summary>
+            template<typename T>
+            bool read(out<T> dest)
+            {
+                dest.assign_from([this] { return read<T>(); });
+                return !m_failed;
+            }
+
+            template<typename T>
+            bool read(T& dest)
+            {
+                return read(out<T>(dest));
+            }
+
+            template<typename T>
+            bool read(uninit<T>& dest)
+            {
+                return read(out<T>(dest));
+            }
+
+            /// <summary>
+            /// Consumes size bytes, returning where they start. Returns nullptr (and fails the reader) if there are fewer left
+            /// </summary>
+            const unsigned char* take(std::size_t size)
+            {
+                if (m_failed || static_cast<std::size_t>(m_end - m_pos) < size)
+                {
+                    m_failed = true;
+                    return nullptr;
+                }
+
+                const unsigned char* bytes = m_pos;
+                m_pos += size;
+                return bytes;
+            }
+
+            /// <summary>
+            /// Reads a length, failing the reader if the remaining bytes can't hold that many elements of element_size
+            /// </summary>
+            std::size_t read_length(std::size_t element_size)
+            {
+                const unsigned char* bytes = take(sizeof(binary_length));
+                if (bytes == nullptr)
+                {
+                    return 0;
+                }
+
+                binary_length length;
+                std::memcpy(&length, bytes, sizeof(length));
+                if (element_size != 0 && length > remaining() / element_size)
+                {
+                    m_failed = true;
+                    return 0;
+                }
+                return length;
+            }
+
+            bool failed() const { return m_failed; }
+
+            std::size_t remaining() const { return static_cast<std::size_t>(m_end - m_pos); }
+        };
+
+        /*
+
+            Codecs for each kind of type
+
+        */
+
+        template<typename T>
+        struct binary_codec<T, binary_kind::raw>
+        {
+            static void write(binary_writer& writer, const T& val)
+            {
+                writer.write_bytes(&val, sizeof(T));
+            }
+
+            static T read(binary_reader& reader)
+            {
+                T result;
+                const unsigned char* bytes = reader.take(sizeof(T));
+                if (bytes != nullptr)
+                {
+                    std::memcpy(&result, bytes, sizeof(T));
+                }
+                else
+                {
+                    std::memset(&result, 0, sizeof(T));
+                }
+                return result;
+            }
+        };
+
+        template<typename T>
+        struct binary_codec<T, binary_kind::string>
+        {
+            static void write(binary_writer& writer, const T& val)
+            {
+                writer.write_length(val.size());
+                writer.write_bytes(val.data(), val.size());
+            }
+
+            static T read(binary_reader& reader)
+            {
+                std::size_t length = reader.read_length(1);
+                const unsigned char* bytes = reader.take(length);
+                if (bytes == nullptr)
+                {
+                    return T();
+                }
+                return T(reinterpret_cast<const char*>(bytes), length);
+            }
+        };
+
+        template<typename Element, typename Alloc>
+        struct binary_codec<std::vector<Element, Alloc>, binary_kind::vector>
+        {
+            using vector_type = std::vector<Element, Alloc>;
+
+            static void write(binary_writer& writer, const vector_type& val)
+            {
+                writer.write_length(val.size());
+                write_elements(writer, val, std::integral_constant<bool, binary_kind_of<Element>::value == binary_kind::raw>());
+            }
+
+            static vector_type read(binary_reader& reader)
+            {
+                return read_elements(reader, std::integral_constant<bool, binary_kind_of<Element>::value == binary_kind::raw>());
+            }
+
+        private:
+            static void write_elements(binary_writer& writer, const vector_type& val, std::true_type)
+            {
+                writer.write_bytes(val.data(), val.size() * sizeof(Element));
+            }
+
+            static void write_elements(binary_writer& writer, const vector_type& val, std::false_type)
+            {
+                for (const Element& element : val)
+                {
+                    writer.write(element);
+                }
+            }
+
+            //Trivially copyable elements are copied in one go, into a vector allocated at its final size
+            static vector_type read_elements(binary_reader& reader, std::true_type)
+            {
+                std::size_t count = reader.read_length(sizeof(Element));
+                const unsigned char* bytes = reader.take(count * sizeof(Element));
+                if (bytes == nullptr || count == 0)
+                {
+                    return vector_type();
+                }
+
+                //Aligned bytes can be copied by the range constructor, in one pass
+                if (reinterpret_cast<std::uintptr_t>(bytes) % alignof(Element) == 0)
+                {
+                    const Element* first = reinterpret_cast<const Element*>(bytes);
+                    return vector_type(first, first + count);
+                }
+
+                vector_type result(count);
+                std::memcpy(result.data(), bytes, count * sizeof(Element));
+                return result;
+            }
+
+            //Other elements are constructed in place, in a vector reserved once
+            static vector_type read_elements(binary_reader& reader, std::false_type)
+            {
+                std::size_t count = reader.read_length(0);
+
+                vector_type result;
+                //Every element takes at least one byte (or none, for an empty struct), so this never over-reserves by much
+                result.reserve(count < reader.remaining() ? count : reader.remaining());
+                for (std::size_t i = 0; i < count && !reader.failed(); i++)
+                {
+                    result.emplace_back(reader.read<Element>());
+                }
+                return result;
+            }
+        };
+
+        /// <summary>
+        /// Where each field of a described type falls in the runs of adjacent trivially copyable fields, which are read with one take()
+        /// </summary>
+        template<typename ... Fields>
+        struct binary_field_runs
+        {
+            static constexpr bool is_raw(std::size_t index)
+            {
+                const bool raw[] = { false, (binary_kind_of<Fields>::value == binary_kind::raw)... };
+                return raw[index + 1];
+            }
+
+            static constexpr std::size_t size(std::size_t index)
+            {
+                const std::size_t sizes[] = { 0, sizeof(Fields)... };
+                return sizes[index + 1];
+            }
+
+            //The first field of the run holding field index
+            static constexpr std::size_t run_begin(std::size_t index)
+            {
+                while (index > 0 && is_raw(index - 1))
+                {
+                    index--;
+                }
+                return index;
+            }
+
+            static constexpr std::size_t offset_in_run(std::size_t index)
+            {
+                std::size_t offset = 0;
+                for (std::size_t i = run_begin(index); i < index; i++)
+                {
+                    offset += size(i);
+                }
+                return offset;
+            }
+
+            //The bytes of the run starting at field index
+            static constexpr std::size_t run_size(std::size_t index)
+            {
+                std::size_t total = 0;
+                for (std::size_t i = index; i < sizeof...(Fields) && is_raw(i); i++)
+                {
+                    total += size(i);
+                }
+                return total;
+            }
+        };
+
+        template<typename T>
+        struct binary_codec<T, binary_kind::described>
+        {
+            using fields_type = decltype(binary_fields<T>::fields());
+
+            static void write(binary_writer& writer, const T& val)
+            {
+                write_fields(writer, val, binary_fields<T>::fields(), std::make_index_sequence<std::tuple_size<fields_type>::value>());
+            }
+
+            static T read(binary_reader& reader)
+            {
+                CPPSPT_ASSERT(fields_in_order() && "CPPSPT: binary_fields must list the members in declaration order!");
+
+                return read_fields(reader, std::make_index_sequence<std::tuple_size<fields_type>::value>());
+            }
+
+        private:
+            template<std::size_t I>
+            using field_type = typename binary_member_type<typename std::tuple_element<I, fields_type>::type>::type;
+
+            template<typename Sequence>
+            struct runs_of;
+
+            template<std::size_t ... Is>
+            struct runs_of<std::index_sequence<Is...>>
+            {
+                using type = binary_field_runs<field_type<Is>...>;
+            };
+
+            using runs = typename runs_of<std::make_index_sequence<std::tuple_size<fields_type>::value>>::type;
+
+            //Braced initialization assigns the decoded fields to the members in declaration order, whatever order they're listed in,
+            //so the member addresses must increase. Only addresses are taken, so the storage is never constructed
+            template<std::size_t ... Is>
+            static bool check_order(std::index_sequence<Is...>)
+            {
+                typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+                const T* object = reinterpret_cast<const T*>(&storage);
+                const fields_type fields = binary_fields<T>::fields();
+
+                const std::uintptr_t addresses[] = { 0, reinterpret_cast<std::uintptr_t>(&(object->*std::get<Is>(fields)))... };
+                for (std::size_t i = 2; i < sizeof(addresses) / sizeof(addresses[0]); i++)
+                {
+                    if (addresses[i] <= addresses[i - 1])
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            static bool fields_in_order()
+            {
+                static const bool in_order = check_order(std::make_index_sequence<std::tuple_size<fields_type>::value>());
+                return in_order;
+            }
+
+            template<std::size_t ... Is>
+            static void write_fields(binary_writer& writer, const T& val, const fields_type& fields, std::index_sequence<Is...>)
+            {
+                int expand[] = { 0, (writer.write(val.*std::get<Is>(fields)), 0)... };
+                (void)expand;
+            }
+
+            //The elements of a braced initializer are evaluated in order, so the fields are decoded in wire order.
+            //From C++17 each result initializes its member directly; before, it's a temporary that the member is moved from
+            template<std::size_t ... Is>
+            static T read_fields(binary_reader& reader, std::index_sequence<Is...>)
+            {
+                const unsigned char* run = nullptr;
+                (void)run;
+                return T{ read_field<Is>(reader, run, std::integral_constant<bool, runs::is_raw(Is)>())... };
+            }
+
+            template<std::size_t I>
+            static field_type<I> read_field(binary_reader& reader, const unsigned char*&, std::false_type)
+            {
+                return reader.read<field_type<I>>();
+            }
+
+            //The first field of a run takes the bytes of the whole run, and the rest copy theirs from it
+            template<std::size_t I>
+            static field_type<I> read_field(binary_reader& reader, const unsigned char*& run, std::true_type)
+            {
+                if (runs::run_begin(I) == I)
+                {
+                    run = reader.take(runs::run_size(I));
+                }
+
+                field_type<I> result;
+                if (run != nullptr)
+                {
+                    std::memcpy(&result, run + runs::offset_in_run(I), sizeof(result));
+                }
+                else
+                {
+                    std::memset(&result, 0, sizeof(result));
+                }
+                return result;
+            }
+        };
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_BINARY_HPP
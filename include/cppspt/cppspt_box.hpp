@@ -0,0 +1,280 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_BOX_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_BOX_HPP
+
+/*
+
+    A deferred value that only takes its full size once initialized
+
+    uninit<T> always reserves sizeof(T), which wastes memory when most values are never initialized.
+    uninit_box<T, InlineBytes> stores T inline (as an uninit<T>) when it fits in InlineBytes,
+    and otherwise holds a single pointer, which stays null until the value is initialized and allocated.
+
+    Moving a boxed value only moves the pointer.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename T, std::size_t InlineBytes, bool Inline = (sizeof(T) <= InlineBytes)>
+        class uninit_box;
+    }
+
+    /// <summary>
+    /// An uninit that stores T inline when it fits in InlineBytes, and otherwise allocates it when initialized
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T, std::size_t InlineBytes = sizeof(void*)>
+    using uninit_box = detail::uninit_box<T, InlineBytes>;
+
+    namespace detail
+    {
+        /*
+
+            Small values: an uninit<T>
+
+        */
+
+        template<typename T, std::size_t InlineBytes>
+        class uninit_box<T, InlineBytes, true> final
+        {
+        private:
+            uninit<T> m_val;
+
+        public:
+            static const bool is_inline = true;
+
+            uninit_box() {}
+
+            uninit_box(unititialized_t) {}
+
+            uninit_box(in<T> value) : m_val(std::move(value)) {}
+
+            uninit_box(const uninit_box& other) : m_val(other.m_val) {}
+
+            uninit_box(uninit_box&& other) noexcept(std::is_nothrow_move_constructible<T>::value) : m_val(std::move(other.m_val)) {}
+
+            uninit_box& operator=(in<T> val)
+            {
+                m_val = std::move(val);
+                return *this;
+            }
+
+            uninit_box& operator=(const uninit_box& other)
+            {
+                if (CPPSPT_UNLIKELY(&other == this))
+                {
+                    return *this;
+                }
+
+                if (other.was_initialized())
+                {
+                    m_val = in<T>(*other.m_val);
+                }
+                else
+                {
+                    m_val.reset();
+                }
+                return *this;
+            }
+
+            uninit_box& operator=(uninit_box&& other) noexcept(std::is_nothrow_move_constructible<T>::value && std::is_nothrow_move_assignable<T>::value)
+            {
+                if (CPPSPT_UNLIKELY(&other == this))
+                {
+                    return *this;
+                }
+
+                if (other.was_initialized())
+                {
+                    m_val = in<T>(std::move(*other.m_val));
+                }
+                else
+                {
+                    m_val.reset();
+                }
+                return *this;
+            }
+
+            template<typename ... Args>
+            void init(Args&& ... args)
+            {
+                m_val.init(std::forward<Args>(args)...);
+            }
+
+            void reset()
+            {
+                m_val.reset();
+            }
+
+            bool was_initialized() const
+            {
+                return m_val.was_initialized();
+            }
+
+            operator const T& () const { return m_val; }
+            operator T& () { return m_val; }
+
+            T& operator*() { return *m_val; }
+            T* operator->() { return &*m_val; }
+            const T& operator*() const { return *m_val; }
+            const T* operator->() const { return &*m_val; }
+
+            //Lets an uninit_box be passed as an out parameter
+            operator out<T>() { return out<T>(m_val); }
+
+            friend std::ostream& operator<< (std::ostream& out, const uninit_box& val)
+            {
+                return out << val.m_val;
+            }
+        };
+
+        /*
+
+            Large values: a pointer, null until initialized
+
+        */
+
+        template<typename T, std::size_t InlineBytes>
+        class uninit_box<T, InlineBytes, false> final
+        {
+        private:
+            T* m_ptr;
+
+        public:
+            static const bool is_inline = false;
+
+            ~uninit_box()
+            {
+                delete m_ptr;
+            }
+
+            uninit_box() : m_ptr(nullptr) {}
+
+            uninit_box(unititialized_t) : m_ptr(nullptr) {}
+
+            uninit_box(in<T> value) : m_ptr(new_from_in(value)) {}
+
+            uninit_box(const uninit_box& other) :
+                m_ptr(other.m_ptr != nullptr ? new T(*other.m_ptr) : nullptr)
+            {
+            }
+
+            uninit_box(uninit_box&& other) noexcept : m_ptr(other.m_ptr)
+            {
+                other.m_ptr = nullptr;
+            }
+
+            uninit_box& operator=(in<T> val)
+            {
+                if (m_ptr != nullptr)
+                {
+                    assign_from_in(*m_ptr, val);
+                }
+                else
+                {
+                    m_ptr = new_from_in(val);
+                }
+                return *this;
+            }
+
+            uninit_box& operator=(const uninit_box& other)
+            {
+                if (&other == this)
+                {
+                    return *this;
+                }
+
+                if (other.m_ptr == nullptr)
+                {
+                    reset();
+                }
+                else
+                {
+                    *this = in<T>(*other.m_ptr);
+                }
+                return *this;
+            }
+
+            uninit_box& operator=(uninit_box&& other) noexcept
+            {
+                if (&other == this)
+                {
+                    return *this;
+                }
+
+                delete m_ptr;
+                m_ptr = other.m_ptr;
+                other.m_ptr = nullptr;
+                return *this;
+            }
+
+            template<typename ... Args>
+            void init(Args&& ... args)
+            {
+                if (m_ptr == nullptr)
+                {
+                    m_ptr = new T(std::forward<Args>(args)...);
+                }
+            }
+
+            //Destroys and frees the value (if any)
+            void reset()
+            {
+                delete m_ptr;
+                m_ptr = nullptr;
+            }
+
+            bool was_initialized() const
+            {
+                return m_ptr != nullptr;
+            }
+
+            operator const T& () const
+            {
+                CPPSPT_ASSERT(m_ptr != nullptr && "Attempting to read from uninit value!");
+
+                return *m_ptr;
+            }
+
+            operator T& ()
+            {
+                CPPSPT_ASSERT(m_ptr != nullptr && "Attempting to read from uninit value!");
+
+                return *m_ptr;
+            }
+
+            T& operator*() { return static_cast<T&>(*this); }
+            T* operator->() { return &static_cast<T&>(*this); }
+            const T& operator*() const { return static_cast<const T&>(*this); }
+            const T* operator->() const { return &static_cast<const T&>(*this); }
+
+            //Lets an uninit_box be passed as an out parameter (which allocates the value on the first write)
+            operator out<T>() { return out<T>(box_slot<T>{ &m_ptr }); }
+
+            friend std::ostream& operator<< (std::ostream& out, const uninit_box& val)
+            {
+                if (val.was_initialized())
+                {
+                    return out << *val.m_ptr;
+                }
+                return out << "[Uninitialized]";
+            }
+        };
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_BOX_HPP
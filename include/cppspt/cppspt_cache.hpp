@@ -0,0 +1,445 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_CACHE_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_CACHE_HPP
+
+/*
+
+    A fixed-capacity cache with CLOCK eviction, whose entries are preallocated uninit slots
+
+    put(key, in<V>) has the shape of the example's simple_map: keys & values are moved in if the caller moved, and copied otherwise.
+    get(key, out<V>) writes a hit straight into the caller's storage.
+
+    Every entry slot, and the open addressing index over them, is allocated when the cache is created.
+    An evicted entry's key & value are assigned over (rather than destroyed and rebuilt), so once the cache is full
+    no operation allocates, unless assigning a K or V does.
+
+    CLOCK keeps a referenced bit per entry, set on every hit. To evict, a hand sweeps the entries,
+    clearing the bits it passes, and takes the first entry whose bit is already clear.
+
+    Keys are taken as a hashed_in<K, Hash>, which converts from a K (or an in<K>) like an in does,
+    so a key hashed by an outer layer isn't hashed again.
+    sharded_clock_cache splits the entries over several locked caches, chosen by the key's hash.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_hashed.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename K, typename V, typename Hash, typename Equal>
+        class clock_cache;
+
+        template<typename K, typename V, typename Hash, typename Equal>
+        class sharded_clock_cache;
+    }
+
+    /// <summary>
+    /// A fixed-capacity key-value cache with CLOCK eviction. Not thread-safe
+    /// </summary>
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+    using clock_cache = detail::clock_cache<K, V, Hash, Equal>;
+
+    /// <summary>
+    /// A clock_cache split into independently locked shards. Thread-safe
+    /// </summary>
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+    using sharded_clock_cache = detail::sharded_clock_cache<K, V, Hash, Equal>;
+
+    namespace detail
+    {
+        //Spreads a hash over the high bits, which pick the index position (Fibonacci hashing)
+        inline std::size_t cache_position(std::size_t hash, unsigned bits)
+        {
+            return static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+        }
+
+        template<typename K, typename V, typename Hash, typename Equal>
+        class clock_cache final
+        {
+        private:
+            struct entry
+            {
+                uninit<K> key;
+                uninit<V> value;
+                std::size_t hash;
+                bool referenced;
+            };
+
+            using index_type = std::uint32_t;
+
+            //An empty index slot. Otherwise a slot holds its entry's number plus one
+            static const index_type empty_slot = 0;
+
+            std::unique_ptr<entry[]> m_entries;
+            std::size_t m_capacity;
+            std::size_t m_size;             //Entries in use (only grows, until the cache is full)
+            std::size_t m_hand;             //The next entry the clock looks at
+
+            std::unique_ptr<index_type[]> m_index;
+            unsigned m_index_bits;
+
+            //Entries freed by erase, reused before the clock evicts
+            std::unique_ptr<index_type[]> m_free;
+            std::size_t m_free_count;
+
+            std::size_t index_mask() const { return (std::size_t(1) << m_index_bits) - 1; }
+
+            //Returns the index position holding key, or the empty position where it would go
+            std::size_t locate(const K& key, std::size_t hash) const
+            {
+                std::size_t pos = cache_position(hash, m_index_bits);
+                for (;;)
+                {
+                    index_type slot = m_index[pos];
+                    if (slot == empty_slot)
+                    {
+                        return pos;
+                    }
+
+                    const entry& e = m_entries[slot - 1];
+                    if (e.hash == hash && Equal()(*e.key, key))
+                    {
+                        return pos;
+                    }
+                    pos = (pos + 1) & index_mask();
+                }
+            }
+
+            //Removes an index position, shifting later entries of its probe run back so that lookups never see a gap
+            void unlink(std::size_t pos)
+            {
+                std::size_t next = pos;
+                for (;;)
+                {
+                    next = (next + 1) & index_mask();
+                    index_type slot = m_index[next];
+                    if (slot == empty_slot)
+                    {
+                        break;
+                    }
+
+                    //The entry at next can move back to pos, unless its home position lies cyclically in (pos, next]
+                    std::size_t home = cache_position(m_entries[slot - 1].hash, m_index_bits);
+                    bool stays = (pos <= next) ? (pos < home && home <= next) : (pos < home || home <= next);
+                    if (!stays)
+                    {
+                        m_index[pos] = slot;
+                        pos = next;
+                    }
+                }
+                m_index[pos] = empty_slot;
+            }
+
+            //Picks an entry to hold a new key: a free one, an unused one, or the clock's victim (which is unlinked)
+            std::size_t claim_entry()
+            {
+                if (m_free_count != 0)
+                {
+                    return m_free[--m_free_count];
+                }
+                if (m_size < m_capacity)
+                {
+                    return m_size++;
+                }
+
+                for (;;)
+                {
+                    std::size_t victim = m_hand;
+                    m_hand = (m_hand + 1 == m_capacity) ? 0 : m_hand + 1;
+
+                    entry& e = m_entries[victim];
+                    if (!e.key.was_initialized())
+                    {
+                        continue;
+                    }
+                    if (e.referenced)
+                    {
+                        e.referenced = false;
+                        continue;
+                    }
+
+                    unlink(locate(*e.key, e.hash));
+                    return victim;
+                }
+            }
+
+        public:
+            /// <summary>
+            /// Creates a cache holding up to capacity entries. Allocates every entry, and the index, up front
+            /// </summary>
+            explicit clock_cache(std::size_t capacity) :
+                m_entries(new entry[capacity]),
+                m_capacity(capacity),
+                m_size(0),
+                m_hand(0),
+                m_index_bits(1),
+                m_free(new index_type[capacity]),
+                m_free_count(0)
+            {
+                CPPSPT_ASSERT(capacity != 0 && capacity < (std::size_t(1) << 31) && "CPPSPT: unsupported clock_cache capacity!");
+
+                //At most half full, so probe runs stay short
+                while ((std::size_t(1) << m_index_bits) < capacity * 2)
+                {
+                    m_index_bits++;
+                }
+                m_index.reset(new index_type[std::size_t(1) << m_index_bits]());
+            }
+
+            clock_cache(const clock_cache&) = delete;
+            clock_cache& operator=(const clock_cache&) = delete;
+
+            std::size_t capacity() const { return m_capacity; }
+
+            std::size_t size() const { return m_size - m_free_count; }
+
+            /// <summary>
+            /// Writes the value of key into dest, and marks it as recently used. Returns false (leaving dest alone) on a miss
+            /// </summary>
+            bool get(hashed_in<K, Hash> key, out<V> dest)
+            {
+                index_type slot = m_index[locate(*key, key.hash())];
+                if (slot == empty_slot)
+                {
+                    return false;
+                }
+
+                entry& e = m_entries[slot - 1];
+                e.referenced = true;
+                dest = *e.value;
+                return true;
+            }
+
+            /// <summary>
+            /// The value of key (valid until the next put or erase), or nullptr. Marks it as recently used
+            /// </summary>
+            const V* find(hashed_in<K, Hash> key)
+            {
+                index_type slot = m_index[locate(*key, key.hash())];
+                if (slot == empty_slot)
+                {
+                    return nullptr;
+                }
+
+                entry& e = m_entries[slot - 1];
+                e.referenced = true;
+                return &*e.value;
+            }
+
+            /// <summary>
+            /// Inserts or replaces the value of key, evicting an entry if the cache is full
+            /// </summary>
+            void put(hashed_in<K, Hash> key, in<V> value)
+            {
+                std::size_t pos = locate(*key, key.hash());
+                if (m_index[pos] != empty_slot)
+                {
+                    entry& e = m_entries[m_index[pos] - 1];
+                    e.value = std::move(value);
+                    e.referenced = true;
+                    return;
+                }
+
+                bool evicting = (m_free_count == 0 && m_size == m_capacity);
+                std::size_t claimed = claim_entry();
+
+                //Evicting may have shifted the run that pos was found in
+                if (evicting)
+                {
+                    pos = locate(*key, key.hash());
+                }
+
+                //An evicted entry is assigned over, which reuses whatever the old key & value own.
+                //If that throws, the (unlinked) entry is emptied and freed, so it isn't lost or left half filled
+                entry& e = m_entries[claimed];
+                try
+                {
+                    e.key = std::move(key.key());
+                    e.value = std::move(value);
+                }
+                catch (...)
+                {
+                    e.key.reset();
+                    e.value.reset();
+                    e.referenced = false;
+                    m_free[m_free_count++] = static_cast<index_type>(claimed);
+                    throw;
+                }
+                e.hash = key.hash();
+                e.referenced = false;
+                m_index[pos] = static_cast<index_type>(claimed + 1);
+            }
+
+            /// <summary>
+            /// Removes key, destroying its key & value. Returns false if it wasn't cached
+            /// </summary>
+            bool erase(hashed_in<K, Hash> key)
+            {
+                std::size_t pos = locate(*key, key.hash());
+                if (m_index[pos] == empty_slot)
+                {
+                    return false;
+                }
+
+                std::size_t removed = m_index[pos] - 1;
+                unlink(pos);
+
+                entry& e = m_entries[removed];
+                e.key.reset();
+                e.value.reset();
+                e.referenced = false;
+                m_free[m_free_count++] = static_cast<index_type>(removed);
+                return true;
+            }
+
+            /// <summary>
+            /// Removes every entry. Keeps the allocated slots
+            /// </summary>
+            void clear()
+            {
+                for (std::size_t i = 0; i < m_size; i++)
+                {
+                    m_entries[i].key.reset();
+                    m_entries[i].value.reset();
+                    m_entries[i].referenced = false;
+                }
+                for (std::size_t i = 0; i <= index_mask(); i++)
+                {
+                    m_index[i] = empty_slot;
+                }
+                m_size = 0;
+                m_hand = 0;
+                m_free_count = 0;
+            }
+        };
+
+        /*
+
+            Sharded cache: the key's hash picks a shard (from bits the shard's index doesn't use for positions),
+            and the shard's lock is only held for that operation
+
+        */
+
+        template<typename K, typename V, typename Hash, typename Equal>
+        class sharded_clock_cache final
+        {
+        private:
+            //Padded (and aligned) to whole cache lines, so no two shards share one
+            struct alignas(cache_line_size) shard
+            {
+                std::mutex lock;
+                clock_cache<K, V, Hash, Equal> cache;
+
+                explicit shard(std::size_t capacity) : cache(capacity) {}
+            };
+
+            void* m_allocation;
+            shard* m_shards;
+            std::size_t m_shard_count;
+
+            void destroy_shards()
+            {
+                for (std::size_t i = 0; i < m_shard_count; i++)
+                {
+                    m_shards[i].~shard();
+                }
+                ::operator delete(m_allocation);
+            }
+
+            shard& shard_for(std::size_t hash)
+            {
+                return m_shards[static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * 0xC2B2AE3D27D4EB4Full) >> 32) % m_shard_count];
+            }
+
+        public:
+            /// <summary>
+            /// Creates shard_count shards, sharing capacity between them
+            /// </summary>
+            sharded_clock_cache(std::size_t capacity, std::size_t shard_count) :
+                m_allocation(nullptr),
+                m_shards(nullptr),
+                m_shard_count(0)
+            {
+                CPPSPT_ASSERT(shard_count != 0 && "CPPSPT: a sharded_clock_cache needs a shard!");
+
+                //Operator new only guarantees fundamental alignment before C++17; align by hand
+                m_allocation = ::operator new(shard_count * sizeof(shard) + alignof(shard));
+                std::uintptr_t address = reinterpret_cast<std::uintptr_t>(m_allocation);
+                m_shards = reinterpret_cast<shard*>((address + alignof(shard) - 1) & ~static_cast<std::uintptr_t>(alignof(shard) - 1));
+
+                try
+                {
+                    for (; m_shard_count < shard_count; m_shard_count++)
+                    {
+                        new (m_shards + m_shard_count) shard((capacity + shard_count - 1) / shard_count);
+                    }
+                }
+                catch (...)
+                {
+                    destroy_shards();
+                    throw;
+                }
+            }
+
+            ~sharded_clock_cache()
+            {
+                destroy_shards();
+            }
+
+            sharded_clock_cache(const sharded_clock_cache&) = delete;
+            sharded_clock_cache& operator=(const sharded_clock_cache&) = delete;
+
+            std::size_t shard_count() const { return m_shard_count; }
+
+            bool get(hashed_in<K, Hash> key, out<V> dest)
+            {
+                shard& s = shard_for(key.hash());
+                std::lock_guard<std::mutex> guard(s.lock);
+                return s.cache.get(std::move(key), dest);
+            }
+
+            void put(hashed_in<K, Hash> key, in<V> value)
+            {
+                shard& s = shard_for(key.hash());
+                std::lock_guard<std::mutex> guard(s.lock);
+                s.cache.put(std::move(key), std::move(value));
+            }
+
+            bool erase(hashed_in<K, Hash> key)
+            {
+                shard& s = shard_for(key.hash());
+                std::lock_guard<std::mutex> guard(s.lock);
+                return s.cache.erase(std::move(key));
+            }
+
+            std::size_t size()
+            {
+                std::size_t result = 0;
+                for (std::size_t i = 0; i < m_shard_count; i++)
+                {
+                    std::lock_guard<std::mutex> guard(m_shards[i].lock);
+                    result += m_shards[i].cache.size();
+                }
+                return result;
+            }
+        };
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_CACHE_HPP
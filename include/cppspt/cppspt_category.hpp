@@ -43,7 +43,7 @@ namespace cppspt
     {
         if (arg->was_initialized())
         {
-            return func(*((const uninit<Arg>&)arg));
+            return uninit<Ret>(func(*((const uninit<Arg>&)arg)));
         }
         else
         {
@@ -0,0 +1,501 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_COLUMN_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_COLUMN_HPP
+
+/*
+
+    A columnar representation of many uninit values: a dense buffer of values,
+    plus a validity bitmap with one bit per value (set when the value is initialized)
+
+    The functor & monad operations in cppspt_category.hpp work on one uninit at a time.
+    The bulk versions here run over the whole value buffer without branching,
+    so that they can be vectorized, and combine validity one 64-bit word at a time.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename T>
+        class uninit_column;
+    }
+
+    /// <summary>
+    /// A column of possibly uninitialized values, stored as a value buffer plus a validity bitmap.
+    /// T must be trivially copyable and default constructible; uninitialized slots hold T()
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using uninit_column = detail::uninit_column<T>;
+
+    namespace detail
+    {
+        using validity_word = std::uint64_t;
+
+        static const std::size_t validity_word_bits = 64;
+
+        inline std::size_t validity_word_count(std::size_t size)
+        {
+            return (size + validity_word_bits - 1) / validity_word_bits;
+        }
+
+        inline int validity_popcount(validity_word word)
+        {
+#if defined (_MSC_VER) && !defined (__clang__)
+            int count = 0;
+            for (; word != 0; word &= word - 1)
+            {
+                count++;
+            }
+            return count;
+#else
+            return __builtin_popcountll(word);
+#endif
+        }
+
+        inline int validity_lowest_bit(validity_word word)
+        {
+#if defined (_MSC_VER) && !defined (__clang__)
+            int bit = 0;
+            while ((word & 1) == 0)
+            {
+                word >>= 1;
+                bit++;
+            }
+            return bit;
+#else
+            return __builtin_ctzll(word);
+#endif
+        }
+
+        template<typename T>
+        class uninit_column final
+        {
+        private:
+            //A plain buffer rather than a vector, which for bool would be packed & have no data()
+            std::unique_ptr<T[]> m_values;
+            std::size_t m_size = 0;
+            std::size_t m_capacity = 0;
+            std::vector<validity_word> m_validity;
+
+            void check_type() const
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "CPPSPT: uninit_column requires a trivially copyable type!");
+                static_assert(std::is_default_constructible<T>::value, "CPPSPT: uninit_column requires a default constructible type!");
+            }
+
+            void grow(std::size_t capacity)
+            {
+                std::unique_ptr<T[]> values(new T[capacity]());
+                std::copy(m_values.get(), m_values.get() + m_size, values.get());
+                m_values = std::move(values);
+                m_capacity = capacity;
+            }
+
+            //Bits past the end of the column are always kept clear
+            void clear_tail()
+            {
+                std::size_t tail = m_size % validity_word_bits;
+                if (tail != 0)
+                {
+                    m_validity.back() &= (validity_word(1) << tail) - 1;
+                }
+            }
+
+        public:
+            uninit_column() { check_type(); }
+
+            explicit uninit_column(std::size_t size) :
+                m_values(new T[size]()),
+                m_size(size),
+                m_capacity(size),
+                m_validity(validity_word_count(size), 0)
+            {
+                check_type();
+            }
+
+            uninit_column(const uninit_column& other) :
+                m_values(new T[other.m_size]()),
+                m_size(other.m_size),
+                m_capacity(other.m_size),
+                m_validity(other.m_validity)
+            {
+                std::copy(other.m_values.get(), other.m_values.get() + other.m_size, m_values.get());
+            }
+
+            uninit_column(uninit_column&& other) noexcept :
+                m_values(std::move(other.m_values)),
+                m_size(other.m_size),
+                m_capacity(other.m_capacity),
+                m_validity(std::move(other.m_validity))
+            {
+                other.m_size = 0;
+                other.m_capacity = 0;
+            }
+
+            uninit_column& operator=(const uninit_column& other)
+            {
+                if (this != &other)
+                {
+                    uninit_column copy(other);
+                    *this = std::move(copy);
+                }
+                return *this;
+            }
+
+            uninit_column& operator=(uninit_column&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    m_values = std::move(other.m_values);
+                    m_size = other.m_size;
+                    m_capacity = other.m_capacity;
+                    m_validity = std::move(other.m_validity);
+                    other.m_size = 0;
+                    other.m_capacity = 0;
+                }
+                return *this;
+            }
+
+            std::size_t size() const { return m_size; }
+
+            void reserve(std::size_t size)
+            {
+                if (size > m_capacity)
+                {
+                    grow(size);
+                }
+                m_validity.reserve(validity_word_count(size));
+            }
+
+            void resize(std::size_t size)
+            {
+                if (size > m_capacity)
+                {
+                    grow(size);
+                }
+                //Slots being added may hold values from before a shrink
+                for (std::size_t i = m_size; i < size; i++)
+                {
+                    m_values[i] = T();
+                }
+                m_size = size;
+                m_validity.resize(validity_word_count(size), 0);
+                clear_tail();
+            }
+
+            void push_back(in<T> val)
+            {
+                //Read before growing, as val may be one of this column's values
+                T value = *val;
+                std::size_t index = m_size;
+                if (m_size == m_capacity)
+                {
+                    grow(m_capacity < 8 ? 8 : m_capacity * 2);
+                }
+                m_values[m_size++] = value;
+                if (index % validity_word_bits == 0)
+                {
+                    m_validity.push_back(0);
+                }
+                m_validity.back() |= validity_word(1) << (index % validity_word_bits);
+            }
+
+            void push_back(unititialized_t)
+            {
+                std::size_t index = m_size;
+                if (m_size == m_capacity)
+                {
+                    grow(m_capacity < 8 ? 8 : m_capacity * 2);
+                }
+                m_values[m_size++] = T();
+                if (index % validity_word_bits == 0)
+                {
+                    m_validity.push_back(0);
+                }
+            }
+
+            void push_back(const uninit<T>& val)
+            {
+                if (val.was_initialized())
+                {
+                    push_back(in<T>(*val));
+                }
+                else
+                {
+                    push_back(unitialized_t);
+                }
+            }
+
+            bool was_initialized(std::size_t index) const
+            {
+                return (m_validity[index / validity_word_bits] >> (index % validity_word_bits)) & 1;
+            }
+
+            void set(std::size_t index, in<T> val)
+            {
+                m_values[index] = *val;
+                m_validity[index / validity_word_bits] |= validity_word(1) << (index % validity_word_bits);
+            }
+
+            void reset(std::size_t index)
+            {
+                m_values[index] = T();
+                m_validity[index / validity_word_bits] &= ~(validity_word(1) << (index % validity_word_bits));
+            }
+
+            const T& operator[](std::size_t index) const
+            {
+                CPPSPT_ASSERT(was_initialized(index) && "Attempting to read from uninit value!");
+
+                return m_values[index];
+            }
+
+            uninit<T> get(std::size_t index) const
+            {
+                if (was_initialized(index))
+                {
+                    return uninit<T>(in<T>(m_values[index]));
+                }
+                return unitialized_t;
+            }
+
+            //Number of initialized values
+            std::size_t count() const
+            {
+                std::size_t count = 0;
+                for (validity_word word : m_validity)
+                {
+                    count += validity_popcount(word);
+                }
+                return count;
+            }
+
+            //Raw access for the bulk operations
+            T* values() { return m_values.get(); }
+            const T* values() const { return m_values.get(); }
+
+            validity_word* validity() { return m_validity.data(); }
+            const validity_word* validity() const { return m_validity.data(); }
+
+            std::size_t word_count() const { return m_validity.size(); }
+        };
+    }
+
+    /*
+
+        Bulk functor & monad operations for uninit_column
+
+        Unlike the single value versions, these take any callable, so that the call can be inlined into the loop.
+        The callable is applied to uninitialized slots too (which hold T()), so it must be safe to call on those values.
+
+    */
+
+    /// <summary>
+    /// Applies func to every value of the column. The result has the same validity as the argument
+    /// </summary>
+    template<typename Func, typename Arg>
+    auto fapply(Func func, const uninit_column<Arg>& arg) -> uninit_column<decltype(func(std::declval<const Arg&>()))>
+    {
+        using Ret = decltype(func(std::declval<const Arg&>()));
+
+        uninit_column<Ret> result(arg.size());
+
+        const Arg* src = arg.values();
+        Ret* dst = result.values();
+        const std::size_t size = arg.size();
+        for (std::size_t i = 0; i < size; i++)
+        {
+            dst[i] = func(src[i]);
+        }
+
+        const detail::validity_word* src_valid = arg.validity();
+        detail::validity_word* dst_valid = result.validity();
+        for (std::size_t w = 0; w < arg.word_count(); w++)
+        {
+            dst_valid[w] = src_valid[w];
+        }
+
+        return result;
+    }
+
+    /// <summary>
+    /// Applies func pairwise to the values of two columns of the same size.
+    /// A result is only initialized when both arguments are
+    /// </summary>
+    template<typename Func, typename Arg1, typename Arg2>
+    auto fapply(Func func, const uninit_column<Arg1>& arg1, const uninit_column<Arg2>& arg2)
+        -> uninit_column<decltype(func(std::declval<const Arg1&>(), std::declval<const Arg2&>()))>
+    {
+        using Ret = decltype(func(std::declval<const Arg1&>(), std::declval<const Arg2&>()));
+
+        CPPSPT_ASSERT(arg1.size() == arg2.size() && "Applying to columns of different sizes!");
+
+        uninit_column<Ret> result(arg1.size());
+
+        const Arg1* src1 = arg1.values();
+        const Arg2* src2 = arg2.values();
+        Ret* dst = result.values();
+        const std::size_t size = arg1.size();
+        for (std::size_t i = 0; i < size; i++)
+        {
+            dst[i] = func(src1[i], src2[i]);
+        }
+
+        const detail::validity_word* valid1 = arg1.validity();
+        const detail::validity_word* valid2 = arg2.validity();
+        detail::validity_word* dst_valid = result.validity();
+        for (std::size_t w = 0; w < arg1.word_count(); w++)
+        {
+            dst_valid[w] = valid1[w] & valid2[w];
+        }
+
+        return result;
+    }
+
+    /// <summary>
+    /// Applies func, which itself returns an uninit, to every initialized value of the column.
+    /// Words with no initialized values are skipped entirely
+    /// </summary>
+    template<typename Func, typename Arg>
+    auto mbind(const uninit_column<Arg>& arg, Func func) -> uninit_column<typename std::decay<decltype(*func(std::declval<const Arg&>()))>::type>
+    {
+        using Ret = typename std::decay<decltype(*func(std::declval<const Arg&>()))>::type;
+
+        uninit_column<Ret> result(arg.size());
+
+        const Arg* src = arg.values();
+        Ret* dst = result.values();
+        const detail::validity_word* src_valid = arg.validity();
+        detail::validity_word* dst_valid = result.validity();
+
+        for (std::size_t w = 0; w < arg.word_count(); w++)
+        {
+            detail::validity_word word = src_valid[w];
+            detail::validity_word valid = 0;
+            while (word != 0)
+            {
+                int bit = detail::validity_lowest_bit(word);
+                word &= word - 1;
+
+                std::size_t index = w * detail::validity_word_bits + bit;
+                const auto ret = func(src[index]);
+                if (ret.was_initialized())
+                {
+                    dst[index] = *ret;
+                    valid |= detail::validity_word(1) << bit;
+                }
+            }
+            dst_valid[w] = valid;
+        }
+
+        return result;
+    }
+
+    /// <summary>
+    /// Keeps only the initialized values for which pred returns true.
+    /// The predicate is evaluated into a mask for each word, then combined with the validity
+    /// </summary>
+    template<typename Pred, typename T>
+    uninit_column<T> filter(const uninit_column<T>& arg, Pred pred)
+    {
+        uninit_column<T> result = arg;
+
+        const T* src = arg.values();
+        detail::validity_word* dst_valid = result.validity();
+        const std::size_t size = arg.size();
+
+        for (std::size_t w = 0; w < arg.word_count(); w++)
+        {
+            const std::size_t begin = w * detail::validity_word_bits;
+            const std::size_t end = (begin + detail::validity_word_bits < size) ? begin + detail::validity_word_bits : size;
+
+            detail::validity_word mask = 0;
+            for (std::size_t i = begin; i < end; i++)
+            {
+                mask |= detail::validity_word(pred(src[i]) ? 1 : 0) << (i - begin);
+            }
+            dst_valid[w] &= mask;
+        }
+
+        return result;
+    }
+
+    namespace detail
+    {
+        static const std::size_t reduce_lanes = 4;
+    }
+
+    /// <summary>
+    /// Folds op over the initialized values of the column, starting from identity.
+    /// Uninitialized values are replaced by identity, so op(x, identity) must equal x.
+    /// The values are folded into several independent accumulators, so that the calls to op
+    /// do not form one serial dependency chain, and then combined: op must be associative and commutative
+    /// (for floating point, the result may differ from a left to right fold in its rounding)
+    /// </summary>
+    template<typename Op, typename T>
+    T reduce(const uninit_column<T>& arg, T identity, Op op)
+    {
+        T acc[detail::reduce_lanes];
+        for (T& lane : acc)
+        {
+            lane = identity;
+        }
+        bool any = false;
+
+        const T* src = arg.values();
+        const detail::validity_word* src_valid = arg.validity();
+        const std::size_t size = arg.size();
+
+        for (std::size_t w = 0; w < arg.word_count(); w++)
+        {
+            const std::size_t begin = w * detail::validity_word_bits;
+            const std::size_t end = (begin + detail::validity_word_bits < size) ? begin + detail::validity_word_bits : size;
+            const detail::validity_word word = src_valid[w];
+
+            if (word == 0)
+            {
+                continue;
+            }
+            any = true;
+
+            std::size_t i = begin;
+            for (; i + detail::reduce_lanes <= end; i += detail::reduce_lanes)
+            {
+                for (std::size_t lane = 0; lane < detail::reduce_lanes; lane++)
+                {
+                    const bool valid = (word >> (i + lane - begin)) & 1;
+                    acc[lane] = op(acc[lane], valid ? src[i + lane] : identity);
+                }
+            }
+            for (; i < end; i++)
+            {
+                const bool valid = (word >> (i - begin)) & 1;
+                acc[0] = op(acc[0], valid ? src[i] : identity);
+            }
+        }
+
+        if (!any)
+        {
+            return identity;
+        }
+        return op(op(acc[0], acc[1]), op(acc[2], acc[3]));
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_COLUMN_HPP
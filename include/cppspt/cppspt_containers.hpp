@@ -0,0 +1,178 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_CONTAINERS_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_CONTAINERS_HPP
+
+/*
+
+    Inserting in parameters into standard containers
+
+    Resolving an in<T> and then inserting the result constructs a T, then moves it again into the container.
+    These helpers construct the element once, directly in the container: by move if the caller moved, and by copy otherwise.
+
+    emplace_in: appends to a sequence container (std::vector, std::deque, std::list)
+    try_emplace_in: inserts into a map (std::map, std::unordered_map) unless the key is present.
+        The key is looked up through the in first, so nothing is constructed for a key that is already there.
+
+    The _all_in variants insert a range, reserving space once for containers that can reserve.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <utility>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        //Calls func with the value of an in: as an rvalue if it was moved, and as a const reference otherwise
+        template<typename T, typename Func>
+        auto visit_in(in<T>& val, Func&& func) -> decltype(func(std::declval<const T&>()))
+        {
+            if (val.was_moved())
+            {
+                return func(val.move_out());
+            }
+            return func(val.unmoved_ref());
+        }
+
+        //Reserves room for count more elements, if the container can reserve
+        template<typename Container>
+        auto reserve_more(Container& container, std::size_t count, int) -> decltype(container.reserve(count), void())
+        {
+            container.reserve(container.size() + count);
+        }
+
+        template<typename Container>
+        void reserve_more(Container&, std::size_t, long)
+        {
+        }
+
+        //The length of a range, when it can be known without consuming it
+        template<typename It>
+        std::size_t range_length(It first, It last, std::forward_iterator_tag)
+        {
+            return static_cast<std::size_t>(std::distance(first, last));
+        }
+
+        template<typename It>
+        std::size_t range_length(It, It, std::input_iterator_tag)
+        {
+            return 0;
+        }
+
+        template<typename Container, typename It>
+        void reserve_for_range(Container& container, It first, It last)
+        {
+            reserve_more(container, range_length(first, last, typename std::iterator_traits<It>::iterator_category()), 0);
+        }
+
+        //Ordered maps have a key_compare, and can insert at the position found by the lookup
+        template<typename Map, typename = void>
+        struct is_ordered_map : std::false_type {};
+
+        template<typename Map>
+        struct is_ordered_map<Map, decltype(std::declval<typename Map::key_compare>(), void())> : std::true_type {};
+
+        template<typename Map>
+        std::pair<typename Map::iterator, bool> emplace_new(Map& map, typename Map::iterator hint, in<typename Map::key_type>& key, in<typename Map::mapped_type>& val)
+        {
+            typename Map::iterator result = visit_in(key, [&](auto&& k)
+            {
+                return visit_in(val, [&](auto&& v)
+                {
+                    return map.emplace_hint(hint, std::piecewise_construct,
+                        std::forward_as_tuple(std::forward<decltype(k)>(k)),
+                        std::forward_as_tuple(std::forward<decltype(v)>(v)));
+                });
+            });
+            return std::make_pair(result, true);
+        }
+
+        template<typename Map>
+        std::pair<typename Map::iterator, bool> try_emplace_in(Map& map, in<typename Map::key_type>& key, in<typename Map::mapped_type>& val, std::true_type)
+        {
+            typename Map::iterator hint = map.lower_bound(*key);
+            if (hint != map.end() && !map.key_comp()(*key, hint->first))
+            {
+                return std::make_pair(hint, false);
+            }
+            return emplace_new(map, hint, key, val);
+        }
+
+        template<typename Map>
+        std::pair<typename Map::iterator, bool> try_emplace_in(Map& map, in<typename Map::key_type>& key, in<typename Map::mapped_type>& val, std::false_type)
+        {
+            typename Map::iterator found = map.find(*key);
+            if (found != map.end())
+            {
+                return std::make_pair(found, false);
+            }
+            return emplace_new(map, map.end(), key, val);
+        }
+    }
+
+    /// <summary>
+    /// Appends a value to a sequence container, constructing it once in place. Returns the new element
+    /// </summary>
+    template<typename Container>
+    typename Container::reference emplace_in(Container& container, in<typename Container::value_type> val)
+    {
+        return detail::visit_in(val, [&](auto&& v) -> typename Container::reference
+        {
+            container.emplace_back(std::forward<decltype(v)>(v));
+            return container.back();
+        });
+    }
+
+    /// <summary>
+    /// Appends every value in [first, last), reserving space once. Values are copied, unless the iterators are move iterators
+    /// </summary>
+    template<typename Container, typename It>
+    void emplace_all_in(Container& container, It first, It last)
+    {
+        detail::reserve_for_range(container, first, last);
+        for (; first != last; ++first)
+        {
+            emplace_in(container, *first);
+        }
+    }
+
+    /// <summary>
+    /// Inserts key and val into a map, unless the key is already present.
+    /// The key is looked up through the in, and nothing is constructed when it is found.
+    /// Returns the element with the key, and whether it was inserted
+    /// </summary>
+    template<typename Map>
+    std::pair<typename Map::iterator, bool> try_emplace_in(Map& map, in<typename Map::key_type> key, in<typename Map::mapped_type> val)
+    {
+        return detail::try_emplace_in(map, key, val, detail::is_ordered_map<Map>());
+    }
+
+    /// <summary>
+    /// Inserts every (key, value) pair in [first, last) whose key is not present, reserving space once.
+    /// Pairs are copied, unless the iterators are move iterators
+    /// </summary>
+    template<typename Map, typename It>
+    void try_emplace_all_in(Map& map, It first, It last)
+    {
+        detail::reserve_for_range(map, first, last);
+        for (; first != last; ++first)
+        {
+            auto&& pair = *first;
+            try_emplace_in(map,
+                in<typename Map::key_type>(std::forward<decltype(pair)>(pair).first),
+                in<typename Map::mapped_type>(std::forward<decltype(pair)>(pair).second));
+        }
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_CONTAINERS_HPP
@@ -0,0 +1,157 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_COW_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_COW_HPP
+
+/*
+
+    A copy-on-write input parameter
+
+    A function that takes an in<T> and only sometimes modifies it has to resolve a local copy up front.
+    in_cow<T> reads through the caller's reference, and only copies on the first mutable access.
+    If the caller moved, the value is the callee's to modify in place, so it is never copied (or moved).
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <ostream>
+#include <utility>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename T>
+        class in_cow;
+    }
+
+    /// <summary>
+    /// An input parameter that borrows the caller's value, and copies it on the first mutable access.
+    /// Captures a const reference or a move (which can be modified in place)
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using in_cow = detail::in_cow<T>;
+
+    namespace detail
+    {
+        template<typename T>
+        class in_cow final
+        {
+        private:
+            T* m_ptr;               //The current value: the caller's, or the copy
+            bool m_writable;        //Whether the current value may be modified (the caller moved, or it is the copy)
+            uninit<T> m_copy;       //Only constructed on the first mutable access to a borrowed value
+
+            static T* target(in<T>& val)
+            {
+                if (val.was_moved())
+                {
+                    T&& moved = val.move_out();
+                    return &moved;
+                }
+                return const_cast<T*>(&val.unmoved_ref());
+            }
+
+        public:
+            in_cow(const_ref<T> val) :
+                m_ptr(const_cast<T*>(&val)),
+                m_writable(false)
+            {
+            }
+
+            in_cow(move<T> val) :
+                m_ptr(&val),
+                m_writable(true)
+            {
+            }
+
+            //Captures the value of an in, borrowing it or taking it over the same way
+            in_cow(in<T> val) :
+                m_ptr(target(val)),
+                m_writable(val.was_moved())
+            {
+            }
+
+            in_cow(move<in_cow<T>> other) :
+                m_ptr(other.m_ptr),
+                m_writable(other.m_writable),
+                m_copy(std::move(other.m_copy))
+            {
+                if (m_copy.was_initialized())
+                {
+                    m_ptr = &*m_copy;
+                }
+            }
+
+            in_cow(const_ref<in_cow<T>>) = delete;
+            in_cow& operator=(const_ref<in_cow<T>>) = delete;
+
+            operator const T& () const
+            {
+                return *m_ptr;
+            }
+
+            const T& operator*() const
+            {
+                return *m_ptr;
+            }
+
+            const T* operator->() const
+            {
+                return m_ptr;
+            }
+
+            /// <summary>
+            /// The value, for modifying. Copies a borrowed value the first time
+            /// </summary>
+            T& mut()
+            {
+                if (!m_writable)
+                {
+                    m_copy.init(*m_ptr);
+                    m_ptr = &*m_copy;
+                    m_writable = true;
+                }
+                return *m_ptr;
+            }
+
+            bool was_copied() const { return m_copy.was_initialized(); }
+            bool is_borrowed() const { return !m_writable; }
+
+            /// <summary>
+            /// Takes the value: moves it if the caller moved (or it was copied), and copies it otherwise.
+            /// The in_cow can no longer be read from
+            /// </summary>
+            T take()
+            {
+                if (m_writable)
+                {
+                    return std::move(*m_ptr);
+                }
+                return *m_ptr;
+            }
+
+            friend std::ostream& operator<< (std::ostream& out, const in_cow<T>& val)
+            {
+                return out << *val;
+            }
+        };
+    }
+
+    /// <summary>
+    /// Converts an in_cow into the underlying type, copying only if the value is still borrowed
+    /// </summary>
+    template<typename T>
+    T resolve(inout<in_cow<T>> param)
+    {
+        return param.take();
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_COW_HPP
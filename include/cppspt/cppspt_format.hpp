@@ -0,0 +1,148 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_FORMAT_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_FORMAT_HPP
+
+/*
+
+    Formatting for uninit, in and out, which reads through a const reference and writes straight into the destination
+
+    to_chars (C++17): for arithmetic T, writes into a char buffer like std::to_chars
+    std::formatter (C++20, when <format> is available): formats like the underlying T, with the same format specs
+
+    (The stream operators are in cppspt.hpp)
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#if CPPSPT_CPLUSPLUS >= 201703L
+
+#include <charconv>
+#include <cstring>
+#include <system_error>
+
+#if defined (__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#if defined (__cpp_lib_format)
+#include <format>
+#endif
+
+namespace cppspt
+{
+    namespace detail
+    {
+        static const char uninitialized_text[] = "[Uninitialized]";
+
+        inline std::to_chars_result write_uninitialized(char* first, char* last)
+        {
+            const std::size_t length = sizeof(uninitialized_text) - 1;
+            if (static_cast<std::size_t>(last - first) < length)
+            {
+                return { last, std::errc::value_too_large };
+            }
+            std::memcpy(first, uninitialized_text, length);
+            return { first + length, std::errc() };
+        }
+    }
+
+    /// <summary>
+    /// Writes an uninit arithmetic value into [first, last), or "[Uninitialized]"
+    /// </summary>
+    template<typename T, typename ... Args, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    std::to_chars_result to_chars(char* first, char* last, const uninit<T>& val, Args ... args)
+    {
+        if (!val.was_initialized())
+        {
+            return detail::write_uninitialized(first, last);
+        }
+        return std::to_chars(first, last, *val, args...);
+    }
+
+    /// <summary>
+    /// Writes an in arithmetic value into [first, last)
+    /// </summary>
+    template<typename T, typename ... Args, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    std::to_chars_result to_chars(char* first, char* last, const in<T>& val, Args ... args)
+    {
+        return std::to_chars(first, last, *val, args...);
+    }
+
+    /// <summary>
+    /// Writes the value at the target of an out into [first, last), or "[Uninitialized]"
+    /// </summary>
+    template<typename T, typename ... Args, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    std::to_chars_result to_chars(char* first, char* last, const out<T>& val, Args ... args)
+    {
+        const T* value = val.target_value();
+        if (value == nullptr)
+        {
+            return detail::write_uninitialized(first, last);
+        }
+        return std::to_chars(first, last, *value, args...);
+    }
+}
+
+#if defined (__cpp_lib_format)
+
+/*
+
+    The formatters reuse T's formatter (and so its format specs), and write "[Uninitialized]" for missing values
+
+*/
+
+namespace std
+{
+    template<typename T>
+    struct formatter<cppspt::detail::uninit<T>, char> : formatter<T, char>
+    {
+        template<typename FormatContext>
+        auto format(const cppspt::detail::uninit<T>& val, FormatContext& ctx) const
+        {
+            if (!val.was_initialized())
+            {
+                return std::format_to(ctx.out(), "{}", cppspt::detail::uninitialized_text);
+            }
+            return formatter<T, char>::format(*val, ctx);
+        }
+    };
+
+    template<typename T>
+    struct formatter<cppspt::detail::in<T>, char> : formatter<T, char>
+    {
+        template<typename FormatContext>
+        auto format(const cppspt::detail::in<T>& val, FormatContext& ctx) const
+        {
+            return formatter<T, char>::format(*val, ctx);
+        }
+    };
+
+    template<typename T>
+    struct formatter<cppspt::detail::out<T>, char> : formatter<T, char>
+    {
+        template<typename FormatContext>
+        auto format(const cppspt::detail::out<T>& val, FormatContext& ctx) const
+        {
+            const T* value = val.target_value();
+            if (value == nullptr)
+            {
+                return std::format_to(ctx.out(), "{}", cppspt::detail::uninitialized_text);
+            }
+            return formatter<T, char>::format(*value, ctx);
+        }
+    };
+}
+
+#endif //__cpp_lib_format
+
+#endif //C++17
+
+#endif //CPPSPT_INCLUDE_CPPSPT_FORMAT_HPP
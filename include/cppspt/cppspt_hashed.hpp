@@ -0,0 +1,165 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_HASHED_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_HASHED_HPP
+
+/*
+
+    An input parameter that carries its hash
+
+    A key passed down through several hashed layers (a cache, then a map, then an index) is rehashed by each one.
+    hashed_in<K, Hash> hashes the key once, when it is created (or takes a hash the caller already has),
+    and every layer that accepts it reuses that hash.
+
+    hashed_in_hash and hashed_in_equal are transparent, so a std::unordered_map using them can be searched
+    with a hashed_in directly (heterogeneous lookup, C++20), and their plain K overloads keep inserts working.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename K, typename Hash>
+        class hashed_in;
+    }
+
+    /// <summary>
+    /// An in parameter for a key, together with its hash
+    /// </summary>
+    /// <typeparam name="K"></typeparam>
+    template<typename K, typename Hash = std::hash<K>>
+    using hashed_in = detail::hashed_in<K, Hash>;
+
+    namespace detail
+    {
+        template<typename K, typename Hash>
+        class hashed_in final
+        {
+        private:
+            in<K> m_key;
+            std::size_t m_hash;
+
+        public:
+            hashed_in(const_ref<K> key) :
+                m_key(key),
+                m_hash(Hash()(key))
+            {
+            }
+
+            hashed_in(move<K> key) :
+                m_key(std::move(key)),
+                m_hash(Hash()(*m_key))
+            {
+            }
+
+            hashed_in(in<K> key) :
+                m_key(std::move(key)),
+                m_hash(Hash()(*m_key))
+            {
+            }
+
+            //For a caller that already has the hash (which must be what Hash gives for key)
+            hashed_in(in<K> key, std::size_t hash) :
+                m_key(std::move(key)),
+                m_hash(hash)
+            {
+            }
+
+            hashed_in(move<hashed_in<K, Hash>> other) :
+                m_key(std::move(other.m_key)),
+                m_hash(other.m_hash)
+            {
+            }
+
+            //A copy borrows the key (like copying an in), and keeps the hash
+            hashed_in(const_ref<hashed_in<K, Hash>> other) :
+                m_key(other.m_key),
+                m_hash(other.m_hash)
+            {
+            }
+
+            hashed_in& operator=(const_ref<hashed_in<K, Hash>>) = delete;
+
+            std::size_t hash() const { return m_hash; }
+
+            operator const K& () const
+            {
+                return *m_key;
+            }
+
+            const K& operator*() const
+            {
+                return *m_key;
+            }
+
+            const K* operator->() const
+            {
+                return &*m_key;
+            }
+
+            /// <summary>
+            /// The key as an in, to construct it into a container (by move, if the caller moved)
+            /// </summary>
+            in<K>& key()
+            {
+                return m_key;
+            }
+        };
+    }
+
+    /// <summary>
+    /// A transparent hash, which reuses the hash of a hashed_in
+    /// </summary>
+    template<typename K, typename Hash = std::hash<K>>
+    struct hashed_in_hash
+    {
+        using is_transparent = void;
+
+        std::size_t operator()(const K& key) const
+        {
+            return Hash()(key);
+        }
+
+        std::size_t operator()(const hashed_in<K, Hash>& key) const
+        {
+            return key.hash();
+        }
+    };
+
+    /// <summary>
+    /// A transparent equality, which compares a hashed_in by its key
+    /// </summary>
+    template<typename K, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+    struct hashed_in_equal
+    {
+        using is_transparent = void;
+
+        bool operator()(const K& a, const K& b) const
+        {
+            return Equal()(a, b);
+        }
+
+        bool operator()(const hashed_in<K, Hash>& a, const K& b) const
+        {
+            return Equal()(*a, b);
+        }
+
+        bool operator()(const K& a, const hashed_in<K, Hash>& b) const
+        {
+            return Equal()(a, *b);
+        }
+    };
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_HASHED_HPP
@@ -0,0 +1,498 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_IPC_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_IPC_HPP
+
+/*
+
+    A single-producer, single-consumer ring of uninit slots in POSIX shared memory, for passing values between processes
+
+    The producer constructs each value in its slot (through an out<T>), and the consumer reads it where it is,
+    so a value is never serialized or copied through the kernel.
+
+    Every field that both processes touch lives in the segment: the head & tail indices, each slot's initialized flag,
+    and the words the processes sleep on. Indices are only moved once a slot is fully written or released, so a slot
+    is initialized exactly when it lies between the head and the tail.
+    The creating process constructs the header & slots, then sets a ready flag; other processes can only open a ready ring.
+
+    A process that finds the ring full (or empty) spins briefly, then sleeps on a futex (on Linux; elsewhere it yields).
+
+    Only trivially copyable types can be stored, and only on POSIX systems.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#if defined (__unix__) || defined (__APPLE__)
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined (__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename T>
+        class ipc_ring;
+    }
+
+    /// <summary>
+    /// A bounded single-producer, single-consumer ring of values in shared memory, shared by two processes. T must be trivially copyable
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using ipc_ring = detail::ipc_ring<T>;
+
+    namespace detail
+    {
+        static const char ipc_ring_magic[8] = { 'C', 'P', 'P', 'S', 'P', 'T', 'R', 'G' };
+        static const std::uint32_t ipc_ring_version = 1;
+
+        //How many times a full (or empty) ring is checked before sleeping
+        static const int ipc_spin_count = 256;
+
+        static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "CPPSPT: ipc_ring needs lock-free atomics!");
+
+        /*
+
+            The shared header. Each index, and each side's wakeup words, are on their own cache line
+
+        */
+
+        struct ipc_ring_header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t header_size;
+            std::uint64_t value_size;
+            std::uint64_t value_alignment;
+            std::uint64_t capacity;
+            std::uint64_t slots_offset;
+            std::atomic<std::uint32_t> ready;                   //Set by the creator once the slots are constructed
+
+            alignas(cache_line_size) std::atomic<std::uint64_t> head;      //Next slot to pop, written by the consumer
+            alignas(cache_line_size) std::atomic<std::uint64_t> tail;      //Next slot to push, written by the producer
+
+            //Bumped by the producer to wake a sleeping consumer
+            alignas(cache_line_size) std::atomic<std::uint32_t> pushed_signal;
+            std::atomic<std::uint32_t> consumer_sleeping;
+
+            //Bumped by the consumer to wake a sleeping producer
+            alignas(cache_line_size) std::atomic<std::uint32_t> popped_signal;
+            std::atomic<std::uint32_t> producer_sleeping;
+        };
+
+        inline void ipc_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected)
+        {
+#if defined (__linux__)
+            //Not FUTEX_PRIVATE_FLAG: the word is shared between processes
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+#else
+            (void)word;
+            (void)expected;
+            std::this_thread::yield();
+#endif
+        }
+
+        inline void ipc_wake(std::atomic<std::uint32_t>& word)
+        {
+#if defined (__linux__)
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+            (void)word;
+#endif
+        }
+
+        //Waits until ready() is true, sleeping on signal once spinning has not helped.
+        //sleeping is set while asleep, so that the other side only makes a system call when someone is waiting
+        template<typename Ready>
+        void ipc_wait_until(std::atomic<std::uint32_t>& signal, std::atomic<std::uint32_t>& sleeping, Ready ready)
+        {
+            for (int i = 0; i < ipc_spin_count; i++)
+            {
+                if (ready())
+                {
+                    return;
+                }
+            }
+
+            while (!ready())
+            {
+                std::uint32_t seen = signal.load(std::memory_order_acquire);
+                sleeping.store(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                //Re-checked after announcing the sleep, so a wakeup between the check and the wait is never lost
+                if (!ready())
+                {
+                    ipc_wait(signal, seen);
+                }
+                sleeping.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        inline void ipc_notify(std::atomic<std::uint32_t>& signal, std::atomic<std::uint32_t>& sleeping)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_relaxed) != 0)
+            {
+                signal.fetch_add(1, std::memory_order_release);
+                ipc_wake(signal);
+            }
+        }
+
+        template<typename T>
+        class ipc_ring final
+        {
+        private:
+            int m_file;
+            void* m_mapping;
+            std::size_t m_mapping_size;
+            ipc_ring_header* m_header;
+            uninit<T>* m_slots;
+            std::uint64_t m_mask;
+            std::string m_unlink_name;              //Set for the creator, which removes the name when it closes
+
+            std::uint64_t m_cached_head;            //Producer's last view of the head
+            std::uint64_t m_cached_tail;            //Consumer's last view of the tail
+
+            static std::uint64_t slots_offset()
+            {
+                std::uint64_t alignment = alignof(uninit<T>) > cache_line_size ? alignof(uninit<T>) : cache_line_size;
+                return (sizeof(ipc_ring_header) + alignment - 1) & ~(alignment - 1);
+            }
+
+            static std::size_t segment_size(std::uint64_t capacity)
+            {
+                return static_cast<std::size_t>(slots_offset() + capacity * sizeof(uninit<T>));
+            }
+
+            bool map(std::size_t size)
+            {
+                m_mapping_size = size;
+                m_mapping = ::mmap(nullptr, m_mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+                if (m_mapping == MAP_FAILED)
+                {
+                    m_mapping = nullptr;
+                    return false;
+                }
+
+                unsigned char* base = static_cast<unsigned char*>(m_mapping);
+                m_header = reinterpret_cast<ipc_ring_header*>(base);
+                m_slots = reinterpret_cast<uninit<T>*>(base + slots_offset());
+                return true;
+            }
+
+            //Checks that a ready header was created for this type, by this version
+            bool matches() const
+            {
+                return std::memcmp(m_header->magic, ipc_ring_magic, sizeof(ipc_ring_magic)) == 0
+                    && m_header->version == ipc_ring_version
+                    && m_header->header_size == sizeof(ipc_ring_header)
+                    && m_header->value_size == sizeof(T)
+                    && m_header->value_alignment == alignof(T)
+                    && m_header->slots_offset == slots_offset()
+                    && m_header->capacity != 0
+                    && (m_header->capacity & (m_header->capacity - 1)) == 0
+                    && segment_size(m_header->capacity) <= m_mapping_size;
+            }
+
+        public:
+            ipc_ring() :
+                m_file(-1),
+                m_mapping(nullptr),
+                m_mapping_size(0),
+                m_header(nullptr),
+                m_slots(nullptr),
+                m_mask(0),
+                m_cached_head(0),
+                m_cached_tail(0)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "CPPSPT: ipc_ring requires a trivially copyable type!");
+            }
+
+            ~ipc_ring()
+            {
+                close();
+            }
+
+            ipc_ring(const ipc_ring<T>&) = delete;
+            ipc_ring& operator=(const ipc_ring<T>&) = delete;
+
+            /// <summary>
+            /// Creates the shared memory segment name (which must not exist yet), with room for at least capacity values
+            /// (rounded up to a power of 2). The name is removed again when this ring is closed
+            /// </summary>
+            bool create(const char* name, std::size_t capacity)
+            {
+                close();
+
+                std::uint64_t rounded = 1;
+                while (rounded < capacity)
+                {
+                    rounded <<= 1;
+                }
+
+                m_file = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+                if (m_file < 0)
+                {
+                    return false;
+                }
+                m_unlink_name = name;
+
+                if (::ftruncate(m_file, static_cast<off_t>(segment_size(rounded))) != 0 || !map(segment_size(rounded)))
+                {
+                    close();
+                    return false;
+                }
+
+                //Only the creator constructs anything in the segment; the other process waits for ready
+                ipc_ring_header* header = new (m_header) ipc_ring_header();
+                std::memcpy(header->magic, ipc_ring_magic, sizeof(ipc_ring_magic));
+                header->version = ipc_ring_version;
+                header->header_size = sizeof(ipc_ring_header);
+                header->value_size = sizeof(T);
+                header->value_alignment = alignof(T);
+                header->capacity = rounded;
+                header->slots_offset = slots_offset();
+                header->head.store(0, std::memory_order_relaxed);
+                header->tail.store(0, std::memory_order_relaxed);
+                header->pushed_signal.store(0, std::memory_order_relaxed);
+                header->consumer_sleeping.store(0, std::memory_order_relaxed);
+                header->popped_signal.store(0, std::memory_order_relaxed);
+                header->producer_sleeping.store(0, std::memory_order_relaxed);
+
+                for (std::uint64_t i = 0; i < rounded; i++)
+                {
+                    new (&m_slots[i]) uninit<T>();
+                }
+
+                m_mask = rounded - 1;
+                header->ready.store(1, std::memory_order_release);
+                return true;
+            }
+
+            /// <summary>
+            /// Opens a ring created by another process. Returns false if it doesn't exist, isn't ready yet, or holds another type
+            /// </summary>
+            bool open(const char* name)
+            {
+                close();
+
+                m_file = ::shm_open(name, O_RDWR, 0600);
+                if (m_file < 0)
+                {
+                    return false;
+                }
+
+                struct stat status;
+                if (::fstat(m_file, &status) != 0
+                    || static_cast<std::size_t>(status.st_size) < sizeof(ipc_ring_header)
+                    || !map(static_cast<std::size_t>(status.st_size)))
+                {
+                    close();
+                    return false;
+                }
+
+                if (m_header->ready.load(std::memory_order_acquire) == 0 || !matches())
+                {
+                    close();
+                    return false;
+                }
+
+                m_mask = m_header->capacity - 1;
+                m_cached_head = m_header->head.load(std::memory_order_acquire);
+                m_cached_tail = m_header->tail.load(std::memory_order_acquire);
+                return true;
+            }
+
+            /// <summary>
+            /// Unmaps the ring (and removes its name, if this process created it)
+            /// </summary>
+            void close()
+            {
+                if (m_mapping != nullptr)
+                {
+                    ::munmap(m_mapping, m_mapping_size);
+                    m_mapping = nullptr;
+                }
+                if (m_file >= 0)
+                {
+                    ::close(m_file);
+                    m_file = -1;
+                }
+                if (!m_unlink_name.empty())
+                {
+                    ::shm_unlink(m_unlink_name.c_str());
+                    m_unlink_name.clear();
+                }
+                m_header = nullptr;
+                m_slots = nullptr;
+                m_mask = 0;
+                m_cached_head = 0;
+                m_cached_tail = 0;
+            }
+
+            bool is_open() const { return m_mapping != nullptr; }
+
+            std::size_t capacity() const { return static_cast<std::size_t>(m_mask + 1); }
+
+            /*
+
+                Producer
+
+            */
+
+            /// <summary>
+            /// Calls write with an out<T> to the next free slot, and publishes it. Returns false (without calling write) if the ring is full
+            /// </summary>
+            template<typename Func>
+            bool try_push_with(Func&& write)
+            {
+                std::uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+                if (tail - m_cached_head > m_mask)
+                {
+                    m_cached_head = m_header->head.load(std::memory_order_acquire);
+                    if (tail - m_cached_head > m_mask)
+                    {
+                        return false;
+                    }
+                }
+
+                uninit<T>& slot = m_slots[tail & m_mask];
+                write(out<T>(slot));
+                CPPSPT_ASSERT(slot.was_initialized() && "CPPSPT: an ipc_ring push must write its value!");
+
+                m_header->tail.store(tail + 1, std::memory_order_release);
+                ipc_notify(m_header->pushed_signal, m_header->consumer_sleeping);
+                return true;
+            }
+
+            /// <summary>
+            /// Like try_push_with, but waits for a free slot
+            /// </summary>
+            template<typename Func>
+            void push_with(Func&& write)
+            {
+                while (!try_push_with(write))
+                {
+                    ipc_wait_until(m_header->popped_signal, m_header->producer_sleeping, [this]
+                    {
+                        std::uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+                        return tail - m_header->head.load(std::memory_order_acquire) <= m_mask;
+                    });
+                }
+            }
+
+            bool try_push(in<T> val)
+            {
+                return try_push_with([&](out<T> slot) { slot = std::move(val); });
+            }
+
+            void push(in<T> val)
+            {
+                push_with([&](out<T> slot) { slot = std::move(val); });
+            }
+
+            /*
+
+                Consumer
+
+            */
+
+            /// <summary>
+            /// The oldest value, read in place in shared memory, or nullptr if the ring is empty. Stays valid until pop_front
+            /// </summary>
+            const T* front()
+            {
+                std::uint64_t head = m_header->head.load(std::memory_order_relaxed);
+                if (m_cached_tail == head)
+                {
+                    m_cached_tail = m_header->tail.load(std::memory_order_acquire);
+                    if (m_cached_tail == head)
+                    {
+                        return nullptr;
+                    }
+                }
+
+                return &*m_slots[head & m_mask];
+            }
+
+            /// <summary>
+            /// Like front, but waits for a value
+            /// </summary>
+            const T& wait_front()
+            {
+                const T* val = front();
+                while (val == nullptr)
+                {
+                    ipc_wait_until(m_header->pushed_signal, m_header->consumer_sleeping, [this]
+                    {
+                        return m_header->tail.load(std::memory_order_acquire) != m_header->head.load(std::memory_order_relaxed);
+                    });
+                    val = front();
+                }
+                return *val;
+            }
+
+            /// <summary>
+            /// Releases the oldest value's slot to the producer. The ring must not be empty
+            /// </summary>
+            void pop_front()
+            {
+                std::uint64_t head = m_header->head.load(std::memory_order_relaxed);
+                CPPSPT_ASSERT(head != m_cached_tail && "CPPSPT: popping from an empty ipc_ring!");
+
+                m_slots[head & m_mask].reset();
+                m_header->head.store(head + 1, std::memory_order_release);
+                ipc_notify(m_header->popped_signal, m_header->producer_sleeping);
+            }
+
+            /// <summary>
+            /// Copies the oldest value into dest and pops it, unless the ring is empty
+            /// </summary>
+            bool try_pop(out<T> dest)
+            {
+                const T* val = front();
+                if (val == nullptr)
+                {
+                    return false;
+                }
+
+                dest = *val;
+                pop_front();
+                return true;
+            }
+
+            void pop(out<T> dest)
+            {
+                dest = wait_front();
+                pop_front();
+            }
+        };
+    }
+}
+
+#endif //POSIX
+
+#endif //CPPSPT_INCLUDE_CPPSPT_IPC_HPP
@@ -0,0 +1,381 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_MAPPED_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_MAPPED_HPP
+
+/*
+
+    A persistent array of uninit values, backed by a memory mapped file
+
+    The values and the bitmap of which values are initialized both live in the mapping,
+    so reopening the file gives back every initialized value with no parsing or copying.
+    Pages are only read from the file when they are first touched (unless populate is asked for).
+
+    File layout (every section starts on a page boundary):
+
+        [ mapped_file_header | validity bitmap (64-bit words) | values ]
+
+    The header records the value type's size, alignment and a tag for the type (see mapped_type_tag),
+    and a file whose header doesn't match is not opened.
+
+    Only trivially copyable types can be stored, and only on POSIX systems.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#if defined (__unix__) || defined (__APPLE__)
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <typeinfo>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename T>
+        class mapped_uninit_array;
+    }
+
+    /// <summary>
+    /// A fixed-capacity array of uninit values stored in a memory mapped file. T must be trivially copyable
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using mapped_uninit_array = detail::mapped_uninit_array<T>;
+
+    /// <summary>
+    /// How a mapped_uninit_array maps its file
+    /// </summary>
+    struct mapped_options
+    {
+        //Read the whole file in when mapping, rather than faulting pages in lazily (MAP_POPULATE, linux only)
+        bool populate = false;
+
+        //Ask for transparent huge pages (MADV_HUGEPAGE, linux only; needs a filesystem that supports them)
+        bool huge_pages = false;
+
+        //Open the file without write access (the mapping is read only too, so set, push_back & reset are rejected)
+        bool read_only = false;
+    };
+
+    namespace detail
+    {
+        //FNV-1a
+        inline std::uint64_t mapped_name_hash(const char* name)
+        {
+            std::uint64_t hash = 14695981039346656037ull;
+            for (; *name != '\0'; name++)
+            {
+                hash ^= static_cast<unsigned char>(*name);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+    }
+
+    /// <summary>
+    /// Identifies T in a mapped file's header, so that a file written for another type of the same size isn't opened as a T.
+    /// By default a hash of typeid(T).name(), which can differ between compilers: specialize value() for files shared between them,
+    /// and change it when T's layout changes
+    /// </summary>
+    template<typename T>
+    struct mapped_type_tag
+    {
+        static std::uint64_t value() { return detail::mapped_name_hash(typeid(T).name()); }
+    };
+
+    namespace detail
+    {
+        static const char mapped_file_magic[8] = { 'C', 'P', 'P', 'S', 'P', 'T', 'M', 'A' };
+        static const std::uint32_t mapped_file_version = 2;
+        static const std::uint64_t mapped_page_size = 4096;
+
+        struct mapped_file_header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t header_size;
+            std::uint64_t value_size;
+            std::uint64_t value_alignment;
+            std::uint64_t type_tag;
+            std::uint64_t capacity;
+            std::uint64_t size;                 //One past the last value pushed
+            std::uint64_t validity_offset;
+            std::uint64_t values_offset;
+            std::uint64_t file_size;
+        };
+
+        inline std::uint64_t round_up_to_page(std::uint64_t val)
+        {
+            return (val + mapped_page_size - 1) & ~(mapped_page_size - 1);
+        }
+
+        template<typename T>
+        class mapped_uninit_array final
+        {
+        private:
+            int m_file;
+            void* m_mapping;
+            std::size_t m_mapping_size;
+            mapped_file_header* m_header;
+            std::uint64_t* m_validity;
+            T* m_values;
+            bool m_read_only;
+
+            static mapped_file_header make_header(std::size_t capacity)
+            {
+                mapped_file_header header;
+                std::memset(&header, 0, sizeof(header));
+                std::memcpy(header.magic, mapped_file_magic, sizeof(header.magic));
+                header.version = mapped_file_version;
+                header.header_size = sizeof(mapped_file_header);
+                header.value_size = sizeof(T);
+                header.value_alignment = alignof(T);
+                header.type_tag = mapped_type_tag<T>::value();
+                header.capacity = capacity;
+                header.size = 0;
+                header.validity_offset = round_up_to_page(sizeof(mapped_file_header));
+                header.values_offset = header.validity_offset + round_up_to_page(((capacity + 63) / 64) * sizeof(std::uint64_t));
+                header.file_size = header.values_offset + round_up_to_page(capacity * sizeof(T));
+                return header;
+            }
+
+            //Checks that an existing file was written for this type, by this version
+            static bool matches(const mapped_file_header& header, std::size_t capacity)
+            {
+                mapped_file_header expected = make_header(static_cast<std::size_t>(header.capacity));
+                return std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0
+                    && header.version == expected.version
+                    && header.header_size == expected.header_size
+                    && header.value_size == expected.value_size
+                    && header.value_alignment == expected.value_alignment
+                    && header.type_tag == expected.type_tag
+                    && header.validity_offset == expected.validity_offset
+                    && header.values_offset == expected.values_offset
+                    && header.file_size == expected.file_size
+                    && header.size <= header.capacity
+                    && (capacity == 0 || header.capacity == capacity);
+            }
+
+        public:
+            mapped_uninit_array() :
+                m_file(-1),
+                m_mapping(nullptr),
+                m_mapping_size(0),
+                m_header(nullptr),
+                m_validity(nullptr),
+                m_values(nullptr),
+                m_read_only(false)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "CPPSPT: mapped_uninit_array requires a trivially copyable type!");
+                static_assert(alignof(T) <= mapped_page_size, "CPPSPT: over-aligned types are not supported by mapped_uninit_array!");
+            }
+
+            ~mapped_uninit_array()
+            {
+                close();
+            }
+
+            mapped_uninit_array(const mapped_uninit_array<T>&) = delete;
+            mapped_uninit_array& operator=(const mapped_uninit_array<T>&) = delete;
+
+            /// <summary>
+            /// Opens (or creates, with capacity values) the file at path and maps it.
+            /// An existing file keeps its values; capacity 0 accepts whatever capacity it has.
+            /// Returns false if the file can't be opened, or was written for another type, capacity or version
+            /// </summary>
+            bool open(const char* path, std::size_t capacity, const mapped_options& options = mapped_options())
+            {
+                close();
+
+                m_file = ::open(path, options.read_only ? O_RDONLY : (O_RDWR | O_CREAT), 0644);
+                if (m_file < 0)
+                {
+                    return false;
+                }
+
+                struct stat status;
+                if (::fstat(m_file, &status) != 0)
+                {
+                    close();
+                    return false;
+                }
+
+                mapped_file_header header;
+                if (status.st_size == 0)
+                {
+                    //A new file: size it (sparsely), then write the header
+                    if (options.read_only || capacity == 0)
+                    {
+                        close();
+                        return false;
+                    }
+
+                    header = make_header(capacity);
+                    if (::ftruncate(m_file, static_cast<off_t>(header.file_size)) != 0
+                        || ::pwrite(m_file, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)))
+                    {
+                        close();
+                        return false;
+                    }
+                }
+                else
+                {
+                    if (::pread(m_file, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))
+                        || !matches(header, capacity)
+                        || static_cast<std::uint64_t>(status.st_size) < header.file_size)
+                    {
+                        close();
+                        return false;
+                    }
+                }
+
+                int protection = options.read_only ? PROT_READ : (PROT_READ | PROT_WRITE);
+                int flags = MAP_SHARED;
+#if defined (MAP_POPULATE)
+                if (options.populate)
+                {
+                    flags |= MAP_POPULATE;
+                }
+#endif
+
+                m_mapping_size = static_cast<std::size_t>(header.file_size);
+                m_mapping = ::mmap(nullptr, m_mapping_size, protection, flags, m_file, 0);
+                if (m_mapping == MAP_FAILED)
+                {
+                    m_mapping = nullptr;
+                    close();
+                    return false;
+                }
+
+#if defined (MADV_HUGEPAGE)
+                if (options.huge_pages)
+                {
+                    ::madvise(m_mapping, m_mapping_size, MADV_HUGEPAGE);
+                }
+#endif
+
+                unsigned char* base = static_cast<unsigned char*>(m_mapping);
+                m_header = reinterpret_cast<mapped_file_header*>(base);
+                m_validity = reinterpret_cast<std::uint64_t*>(base + header.validity_offset);
+                m_values = reinterpret_cast<T*>(base + header.values_offset);
+                m_read_only = options.read_only;
+                return true;
+            }
+
+            /// <summary>
+            /// Unmaps and closes the file. Writes reach the file when the OS flushes them (or on sync)
+            /// </summary>
+            void close()
+            {
+                if (m_mapping != nullptr)
+                {
+                    ::munmap(m_mapping, m_mapping_size);
+                    m_mapping = nullptr;
+                }
+                if (m_file >= 0)
+                {
+                    ::close(m_file);
+                    m_file = -1;
+                }
+                m_header = nullptr;
+                m_validity = nullptr;
+                m_values = nullptr;
+                m_read_only = false;
+            }
+
+            /// <summary>
+            /// Flushes the mapping to the file
+            /// </summary>
+            bool sync()
+            {
+                return m_mapping != nullptr && ::msync(m_mapping, m_mapping_size, MS_SYNC) == 0;
+            }
+
+            bool is_open() const { return m_mapping != nullptr; }
+
+            bool is_read_only() const { return m_read_only; }
+
+            std::size_t capacity() const { return static_cast<std::size_t>(m_header->capacity); }
+
+            std::size_t size() const { return static_cast<std::size_t>(m_header->size); }
+
+            bool was_initialized(std::size_t index) const
+            {
+                return (m_validity[index / 64] >> (index % 64)) & 1;
+            }
+
+            /// <summary>
+            /// Writes a value to index, which grows the size to include it. The array must not be read only
+            /// </summary>
+            void set(std::size_t index, in<T> val)
+            {
+                //Checked even with asserts disabled, as the write would fault on the read only mapping
+                CPPSPT_VERIFY(!m_read_only && "Writing to a read only mapped array!");
+                CPPSPT_ASSERT(index < capacity() && "Writing past the capacity of a mapped array!");
+
+                new (&m_values[index]) T(*val);
+                m_validity[index / 64] |= std::uint64_t(1) << (index % 64);
+                if (index >= m_header->size)
+                {
+                    m_header->size = index + 1;
+                }
+            }
+
+            /// <summary>
+            /// Appends a value, returning false when full, or read only
+            /// </summary>
+            bool push_back(in<T> val)
+            {
+                if (m_read_only || size() == capacity())
+                {
+                    return false;
+                }
+                set(size(), std::move(val));
+                return true;
+            }
+
+            void reset(std::size_t index)
+            {
+                CPPSPT_VERIFY(!m_read_only && "Writing to a read only mapped array!");
+
+                m_validity[index / 64] &= ~(std::uint64_t(1) << (index % 64));
+            }
+
+            const T& operator[](std::size_t index) const
+            {
+                CPPSPT_ASSERT(was_initialized(index) && "Attempting to read from uninit value!");
+
+                return m_values[index];
+            }
+
+            //The value must not be written through this if the array is read only
+            T& operator[](std::size_t index)
+            {
+                CPPSPT_ASSERT(was_initialized(index) && "Attempting to read from uninit value!");
+
+                return m_values[index];
+            }
+
+            const T* values() const { return m_values; }
+            const std::uint64_t* validity() const { return m_validity; }
+        };
+    }
+}
+
+#endif //POSIX
+
+#endif //CPPSPT_INCLUDE_CPPSPT_MAPPED_HPP
@@ -0,0 +1,263 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_OUTS_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_OUTS_HPP
+
+/*
+
+    Several output parameters in one
+
+    A function with several results either takes an out<T> for each (a tagged pointer each,
+    or a pointer and a kind when T isn't 4-byte aligned), or returns a std::tuple, which the caller then moves out of.
+    outs<Ts...> holds a pointer to each destination, and one small integer with a bit per destination
+    which is set when that destination is an uninit<T> (rather than a live T).
+
+    The callee constructs each result directly in its destination: uninit destinations are built in place,
+    live ones are assigned. The caller binds its own variables, so there is no tuple to unpack:
+
+        void parse(const char* line, cppspt::outs<int, std::string> results);
+
+        int id;
+        cppspt::uninit<std::string> name;
+        parse(line, { id, name });
+
+    An outs also follows the tuple protocol, so (from C++17) auto [id, name] = results; binds references to the destinations.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_record.hpp"
+
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename ... Ts>
+        class outs;
+    }
+
+    /// <summary>
+    /// Output parameters for several results, each bound to a T or an uninit<T> of the caller's
+    /// </summary>
+    /// <typeparam name="Ts"></typeparam>
+    template<typename ... Ts>
+    using outs = detail::outs<Ts...>;
+
+    namespace detail
+    {
+        //Whether a D& can be bound as the destination of a T result
+        template<typename D, typename T>
+        struct is_outs_target : std::integral_constant<bool, std::is_same<D, T>::value || std::is_same<D, uninit<T>>::value> {};
+
+        template<bool ... Bs>
+        struct outs_all_of : std::true_type {};
+
+        template<bool B, bool ... Bs>
+        struct outs_all_of<B, Bs...> : std::integral_constant<bool, B && outs_all_of<Bs...>::value> {};
+
+        //Whether emplacing args into a live T can be a plain assignment: one argument, which converts to T implicitly
+        template<typename T, typename ... Args>
+        struct outs_assigns_directly : std::false_type {};
+
+        template<typename T, typename Arg>
+        struct outs_assigns_directly<T, Arg> : std::integral_constant<bool, std::is_convertible<Arg&&, T>::value && std::is_assignable<T&, Arg&&>::value> {};
+
+        template<typename ... Ts>
+        class outs final
+        {
+        public:
+            using mask_type = record_mask<sizeof...(Ts)>;
+
+            template<std::size_t I>
+            using result_type = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+
+            static const std::size_t result_count = sizeof...(Ts);
+
+        private:
+            static_assert(sizeof...(Ts) != 0, "CPPSPT: outs needs at least one result!");
+            static_assert(sizeof...(Ts) <= 64, "CPPSPT: outs supports up to 64 results!");
+
+            void* m_targets[sizeof...(Ts)];
+
+            //Bit I is set when result I's destination is an uninit
+            mask_type m_uninit;
+
+            static mask_type bit(std::size_t index)
+            {
+                return static_cast<mask_type>(mask_type(1) << index);
+            }
+
+            static mask_type pack_kinds(std::initializer_list<bool> kinds)
+            {
+                mask_type bits = 0;
+                std::size_t index = 0;
+                for (bool is_uninit : kinds)
+                {
+                    if (is_uninit)
+                    {
+                        bits |= bit(index);
+                    }
+                    index++;
+                }
+                return bits;
+            }
+
+            //Destinations are reached through hide_target, like out's, so GCC doesn't warn about the paths for the other kind
+            template<std::size_t I>
+            result_type<I>* direct() const
+            {
+                return static_cast<result_type<I>*>(hide_target(m_targets[I]));
+            }
+
+            template<std::size_t I>
+            uninit<result_type<I>>* uninitialized() const
+            {
+                return static_cast<uninit<result_type<I>>*>(hide_target(m_targets[I]));
+            }
+
+            //Result I's destination as an out, so that writes share out's handling of each kind of destination
+            template<std::size_t I>
+            out<result_type<I>> destination() const
+            {
+                if (targets_uninit<I>())
+                {
+                    return out<result_type<I>>(*uninitialized<I>());
+                }
+                return out<result_type<I>>(*direct<I>());
+            }
+
+            template<typename T, typename Arg>
+            static void emplace_live(T& dest, std::true_type, Arg&& arg)
+            {
+                dest = std::forward<Arg>(arg);
+            }
+
+            //The new value is built before the old one is touched, so args may refer to it
+            template<typename T, typename ... Args>
+            static void emplace_live(T& dest, std::false_type, Args&& ... args)
+            {
+                out<T>(dest).assign_from([&] { return T(std::forward<Args>(args)...); });
+            }
+
+        public:
+            /// <summary>
+            /// Binds each result to a destination: a T (which is assigned) or an uninit<T> (which is constructed in place)
+            /// </summary>
+            template<typename ... Ds, typename = typename std::enable_if<sizeof...(Ds) == sizeof...(Ts) && outs_all_of<is_outs_target<Ds, Ts>::value...>::value>::type>
+            outs(Ds& ... destinations) :
+                m_targets{ static_cast<void*>(std::addressof(destinations))... },
+                m_uninit(pack_kinds({ std::is_same<Ds, uninit<Ts>>::value... }))
+            {
+            }
+
+            //Copying an outs only copies the destinations, like copying an out
+            outs(const outs&) = default;
+            outs& operator=(const outs&) = default;
+
+            /// <summary>
+            /// Whether result I's destination is an uninit (rather than a live T)
+            /// </summary>
+            template<std::size_t I>
+            bool targets_uninit() const
+            {
+                return (m_uninit & bit(I)) != 0;
+            }
+
+            /// <summary>
+            /// Writes val to result I: moved in if the caller moved, and copied otherwise
+            /// </summary>
+            template<std::size_t I>
+            result_type<I>& set(in<result_type<I>> val)
+            {
+                out<result_type<I>> dest = destination<I>();
+                dest = std::move(val);
+                return *dest;
+            }
+
+            /// <summary>
+            /// Writes the T returned by factory() to result I, as out::assign_from: an uninitialized uninit destination
+            /// is constructed in place like uninit::init_with, and a live T (in an uninit or not) is assigned the result,
+            /// or rebuilt if it can't be assigned from it
+            /// </summary>
+            template<std::size_t I, typename F>
+            result_type<I>& assign_from(F&& factory)
+            {
+                out<result_type<I>> dest = destination<I>();
+                dest.assign_from(std::forward<F>(factory));
+                return *dest;
+            }
+
+            /// <summary>
+            /// Writes a T constructed from args to result I. An uninitialized uninit destination is constructed from args directly.
+            /// A live T (in an uninit or not) is assigned a single argument that converts to T (so a string keeps its buffer),
+            /// and otherwise a T built from args before the old value is replaced, so args may refer to the old value
+            /// </summary>
+            template<std::size_t I, typename ... Args>
+            result_type<I>& emplace(Args&& ... args)
+            {
+                using T = result_type<I>;
+
+                T* dest;
+                if (targets_uninit<I>())
+                {
+                    uninit<T>& target = *uninitialized<I>();
+                    if (!target.was_initialized())
+                    {
+                        target.init(std::forward<Args>(args)...);
+                        return *target;
+                    }
+                    dest = &*target;
+                }
+                else
+                {
+                    dest = direct<I>();
+                }
+
+                emplace_live(*dest, outs_assigns_directly<T, Args...>(), std::forward<Args>(args)...);
+                return *dest;
+            }
+
+            /// <summary>
+            /// Result I, at its destination, which must hold a value: a T, or an uninit that is initialized
+            /// (Whether it was written through this outs or not)
+            /// </summary>
+            template<std::size_t I>
+            result_type<I>& get() const
+            {
+                if (targets_uninit<I>())
+                {
+                    uninit<result_type<I>>& target = *uninitialized<I>();
+                    CPPSPT_ASSERT(target.was_initialized() && "CPPSPT: reading an uninitialized result of outs!");
+                    return *target;
+                }
+                return *direct<I>();
+            }
+        };
+    }
+}
+
+namespace std
+{
+    //Tuple protocol, so that structured bindings of an outs are references to its destinations
+    template<typename ... Ts>
+    struct tuple_size<cppspt::detail::outs<Ts...>> : std::integral_constant<std::size_t, sizeof...(Ts)> {};
+
+    template<std::size_t I, typename ... Ts>
+    struct tuple_element<I, cppspt::detail::outs<Ts...>>
+    {
+        using type = typename std::tuple_element<I, std::tuple<Ts...>>::type&;
+    };
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_OUTS_HPP
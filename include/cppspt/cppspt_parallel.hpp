@@ -0,0 +1,385 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_PARALLEL_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_PARALLEL_HPP
+
+/*
+
+    Large arrays of uninit values, constructed and destroyed in parallel
+
+    The storage is allocated without being touched, and each worker thread is the first to
+    write to its own chunk. With first-touch page placement, each chunk lands on the NUMA node
+    of the thread that initialized it. Readers that split the array the same way (see parallel_for)
+    then read memory local to their own node.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined (__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename T>
+        class uninit_array;
+    }
+
+    /// <summary>
+    /// A fixed-size array of uninit values, which can be initialized and destroyed across several threads
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using uninit_array = detail::uninit_array<T>;
+
+    /// <summary>
+    /// How work on an uninit_array is split across threads
+    /// </summary>
+    struct parallel_options
+    {
+        //Number of threads (0 uses every hardware thread)
+        unsigned threads = 0;
+
+        //Pins worker i to cpu i, so that the chunk initialized by worker i is later read from the same node
+        //(Only supported on linux, ignored elsewhere)
+        bool pin_threads = false;
+
+        parallel_options() {}
+        parallel_options(unsigned threads_, bool pin_threads_ = false) : threads(threads_), pin_threads(pin_threads_) {}
+
+        unsigned thread_count() const
+        {
+            if (threads != 0)
+            {
+                return threads;
+            }
+            unsigned hardware = std::thread::hardware_concurrency();
+            return (hardware != 0) ? hardware : 1;
+        }
+    };
+
+    /// <summary>
+    /// A half-open range of indices handled by a single thread
+    /// </summary>
+    struct chunk_range
+    {
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    /// <summary>
+    /// Splits [0, size) into parts contiguous chunks and returns chunk index.
+    /// Chunk boundaries are rounded to multiples of granularity, so that two threads never share a page
+    /// </summary>
+    inline chunk_range partition(std::size_t size, std::size_t parts, std::size_t index, std::size_t granularity = 1)
+    {
+        std::size_t blocks = (size + granularity - 1) / granularity;
+        std::size_t begin = (blocks * index / parts) * granularity;
+        std::size_t end = (blocks * (index + 1) / parts) * granularity;
+
+        chunk_range range;
+        range.begin = (begin < size) ? begin : size;
+        range.end = (end < size) ? end : size;
+        return range;
+    }
+
+    namespace detail
+    {
+        //Pins the calling thread to one cpu (wrapping around the hardware threads). Returns false if it couldn't
+        inline bool pin_this_thread(unsigned cpu)
+        {
+#if defined (__linux__)
+            unsigned hardware = std::thread::hardware_concurrency();
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET((hardware != 0 ? cpu % hardware : cpu) % CPU_SETSIZE, &cpus);
+            return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+            (void)cpu;
+            return false;
+#endif
+        }
+
+        //Joins the workers (and restores the calling thread's affinity) however run_parallel exits,
+        //so a thread that fails to start, or a func that throws, doesn't leave joinable threads behind
+        struct parallel_cleanup
+        {
+            std::vector<std::thread>& workers;
+#if defined (__linux__)
+            cpu_set_t previous;
+            bool restore = false;
+#endif
+
+            explicit parallel_cleanup(std::vector<std::thread>& workers_) : workers(workers_) {}
+
+            ~parallel_cleanup()
+            {
+                finish();
+            }
+
+            void finish()
+            {
+#if defined (__linux__)
+                if (restore)
+                {
+                    pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+                    restore = false;
+                }
+#endif
+                for (std::thread& worker : workers)
+                {
+                    worker.join();
+                }
+                workers.clear();
+            }
+
+            parallel_cleanup(const parallel_cleanup&) = delete;
+            parallel_cleanup& operator=(const parallel_cleanup&) = delete;
+        };
+    }
+
+    /// <summary>
+    /// Runs func(index) on options.thread_count() threads, with index 0 on the calling thread.
+    /// With options.pin_threads, each thread is pinned before it calls func, so everything func first touches is on that cpu's node.
+    /// Returns false if a thread could not be pinned (func still runs on every thread).
+    /// If func throws, every thread is joined first, then the calling thread's exception (or else the lowest worker's) is rethrown
+    /// </summary>
+    template<typename Func>
+    bool run_parallel(const parallel_options& options, Func func)
+    {
+        const unsigned count = options.thread_count();
+        const bool pin = options.pin_threads;
+        std::atomic<bool> pinned(true);
+
+        //An exception can't leave a std::thread (that terminates), so each worker's is kept for the calling thread
+        std::vector<std::exception_ptr> errors(count);
+
+        std::vector<std::thread> workers;
+        workers.reserve(count - 1);
+        detail::parallel_cleanup cleanup(workers);
+
+        for (unsigned i = 1; i < count; i++)
+        {
+            workers.emplace_back([&func, &pinned, &errors, pin, i]
+            {
+                if (pin && !detail::pin_this_thread(i))
+                {
+                    pinned.store(false, std::memory_order_relaxed);
+                }
+                try
+                {
+                    func(i);
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+
+        if (pin)
+        {
+#if defined (__linux__)
+            cleanup.restore = pthread_getaffinity_np(pthread_self(), sizeof(cleanup.previous), &cleanup.previous) == 0;
+#endif
+            if (!detail::pin_this_thread(0))
+            {
+                pinned.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        func(0);
+        cleanup.finish();
+
+        for (const std::exception_ptr& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+        return pinned.load(std::memory_order_relaxed);
+    }
+
+    namespace detail
+    {
+        //The size of a memory page, which first-touch placement works in
+        inline std::size_t page_size()
+        {
+#if defined (__linux__)
+            static const long size = sysconf(_SC_PAGESIZE);
+            return (size > 0) ? static_cast<std::size_t>(size) : 4096;
+#else
+            return 4096;
+#endif
+        }
+
+        inline std::size_t gcd(std::size_t a, std::size_t b)
+        {
+            while (b != 0)
+            {
+                std::size_t r = a % b;
+                a = b;
+                b = r;
+            }
+            return a;
+        }
+
+        template<typename T>
+        class uninit_array final
+        {
+        private:
+            void* m_allocation;
+            uninit<T>* m_data;
+            std::size_t m_size;
+
+            //Number of elements per chunk granule: the fewest whole elements that also span whole pages,
+            //so every chunk starts on a page boundary, whatever the element size
+            static std::size_t granularity()
+            {
+                const std::size_t page = page_size();
+                const std::size_t element = sizeof(uninit<T>);
+                return page / gcd(page, element);
+            }
+
+        public:
+            /// <summary>
+            /// Allocates size uninitialized values. The (empty) uninits are constructed across threads,
+            /// which is also where each page is first touched
+            /// </summary>
+            explicit uninit_array(std::size_t size, const parallel_options& options = parallel_options()) :
+                m_allocation(nullptr),
+                m_data(nullptr),
+                m_size(size)
+            {
+                static_assert(alignof(uninit<T>) <= 4096, "CPPSPT: over-aligned types are not supported by uninit_array!");
+
+                //Operator new does not touch the memory; align to a page by hand
+                const std::size_t page = page_size();
+                m_allocation = ::operator new(size * sizeof(uninit<T>) + page);
+                std::uintptr_t address = reinterpret_cast<std::uintptr_t>(m_allocation);
+                m_data = reinterpret_cast<uninit<T>*>((address + page - 1) & ~static_cast<std::uintptr_t>(page - 1));
+
+                //If a thread fails to start, only the chunks that were constructed are destroyed, and the memory is freed
+                const unsigned count = options.thread_count();
+                std::vector<char> constructed(count, 0);
+                try
+                {
+                    run_parallel(options, [&](unsigned index)
+                    {
+                        chunk_range range = partition(m_size, count, index, granularity());
+                        for (std::size_t i = range.begin; i < range.end; i++)
+                        {
+                            new (m_data + i) uninit<T>();
+                        }
+                        constructed[index] = 1;
+                    });
+                }
+                catch (...)
+                {
+                    for (unsigned index = 0; index < count; index++)
+                    {
+                        chunk_range range = partition(m_size, count, index, granularity());
+                        for (std::size_t i = range.begin; constructed[index] && i < range.end; i++)
+                        {
+                            m_data[i].~uninit<T>();
+                        }
+                    }
+                    ::operator delete(m_allocation);
+                    throw;
+                }
+            }
+
+            ~uninit_array()
+            {
+                for (std::size_t i = 0; i < m_size; i++)
+                {
+                    m_data[i].~uninit<T>();
+                }
+                ::operator delete(m_allocation);
+            }
+
+            uninit_array(const uninit_array<T>&) = delete;
+            uninit_array& operator=(const uninit_array<T>&) = delete;
+
+            /// <summary>
+            /// Calls func(first, last) for each thread's chunk, using the same split as initialization
+            /// </summary>
+            template<typename Func>
+            void parallel_for(const parallel_options& options, Func func)
+            {
+                const unsigned count = options.thread_count();
+                uninit<T>* data = m_data;
+                std::size_t size = m_size;
+
+                run_parallel(options, [&](unsigned index)
+                {
+                    chunk_range range = partition(size, count, index, granularity());
+                    func(data + range.begin, data + range.end);
+                });
+            }
+
+            /// <summary>
+            /// Constructs every uninitialized value from args, across threads.
+            /// If a constructor throws, the values constructed so far stay initialized (and are destroyed with the array)
+            /// </summary>
+            template<typename ... Args>
+            void parallel_init(const parallel_options& options, const Args& ... args)
+            {
+                parallel_for(options, [&](uninit<T>* first, uninit<T>* last)
+                {
+                    for (; first != last; ++first)
+                    {
+                        first->init(args...);
+                    }
+                });
+            }
+
+            /// <summary>
+            /// Destroys every initialized value, across threads
+            /// </summary>
+            void parallel_destroy(const parallel_options& options)
+            {
+                parallel_for(options, [](uninit<T>* first, uninit<T>* last)
+                {
+                    for (; first != last; ++first)
+                    {
+                        first->reset();
+                    }
+                });
+            }
+
+            std::size_t size() const { return m_size; }
+
+            uninit<T>* data() { return m_data; }
+            const uninit<T>* data() const { return m_data; }
+
+            uninit<T>* begin() { return m_data; }
+            uninit<T>* end() { return m_data + m_size; }
+            const uninit<T>* begin() const { return m_data; }
+            const uninit<T>* end() const { return m_data + m_size; }
+
+            uninit<T>& operator[](std::size_t index) { return m_data[index]; }
+            const uninit<T>& operator[](std::size_t index) const { return m_data[index]; }
+        };
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_PARALLEL_HPP
@@ -0,0 +1,455 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_QUEUE_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_QUEUE_HPP
+
+/*
+
+    Bounded lock-free queues whose slots are uninit values
+
+    A slot only holds a T between a push and a pop, so no T is ever default constructed or assigned.
+    push takes an in<T>: it move constructs into the slot if the caller moved, and copy constructs otherwise.
+    pop takes an out<T>: the value is moved straight into the caller's destination.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <thread>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename T>
+        class spsc_queue;
+
+        template<typename T>
+        class mpmc_queue;
+    }
+
+    /// <summary>
+    /// A bounded single-producer, single-consumer queue
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using spsc_queue = detail::spsc_queue<T>;
+
+    /// <summary>
+    /// A bounded multi-producer, multi-consumer queue
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using mpmc_queue = detail::mpmc_queue<T>;
+
+    namespace detail
+    {
+        //An index on its own cache line, so that producers and consumers don't false share
+        struct alignas(cache_line_size) padded_index
+        {
+            std::atomic<std::size_t> value;
+
+            padded_index() : value(0) {}
+        };
+
+        inline std::size_t round_up_to_power_of_2(std::size_t val)
+        {
+            std::size_t result = 1;
+            while (result < val)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        template<typename T>
+        class spsc_queue final
+        {
+        private:
+            //Only read after construction, by both sides, so on a line of their own that the index writes never invalidate
+            alignas(cache_line_size) std::unique_ptr<uninit<T>[]> m_slots;
+            std::size_t m_mask;
+
+            padded_index m_head;                    //Next slot to pop, written by the consumer
+            padded_index m_tail;                    //Next slot to push, written by the producer
+
+            alignas(cache_line_size) std::size_t m_cached_head;     //Producer's last view of m_head
+            alignas(cache_line_size) std::size_t m_cached_tail;     //Consumer's last view of m_tail
+
+            //Returns how many slots are free for the producer, refreshing the view of the head if needed
+            std::size_t free_slots(std::size_t tail, std::size_t wanted)
+            {
+                std::size_t capacity = m_mask + 1;
+                if (capacity - (tail - m_cached_head) < wanted)
+                {
+                    m_cached_head = m_head.value.load(std::memory_order_acquire);
+                }
+                return capacity - (tail - m_cached_head);
+            }
+
+            //Returns how many slots are full for the consumer, refreshing the view of the tail if needed
+            std::size_t full_slots(std::size_t head, std::size_t wanted)
+            {
+                if (m_cached_tail - head < wanted)
+                {
+                    m_cached_tail = m_tail.value.load(std::memory_order_acquire);
+                }
+                return m_cached_tail - head;
+            }
+
+        public:
+            /// <summary>
+            /// Creates a queue holding at least capacity values (rounded up to a power of 2)
+            /// </summary>
+            explicit spsc_queue(std::size_t capacity) :
+                m_slots(new uninit<T>[round_up_to_power_of_2(capacity)]),
+                m_mask(round_up_to_power_of_2(capacity) - 1),
+                m_cached_head(0),
+                m_cached_tail(0)
+            {
+            }
+
+            spsc_queue(const spsc_queue<T>&) = delete;
+            spsc_queue& operator=(const spsc_queue<T>&) = delete;
+
+            std::size_t capacity() const { return m_mask + 1; }
+
+            /// <summary>
+            /// Pushes a value, unless the queue is full. Producer only
+            /// </summary>
+            bool try_push(in<T> val)
+            {
+                std::size_t tail = m_tail.value.load(std::memory_order_relaxed);
+                if (free_slots(tail, 1) == 0)
+                {
+                    return false;
+                }
+
+                m_slots[tail & m_mask] = std::move(val);
+                m_tail.value.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            /// <summary>
+            /// Pushes as many values from [first, last) as fit, publishing them all at once. Producer only.
+            /// Values are copied, unless the iterators are move iterators.
+            /// Returns the number of values pushed
+            /// </summary>
+            template<typename It>
+            std::size_t try_push_n(It first, It last)
+            {
+                std::size_t tail = m_tail.value.load(std::memory_order_relaxed);
+                std::size_t wanted = static_cast<std::size_t>(std::distance(first, last));
+                std::size_t count = free_slots(tail, wanted);
+                count = (count < wanted) ? count : wanted;
+
+                for (std::size_t i = 0; i < count; i++, ++first)
+                {
+                    m_slots[(tail + i) & m_mask] = in<T>(*first);
+                }
+
+                m_tail.value.store(tail + count, std::memory_order_release);
+                return count;
+            }
+
+            /// <summary>
+            /// Pops a value into dest, unless the queue is empty. Consumer only
+            /// </summary>
+            bool try_pop(out<T> dest)
+            {
+                std::size_t head = m_head.value.load(std::memory_order_relaxed);
+                if (full_slots(head, 1) == 0)
+                {
+                    return false;
+                }
+
+                uninit<T>& slot = m_slots[head & m_mask];
+                dest = std::move(*slot);
+                slot.reset();
+                m_head.value.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            /// <summary>
+            /// Pops up to count values, moving them to dest, and frees their slots at once. Consumer only.
+            /// Returns the number of values popped
+            /// </summary>
+            template<typename OutIt>
+            std::size_t try_pop_n(OutIt dest, std::size_t count)
+            {
+                std::size_t head = m_head.value.load(std::memory_order_relaxed);
+                std::size_t available = full_slots(head, count);
+                count = (available < count) ? available : count;
+
+                for (std::size_t i = 0; i < count; i++, ++dest)
+                {
+                    uninit<T>& slot = m_slots[(head + i) & m_mask];
+                    *dest = std::move(*slot);
+                    slot.reset();
+                }
+
+                m_head.value.store(head + count, std::memory_order_release);
+                return count;
+            }
+
+            /// <summary>
+            /// Pushes a value, waiting for space if the queue is full. Producer only
+            /// </summary>
+            void push(in<T> val)
+            {
+                while (!try_push(in<T>(std::move(val))))
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            /// <summary>
+            /// Pops a value, waiting for one if the queue is empty. Consumer only
+            /// </summary>
+            void pop(out<T> dest)
+            {
+                while (!try_pop(dest))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        };
+
+        /*
+
+            The multi-producer, multi-consumer queue gives each slot a sequence number (as in Dmitry Vyukov's bounded queue).
+            A slot at position p is free to push when its sequence is p, and ready to pop when its sequence is p + 1.
+
+            A claimed slot is always handed on, even if copying or moving a T throws, as every later push and pop waits for it:
+            a push that threw leaves its slot without a value, which pops skip, and a pop that threw drops its value.
+
+        */
+
+        template<typename T>
+        class mpmc_queue final
+        {
+        private:
+            struct slot
+            {
+                std::atomic<std::size_t> sequence;
+                uninit<T> value;
+            };
+
+            padded_index m_head;
+            padded_index m_tail;
+
+            std::unique_ptr<slot[]> m_slots;
+            std::size_t m_mask;
+
+            //Hands the claimed positions [next, end) on to the other side, one at a time, and the rest when destroyed (by a throw)
+            struct claimed_slots
+            {
+                mpmc_queue& queue;
+                std::size_t next;
+                std::size_t end;
+                bool popping;
+
+                ~claimed_slots()
+                {
+                    while (next != end)
+                    {
+                        hand_on();
+                    }
+                }
+
+                slot& current() const
+                {
+                    return queue.m_slots[next & queue.m_mask];
+                }
+
+                void hand_on()
+                {
+                    slot& s = current();
+                    if (popping)
+                    {
+                        s.value.reset();
+                        s.sequence.store(next + queue.m_mask + 1, std::memory_order_release);
+                    }
+                    else
+                    {
+                        s.sequence.store(next + 1, std::memory_order_release);
+                    }
+                    next++;
+                }
+            };
+
+            //Claims up to wanted consecutive positions from index, whose slots have the sequence (position + offset)
+            //Returns the first position claimed, and stores the number claimed in count (0 if there were none)
+            std::size_t claim(padded_index& index, std::size_t offset, std::size_t wanted, std::size_t& count)
+            {
+                std::size_t pos = index.value.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    count = 0;
+                    while (count < wanted && m_slots[(pos + count) & m_mask].sequence.load(std::memory_order_acquire) == pos + count + offset)
+                    {
+                        count++;
+                    }
+
+                    if (count == 0)
+                    {
+                        std::size_t seq = m_slots[pos & m_mask].sequence.load(std::memory_order_acquire);
+                        std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq - (pos + offset));
+                        if (diff < 0)
+                        {
+                            //Full (for producers) or empty (for consumers)
+                            return pos;
+                        }
+
+                        //Another thread claimed this position; try again from the new index
+                        pos = index.value.load(std::memory_order_relaxed);
+                        continue;
+                    }
+
+                    if (index.value.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+                    {
+                        return pos;
+                    }
+                }
+            }
+
+        public:
+            /// <summary>
+            /// Creates a queue holding at least capacity values (rounded up to a power of 2)
+            /// </summary>
+            explicit mpmc_queue(std::size_t capacity) :
+                m_slots(new slot[round_up_to_power_of_2(capacity)]),
+                m_mask(round_up_to_power_of_2(capacity) - 1)
+            {
+                for (std::size_t i = 0; i <= m_mask; i++)
+                {
+                    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            mpmc_queue(const mpmc_queue<T>&) = delete;
+            mpmc_queue& operator=(const mpmc_queue<T>&) = delete;
+
+            std::size_t capacity() const { return m_mask + 1; }
+
+            /// <summary>
+            /// Pushes a value, unless the queue is full
+            /// </summary>
+            bool try_push(in<T> val)
+            {
+                std::size_t count;
+                std::size_t pos = claim(m_tail, 0, 1, count);
+                if (count == 0)
+                {
+                    return false;
+                }
+
+                claimed_slots claimed{ *this, pos, pos + 1, false };
+                claimed.current().value = std::move(val);
+                return true;
+            }
+
+            /// <summary>
+            /// Claims as many slots as are free for [first, last) with a single update of the tail, then fills them.
+            /// Values are copied, unless the iterators are move iterators.
+            /// Returns the number of values pushed
+            /// </summary>
+            template<typename It>
+            std::size_t try_push_n(It first, It last)
+            {
+                std::size_t count;
+                std::size_t pos = claim(m_tail, 0, static_cast<std::size_t>(std::distance(first, last)), count);
+
+                claimed_slots claimed{ *this, pos, pos + count, false };
+                for (; claimed.next != claimed.end; ++first)
+                {
+                    claimed.current().value = in<T>(*first);
+                    claimed.hand_on();
+                }
+                return count;
+            }
+
+            /// <summary>
+            /// Pops a value into dest, unless the queue is empty
+            /// </summary>
+            bool try_pop(out<T> dest)
+            {
+                for (;;)
+                {
+                    std::size_t count;
+                    std::size_t pos = claim(m_head, 1, 1, count);
+                    if (count == 0)
+                    {
+                        return false;
+                    }
+
+                    claimed_slots claimed{ *this, pos, pos + 1, true };
+                    uninit<T>& value = claimed.current().value;
+                    if (value.was_initialized())
+                    {
+                        dest = std::move(*value);
+                        return true;
+                    }
+                }
+            }
+
+            /// <summary>
+            /// Claims up to count ready values with a single update of the head, and moves them to dest.
+            /// Returns the number of values popped (fewer than were claimed if pushes threw)
+            /// </summary>
+            template<typename OutIt>
+            std::size_t try_pop_n(OutIt dest, std::size_t count)
+            {
+                std::size_t ready;
+                std::size_t pos = claim(m_head, 1, count, ready);
+
+                std::size_t popped = 0;
+                claimed_slots claimed{ *this, pos, pos + ready, true };
+                while (claimed.next != claimed.end)
+                {
+                    uninit<T>& value = claimed.current().value;
+                    if (value.was_initialized())
+                    {
+                        *dest = std::move(*value);
+                        ++dest;
+                        popped++;
+                    }
+                    claimed.hand_on();
+                }
+                return popped;
+            }
+
+            /// <summary>
+            /// Pushes a value, waiting for space if the queue is full
+            /// </summary>
+            void push(in<T> val)
+            {
+                while (!try_push(in<T>(std::move(val))))
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            /// <summary>
+            /// Pops a value, waiting for one if the queue is empty
+            /// </summary>
+            void pop(out<T> dest)
+            {
+                while (!try_pop(dest))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        };
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_QUEUE_HPP
@@ -0,0 +1,428 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_RECORD_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_RECORD_HPP
+
+/*
+
+    A tuple of deferred fields, sharing one mask of initialized bits
+
+    A struct of several uninit members pays a bool (and its padding) for every field.
+    uninit_record<Ts...> lays its fields out like a tuple, with no per-field flags,
+    and keeps every initialized bit in the smallest unsigned integer that holds them.
+
+    get<I>() returns a handle to a field, which can be assigned or passed as an out<T>.
+    Destroying the record only visits the fields whose bits are set.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename ... Ts>
+        class uninit_record;
+
+        template<typename T>
+        class record_field;
+    }
+
+    /// <summary>
+    /// A tuple of uninit fields, whose initialized flags share one small integer
+    /// </summary>
+    /// <typeparam name="Ts"></typeparam>
+    template<typename ... Ts>
+    using uninit_record = detail::uninit_record<Ts...>;
+
+    /// <summary>
+    /// A handle to one field of an uninit_record. Can be assigned, or passed as an out parameter
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using record_field = detail::record_field<T>;
+
+    namespace detail
+    {
+        //The smallest unsigned integer with a bit for each of N fields
+        template<std::size_t N>
+        using record_mask = typename std::conditional<(N <= 8), std::uint8_t,
+            typename std::conditional<(N <= 16), std::uint16_t,
+            typename std::conditional<(N <= 32), std::uint32_t, std::uint64_t>::type>::type>::type;
+
+        inline int record_lowest_bit(std::uint64_t bits)
+        {
+#if defined (_MSC_VER) && !defined (__clang__)
+            int bit = 0;
+            while ((bits & 1) == 0)
+            {
+                bits >>= 1;
+                bit++;
+            }
+            return bit;
+#else
+            return __builtin_ctzll(bits);
+#endif
+        }
+
+        /*
+
+            Field storage: each field in a union (so it isn't constructed), followed by the rest.
+            The last field has no 'rest' member, so no empty struct is padded onto the end.
+
+        */
+
+        template<typename ... Ts>
+        struct record_storage
+        {
+        };
+
+        template<typename T>
+        struct record_storage<T>
+        {
+            union
+            {
+                T value;
+            };
+
+            record_storage() {}
+            ~record_storage() {}
+        };
+
+        template<typename T, typename ... Rest>
+        struct record_storage<T, Rest...>
+        {
+            union
+            {
+                T value;
+            };
+            record_storage<Rest...> rest;
+
+            record_storage() {}
+            ~record_storage() {}
+        };
+
+        template<bool ... Bs>
+        struct record_all_of : std::true_type {};
+
+        template<bool B, bool ... Bs>
+        struct record_all_of<B, Bs...> : std::integral_constant<bool, B && record_all_of<Bs...>::value> {};
+
+        template<std::size_t I>
+        struct record_access
+        {
+            template<typename Storage>
+            static auto& get(Storage& storage)
+            {
+                return record_access<I - 1>::get(storage.rest);
+            }
+        };
+
+        template<>
+        struct record_access<0>
+        {
+            template<typename Storage>
+            static auto& get(Storage& storage)
+            {
+                return storage.value;
+            }
+        };
+
+        template<typename T>
+        class record_field final
+        {
+        private:
+            out_sink<T> m_sink;
+
+        public:
+            record_field(out_sink<T> sink) : m_sink(sink) {}
+
+            bool was_initialized() const
+            {
+                return m_sink.is_set(m_sink.flags, m_sink.index);
+            }
+
+            record_field& operator=(in<T> val)
+            {
+                out<T> target(m_sink);
+                target = std::move(val);
+                return *this;
+            }
+
+            //Lets the field be passed as an out parameter. The out points to this handle's sink, so it must not outlive the handle,
+            //and a temporary handle (which would be gone by the end of the statement) can't be converted
+            operator out<T>() &
+            {
+                return out<T>(m_sink);
+            }
+
+            operator out<T>() && = delete;
+
+            T& operator*()
+            {
+                CPPSPT_ASSERT(was_initialized() && "Attempting to read from uninit value!");
+
+                return *m_sink.value;
+            }
+
+            T* operator->()
+            {
+                return &**this;
+            }
+        };
+
+        template<typename ... Ts>
+        class uninit_record final
+        {
+        public:
+            using mask_type = record_mask<sizeof...(Ts)>;
+
+            template<std::size_t I>
+            using field_type = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+
+            static const std::size_t field_count = sizeof...(Ts);
+
+        private:
+            static_assert(sizeof...(Ts) <= 64, "CPPSPT: uninit_record supports up to 64 fields!");
+
+            static const bool nothrow_move = record_all_of<std::is_nothrow_move_constructible<Ts>::value...>::value;
+
+            record_storage<Ts...> m_fields;
+            mask_type m_initialized;
+
+            static mask_type full_mask()
+            {
+                return (sizeof...(Ts) == 0) ? mask_type(0) : static_cast<mask_type>(static_cast<mask_type>(~mask_type(0)) >> (8 * sizeof(mask_type) - sizeof...(Ts)));
+            }
+
+            static mask_type bit(std::size_t index)
+            {
+                return static_cast<mask_type>(mask_type(1) << index);
+            }
+
+            static bool is_set(const void* flags, unsigned index)
+            {
+                return (*static_cast<const mask_type*>(flags) & bit(index)) != 0;
+            }
+
+            static void set(void* flags, unsigned index)
+            {
+                *static_cast<mask_type*>(flags) |= bit(index);
+            }
+
+            template<std::size_t I>
+            void destroy_field()
+            {
+                using T = field_type<I>;
+                record_access<I>::get(m_fields).~T();
+            }
+
+            template<std::size_t I>
+            void copy_field(const uninit_record& other)
+            {
+                using T = field_type<I>;
+                new (&record_access<I>::get(m_fields)) T(record_access<I>::get(other.m_fields));
+            }
+
+            template<std::size_t I>
+            void move_field(uninit_record& other)
+            {
+                using T = field_type<I>;
+                new (&record_access<I>::get(m_fields)) T(std::move(record_access<I>::get(other.m_fields)));
+            }
+
+            //The fields are only known by index at runtime when walking the mask, so each walk goes through a table
+            template<std::size_t ... Is>
+            void destroy_set(std::index_sequence<Is...>)
+            {
+                using destroyer = void (uninit_record::*)();
+                static const destroyer destroyers[] = { &uninit_record::destroy_field<Is>..., nullptr };
+
+                for (std::uint64_t bits = m_initialized; bits != 0; bits &= bits - 1)
+                {
+                    (this->*destroyers[record_lowest_bit(bits)])();
+                }
+                m_initialized = 0;
+            }
+
+            template<std::size_t ... Is>
+            void copy_set(const uninit_record& other, std::index_sequence<Is...>)
+            {
+                using copier = void (uninit_record::*)(const uninit_record&);
+                static const copier copiers[] = { &uninit_record::copy_field<Is>..., nullptr };
+
+                //Each bit is set as its field is built, so if one throws, exactly the fields built so far are destroyed
+                for (std::uint64_t bits = other.m_initialized; bits != 0; bits &= bits - 1)
+                {
+                    const int index = record_lowest_bit(bits);
+                    (this->*copiers[index])(other);
+                    m_initialized |= bit(index);
+                }
+            }
+
+            template<std::size_t ... Is>
+            void move_set(uninit_record& other, std::index_sequence<Is...>)
+            {
+                using mover = void (uninit_record::*)(uninit_record&);
+                static const mover movers[] = { &uninit_record::move_field<Is>..., nullptr };
+
+                //Each bit is set as its field is built, so if one throws, exactly the fields built so far are destroyed
+                for (std::uint64_t bits = other.m_initialized; bits != 0; bits &= bits - 1)
+                {
+                    const int index = record_lowest_bit(bits);
+                    (this->*movers[index])(other);
+                    m_initialized |= bit(index);
+                }
+            }
+
+        public:
+            uninit_record() : m_initialized(0) {}
+
+            ~uninit_record()
+            {
+                reset();
+            }
+
+            //The destructor doesn't run if a constructor throws, so the fields built so far are destroyed here
+            uninit_record(const uninit_record& other) : m_initialized(0)
+            {
+                try
+                {
+                    copy_set(other, std::index_sequence_for<Ts...>());
+                }
+                catch (...)
+                {
+                    reset();
+                    throw;
+                }
+            }
+
+            //Moves the initialized fields, which stay initialized (as moved-from values) in other.
+            //noexcept when every field's move is, so that std::vector moves (rather than copies) records when it grows
+            uninit_record(uninit_record&& other) noexcept(nothrow_move) : m_initialized(0)
+            {
+                try
+                {
+                    move_set(other, std::index_sequence_for<Ts...>());
+                }
+                catch (...)
+                {
+                    reset();
+                    throw;
+                }
+            }
+
+            //Assignment destroys every field first, then copies (or moves) the initialized fields of other
+            uninit_record& operator=(const uninit_record& other)
+            {
+                if (&other != this)
+                {
+                    reset();
+                    copy_set(other, std::index_sequence_for<Ts...>());
+                }
+                return *this;
+            }
+
+            uninit_record& operator=(uninit_record&& other) noexcept(nothrow_move)
+            {
+                if (&other != this)
+                {
+                    reset();
+                    move_set(other, std::index_sequence_for<Ts...>());
+                }
+                return *this;
+            }
+
+            /// <summary>
+            /// A handle to field I, which can be assigned, or passed as an out parameter
+            /// </summary>
+            template<std::size_t I>
+            record_field<field_type<I>> get()
+            {
+                out_sink<field_type<I>> sink;
+                sink.value = &record_access<I>::get(m_fields);
+                sink.flags = &m_initialized;
+                sink.index = static_cast<unsigned>(I);
+                sink.is_set = &uninit_record::is_set;
+                sink.set = &uninit_record::set;
+                return record_field<field_type<I>>(sink);
+            }
+
+            template<std::size_t I>
+            field_type<I>& value()
+            {
+                CPPSPT_ASSERT(was_initialized<I>() && "Attempting to read from uninit value!");
+
+                return record_access<I>::get(m_fields);
+            }
+
+            template<std::size_t I>
+            const field_type<I>& value() const
+            {
+                CPPSPT_ASSERT(was_initialized<I>() && "Attempting to read from uninit value!");
+
+                return record_access<I>::get(m_fields);
+            }
+
+            template<std::size_t I>
+            bool was_initialized() const
+            {
+                return (m_initialized & bit(I)) != 0;
+            }
+
+            /// <summary>
+            /// Constructs field I in place, unless it is already initialized
+            /// </summary>
+            template<std::size_t I, typename ... Args>
+            void init(Args&& ... args)
+            {
+                if (!was_initialized<I>())
+                {
+                    new (&record_access<I>::get(m_fields)) field_type<I>(std::forward<Args>(args)...);
+                    m_initialized |= bit(I);
+                }
+            }
+
+            /// <summary>
+            /// Destroys field I, if it is initialized
+            /// </summary>
+            template<std::size_t I>
+            void reset()
+            {
+                if (was_initialized<I>())
+                {
+                    destroy_field<I>();
+                    m_initialized &= static_cast<mask_type>(~bit(I));
+                }
+            }
+
+            /// <summary>
+            /// Destroys every initialized field
+            /// </summary>
+            void reset()
+            {
+                destroy_set(std::index_sequence_for<Ts...>());
+            }
+
+            bool all_initialized() const { return m_initialized == full_mask(); }
+            bool any_initialized() const { return m_initialized != 0; }
+
+            //Bit I is set when field I is initialized
+            mask_type initialized_mask() const { return m_initialized; }
+        };
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_RECORD_HPP
@@ -0,0 +1,329 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_RELOCATE_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_RELOCATE_HPP
+
+/*
+
+    Relocating uninit values: moving them to new storage, and ending their lifetime in the old
+
+    By default a relocation is a move construction into the new storage, then a destruction of the source.
+    Many types (handles, owning pointers, most containers) are left exactly as they were by that pair,
+    if their bytes are simply copied instead. is_trivially_relocatable marks those types: it's true for trivially copyable types,
+    and other types opt in by specializing it. Their relocations are then a single memmove of the whole range.
+
+    uninit_vector is a growable array of uninit slots, which relocates its elements when it grows and when it erases.
+    Relocating by move can't be undone if a move throws, so a type whose move may throw (and which isn't relocatable)
+    is copied when the vector grows, and shifted by move assignment when it erases, like std::vector.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cppspt
+{
+    /// <summary>
+    /// Whether a T can be relocated by copying its bytes, without calling its move constructor and destructor.
+    /// True for trivially copyable types. Specialize it (deriving from std::true_type) to opt other types in
+    /// </summary>
+    template<typename T>
+    struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+    //An owning pointer is relocatable when its deleter is (the default deleter is empty)
+    template<typename T, typename D>
+    struct is_trivially_relocatable<std::unique_ptr<T, D>> : is_trivially_relocatable<D> {};
+
+    //An uninit is its value's bytes plus a flag
+    template<typename T>
+    struct is_trivially_relocatable<detail::uninit<T>> : is_trivially_relocatable<T> {};
+
+    namespace detail
+    {
+        template<typename T>
+        class uninit_vector;
+
+        template<typename T>
+        void relocate_n(uninit<T>* first, std::size_t count, uninit<T>* dest, std::true_type)
+        {
+            if (count != 0)
+            {
+                std::memmove(static_cast<void*>(dest), static_cast<const void*>(first), count * sizeof(uninit<T>));
+            }
+        }
+
+        //If a move throws, the range is left partly relocated, so uninit_vector only uses this for types whose move can't throw
+        template<typename T>
+        void relocate_n(uninit<T>* first, std::size_t count, uninit<T>* dest, std::false_type)
+        {
+            //Copies in the direction that never overwrites a source before it has been moved
+            if (dest < first || dest >= first + count)
+            {
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    new (dest + i) uninit<T>(std::move(first[i]));
+                    first[i].~uninit<T>();
+                }
+            }
+            else
+            {
+                for (std::size_t i = count; i > 0; i--)
+                {
+                    new (dest + i - 1) uninit<T>(std::move(first[i - 1]));
+                    first[i - 1].~uninit<T>();
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// A growable array of uninit slots, which relocates (rather than moves & destroys) its slots
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using uninit_vector = detail::uninit_vector<T>;
+
+    /// <summary>
+    /// Relocates the count uninits at first (initialized or not) into the raw storage at dest, which may overlap them.
+    /// Afterwards the uninits at dest are alive, and the storage at first (where not overlapped) is raw.
+    /// T's move must not throw, unless T is trivially relocatable
+    /// </summary>
+    template<typename T>
+    void relocate_n(uninit<T>* first, std::size_t count, uninit<T>* dest)
+    {
+        detail::relocate_n(first, count, dest, is_trivially_relocatable<T>());
+    }
+
+    /// <summary>
+    /// Relocates one uninit into the raw storage at dest
+    /// </summary>
+    template<typename T>
+    void relocate(uninit<T>* source, uninit<T>* dest)
+    {
+        relocate_n(source, 1, dest);
+    }
+
+    namespace detail
+    {
+        //Whether relocating a T can't throw, so that relocate_n can't stop halfway
+        template<typename T>
+        struct is_nothrow_relocatable : std::integral_constant<bool, is_trivially_relocatable<T>::value || std::is_nothrow_move_constructible<T>::value> {};
+
+        template<typename T>
+        void transfer_n(uninit<T>* first, std::size_t count, uninit<T>* dest, std::true_type)
+        {
+            cppspt::relocate_n(first, count, dest);
+        }
+
+        //Copies (or, if T can only be moved, moves) the count uninits at first into the raw storage at dest, which must not overlap them.
+        //The sources are only destroyed once every copy has been built, so if one throws, the copies are destroyed and the sources kept
+        template<typename T>
+        void transfer_n(uninit<T>* first, std::size_t count, uninit<T>* dest, std::false_type)
+        {
+            using source = typename std::conditional<std::is_copy_constructible<T>::value, const uninit<T>&, uninit<T>&&>::type;
+
+            std::size_t built = 0;
+            try
+            {
+                for (; built < count; built++)
+                {
+                    new (dest + built) uninit<T>(static_cast<source>(first[built]));
+                }
+            }
+            catch (...)
+            {
+                while (built > 0)
+                {
+                    dest[--built].~uninit<T>();
+                }
+                throw;
+            }
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                first[i].~uninit<T>();
+            }
+        }
+
+        template<typename T>
+        class uninit_vector final
+        {
+        private:
+            uninit<T>* m_data;
+            std::size_t m_size;
+            std::size_t m_capacity;
+
+            void reallocate(std::size_t capacity)
+            {
+                static_assert(alignof(uninit<T>) <= alignof(std::max_align_t), "CPPSPT: over-aligned types are not supported by uninit_vector!");
+
+                uninit<T>* data = static_cast<uninit<T>*>(::operator new(capacity * sizeof(uninit<T>)));
+                try
+                {
+                    transfer_n(m_data, m_size, data, is_nothrow_relocatable<T>());
+                }
+                catch (...)
+                {
+                    ::operator delete(data);
+                    throw;
+                }
+                ::operator delete(m_data);
+
+                m_data = data;
+                m_capacity = capacity;
+            }
+
+            void grow()
+            {
+                reallocate(m_capacity != 0 ? m_capacity * 2 : 4);
+            }
+
+            void erase_slot(std::size_t index, std::true_type)
+            {
+                m_data[index].~uninit<T>();
+                cppspt::relocate_n(m_data + index + 1, m_size - index - 1, m_data + index);
+                m_size--;
+            }
+
+            //Shifted down by move assignment, so every slot is still alive if a move throws
+            void erase_slot(std::size_t index, std::false_type)
+            {
+                for (std::size_t i = index; i + 1 < m_size; i++)
+                {
+                    m_data[i] = std::move(m_data[i + 1]);
+                }
+                m_data[--m_size].~uninit<T>();
+            }
+
+        public:
+            uninit_vector() : m_data(nullptr), m_size(0), m_capacity(0) {}
+
+            uninit_vector(uninit_vector<T>&& other) :
+                m_data(other.m_data),
+                m_size(other.m_size),
+                m_capacity(other.m_capacity)
+            {
+                other.m_data = nullptr;
+                other.m_size = 0;
+                other.m_capacity = 0;
+            }
+
+            uninit_vector(const uninit_vector<T>&) = delete;
+            uninit_vector& operator=(const uninit_vector<T>&) = delete;
+
+            ~uninit_vector()
+            {
+                clear();
+                ::operator delete(m_data);
+            }
+
+            std::size_t size() const { return m_size; }
+            std::size_t capacity() const { return m_capacity; }
+            bool empty() const { return m_size == 0; }
+
+            void reserve(std::size_t capacity)
+            {
+                if (capacity > m_capacity)
+                {
+                    reallocate(capacity);
+                }
+            }
+
+            /// <summary>
+            /// Appends a slot holding val (moved in if the caller moved, and copied otherwise)
+            /// </summary>
+            uninit<T>& push_back(in<T> val)
+            {
+                if (m_size == m_capacity)
+                {
+                    //val may refer to an element, which growing relocates: find it again afterwards
+                    const char* address = reinterpret_cast<const char*>(&*val);
+                    const char* first = reinterpret_cast<const char*>(m_data);
+                    if (m_data != nullptr && address >= first && address < first + m_size * sizeof(uninit<T>))
+                    {
+                        std::size_t index = static_cast<std::size_t>(address - first) / sizeof(uninit<T>);
+                        bool was_moved = val.was_moved();
+                        grow();
+
+                        T& element = *m_data[index];
+                        return *new (m_data + m_size++) uninit<T>(was_moved ? in<T>(std::move(element)) : in<T>(element));
+                    }
+                    grow();
+                }
+                return *new (m_data + m_size++) uninit<T>(std::move(val));
+            }
+
+            /// <summary>
+            /// Appends a slot holding a T constructed from args (which must not refer to elements)
+            /// </summary>
+            template<typename ... Args>
+            uninit<T>& emplace_back(Args&& ... args)
+            {
+                uninit<T>& slot = push_back_uninit();
+                slot.init(std::forward<Args>(args)...);
+                return slot;
+            }
+
+            /// <summary>
+            /// Appends an uninitialized slot
+            /// </summary>
+            uninit<T>& push_back_uninit()
+            {
+                if (m_size == m_capacity)
+                {
+                    grow();
+                }
+                return *new (m_data + m_size++) uninit<T>();
+            }
+
+            /// <summary>
+            /// Destroys the slot at index, and relocates the slots after it down by one (or move assigns them, if their move may throw)
+            /// </summary>
+            void erase(std::size_t index)
+            {
+                CPPSPT_ASSERT(index < m_size && "CPPSPT: erasing past the end of an uninit_vector!");
+
+                erase_slot(index, is_nothrow_relocatable<T>());
+            }
+
+            void pop_back()
+            {
+                CPPSPT_ASSERT(m_size != 0 && "CPPSPT: popping from an empty uninit_vector!");
+
+                m_data[--m_size].~uninit<T>();
+            }
+
+            void clear()
+            {
+                for (std::size_t i = 0; i < m_size; i++)
+                {
+                    m_data[i].~uninit<T>();
+                }
+                m_size = 0;
+            }
+
+            uninit<T>& operator[](std::size_t index) { return m_data[index]; }
+            const uninit<T>& operator[](std::size_t index) const { return m_data[index]; }
+
+            uninit<T>* data() { return m_data; }
+            const uninit<T>* data() const { return m_data; }
+
+            uninit<T>* begin() { return m_data; }
+            uninit<T>* end() { return m_data + m_size; }
+            const uninit<T>* begin() const { return m_data; }
+            const uninit<T>* end() const { return m_data + m_size; }
+        };
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_RELOCATE_HPP
@@ -0,0 +1,321 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_RETIRE_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_RETIRE_HPP
+
+/*
+
+    Deferred destruction, to keep expensive destructors off the hot path
+
+    Destroying a large string, vector or tree frees memory, which can take a long time in the middle of handling a request.
+    Instead, a value can be retired: moved into a retire_buffer (one per thread), which hands full batches to a retire_queue.
+    The queue destroys the batches later: on its background thread, or in drain() at a safe point.
+
+    Memory is bounded: once the queue holds max_pending values, a thread that retires more destroys its own batch instead.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename T>
+        class retire_buffer;
+    }
+
+    /// <summary>
+    /// Collects retired values of type T on one thread, and hands them to a retire_queue in batches
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using retire_buffer = detail::retire_buffer<T>;
+
+    /// <summary>
+    /// How a retire_queue batches and bounds retired values
+    /// </summary>
+    struct retire_options
+    {
+        //Values a retire_buffer collects before handing them to the queue
+        std::size_t batch_size = 64;
+
+        //Values the queue holds before retiring threads have to destroy their own batches (0 is unbounded)
+        std::size_t max_pending = 64 * 1024;
+
+        retire_options() {}
+        retire_options(std::size_t batch_size_, std::size_t max_pending_) : batch_size(batch_size_), max_pending(max_pending_) {}
+    };
+
+    /// <summary>
+    /// Batches of retired values, waiting to be destroyed
+    /// </summary>
+    class retire_queue
+    {
+    private:
+        //A type erased batch: a heap allocated std::vector<T>, and how to destroy it
+        struct batch
+        {
+            void* values;
+            std::size_t count;
+            void (*destroy)(void* values);
+        };
+
+        retire_options m_options;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::vector<batch> m_batches;
+        std::size_t m_pending;
+        std::size_t m_destroyed_inline;
+        bool m_stopping;
+        std::thread m_thread;
+
+        //Destroys the batches taken off the queue, outside the lock
+        static void destroy_all(std::vector<batch>& batches)
+        {
+            for (batch& b : batches)
+            {
+                b.destroy(b.values);
+            }
+            batches.clear();
+        }
+
+        void run()
+        {
+            std::vector<batch> taken;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (;;)
+            {
+                m_wake.wait(lock, [this] { return m_stopping || !m_batches.empty(); });
+                if (m_batches.empty())
+                {
+                    return;
+                }
+
+                taken.swap(m_batches);
+                m_pending = 0;
+
+                lock.unlock();
+                destroy_all(taken);
+                lock.lock();
+            }
+        }
+
+    public:
+        explicit retire_queue(const retire_options& options = retire_options()) :
+            m_options(options),
+            m_pending(0),
+            m_destroyed_inline(0),
+            m_stopping(false)
+        {
+        }
+
+        /// <summary>
+        /// Stops the background thread (if any), and destroys everything still pending
+        /// </summary>
+        ~retire_queue()
+        {
+            stop();
+            drain();
+        }
+
+        retire_queue(const retire_queue&) = delete;
+        retire_queue& operator=(const retire_queue&) = delete;
+
+        const retire_options& options() const { return m_options; }
+
+        /// <summary>
+        /// Starts a background thread, which destroys batches as they arrive
+        /// </summary>
+        void start()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_thread.joinable())
+            {
+                m_stopping = false;
+                m_thread = std::thread([this] { run(); });
+            }
+        }
+
+        /// <summary>
+        /// Stops the background thread, after it destroys what is pending
+        /// </summary>
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+
+            if (m_thread.joinable())
+            {
+                m_thread.join();
+            }
+        }
+
+        /// <summary>
+        /// Destroys every pending batch on the calling thread. Returns the number of values destroyed
+        /// </summary>
+        std::size_t drain()
+        {
+            std::vector<batch> taken;
+            std::size_t count;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                taken.swap(m_batches);
+                count = m_pending;
+                m_pending = 0;
+            }
+            destroy_all(taken);
+            return count;
+        }
+
+        /// <summary>
+        /// Takes a batch of values (a std::vector<T>), unless the queue is full, in which case they're destroyed here
+        /// </summary>
+        template<typename T>
+        void push(std::vector<T>&& values)
+        {
+            if (values.empty())
+            {
+                return;
+            }
+
+            std::size_t count = values.size();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_options.max_pending == 0 || m_pending + count <= m_options.max_pending)
+                {
+                    batch b;
+                    b.values = new std::vector<T>(std::move(values));
+                    b.count = count;
+                    b.destroy = [](void* ptr) { delete static_cast<std::vector<T>*>(ptr); };
+                    m_batches.push_back(b);
+                    m_pending += count;
+                    count = 0;
+                }
+                else
+                {
+                    m_destroyed_inline += count;
+                }
+            }
+
+            if (count == 0)
+            {
+                m_wake.notify_one();
+            }
+            else
+            {
+                //Backpressure: the queue is full, so pay for this batch now
+                values.clear();
+            }
+        }
+
+        /// <summary>
+        /// The number of values waiting to be destroyed
+        /// </summary>
+        std::size_t pending()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_pending;
+        }
+
+        /// <summary>
+        /// The number of values that retiring threads had to destroy themselves, because the queue was full
+        /// </summary>
+        std::size_t destroyed_inline()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_destroyed_inline;
+        }
+    };
+
+    namespace detail
+    {
+        template<typename T>
+        class retire_buffer final
+        {
+        private:
+            retire_queue& m_queue;
+            std::vector<T> m_batch;
+
+        public:
+            explicit retire_buffer(retire_queue& queue) : m_queue(queue)
+            {
+                m_batch.reserve(queue.options().batch_size);
+            }
+
+            //Hands anything left to the queue
+            ~retire_buffer()
+            {
+                flush();
+            }
+
+            retire_buffer(const retire_buffer&) = delete;
+            retire_buffer& operator=(const retire_buffer&) = delete;
+
+            /// <summary>
+            /// Takes over a value, to be destroyed later
+            /// </summary>
+            void retire(move<T> val)
+            {
+                m_batch.push_back(std::move(val));
+                if (m_batch.size() >= m_queue.options().batch_size)
+                {
+                    flush();
+                }
+            }
+
+            /// <summary>
+            /// Takes over the value of an uninit (if any), leaving it uninitialized
+            /// </summary>
+            void retire(uninit<T>& val)
+            {
+                if (val.was_initialized())
+                {
+                    retire(std::move(*val));
+                    val.reset();
+                }
+            }
+
+            /// <summary>
+            /// Assigns to an uninit, retiring its old value rather than destroying it or assigning over it
+            /// </summary>
+            void assign(uninit<T>& target, in<T> val)
+            {
+                retire(target);
+                target = std::move(val);
+            }
+
+            /// <summary>
+            /// Hands the values collected so far to the queue
+            /// </summary>
+            void flush()
+            {
+                if (!m_batch.empty())
+                {
+                    m_queue.push(std::move(m_batch));
+                    m_batch = std::vector<T>();
+                    m_batch.reserve(m_queue.options().batch_size);
+                }
+            }
+
+            std::size_t size() const { return m_batch.size(); }
+        };
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_RETIRE_HPP
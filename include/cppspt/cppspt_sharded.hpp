@@ -0,0 +1,178 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_SHARDED_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_SHARDED_HPP
+
+/*
+
+    A result written by several threads at once, one shard per thread, reduced at the end
+
+    Threads sharing one out<T> need a mutex or atomics around every write. An array of uninit<T>, one per thread,
+    avoids both, but neighbouring slots share cache lines, so every write still bounces the line between cores.
+    sharded_out<T> pads each thread's uninit<T> to its own cache line. A shard is constructed by its thread's first write,
+    so shards which are never written cost nothing to reduce, and each is first touched by the thread that uses it.
+
+    reduce() folds the written shards (in index order) with a combine(a, b) -> T, writes the result to an out<T>,
+    and leaves every shard empty again.
+
+        cppspt::sharded_out<long long> sum(options.thread_count());
+        cppspt::run_parallel(options, [&](unsigned index)
+        {
+            for (...)
+            {
+                sum.accumulate(index, value, std::plus<long long>());
+            }
+        });
+        sum.reduce(total, std::plus<long long>());
+
+*/
+
+#include "cppspt/cppspt.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename T>
+        class sharded_out;
+    }
+
+    /// <summary>
+    /// One lazily constructed uninit<T> per thread, each on its own cache line, reduced into an out<T> at the end
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using sharded_out = detail::sharded_out<T>;
+
+    namespace detail
+    {
+        template<typename T>
+        class sharded_out final
+        {
+        private:
+            //Padded (and aligned) to whole cache lines, so no two shards share one
+            struct alignas(cache_line_size) shard
+            {
+                uninit<T> value;
+            };
+
+            void* m_allocation;
+            shard* m_shards;
+            std::size_t m_count;
+
+        public:
+            explicit sharded_out(std::size_t shard_count) :
+                m_allocation(nullptr),
+                m_shards(nullptr),
+                m_count(shard_count)
+            {
+                //Operator new only guarantees fundamental alignment before C++17; align by hand
+                m_allocation = ::operator new(m_count * sizeof(shard) + alignof(shard));
+                std::uintptr_t address = reinterpret_cast<std::uintptr_t>(m_allocation);
+                m_shards = reinterpret_cast<shard*>((address + alignof(shard) - 1) & ~static_cast<std::uintptr_t>(alignof(shard) - 1));
+
+                for (std::size_t i = 0; i < m_count; i++)
+                {
+                    new (m_shards + i) shard();
+                }
+            }
+
+            ~sharded_out()
+            {
+                for (std::size_t i = 0; i < m_count; i++)
+                {
+                    m_shards[i].~shard();
+                }
+                ::operator delete(m_allocation);
+            }
+
+            sharded_out(const sharded_out<T>&) = delete;
+            sharded_out& operator=(const sharded_out<T>&) = delete;
+
+            std::size_t shard_count() const { return m_count; }
+
+            /// <summary>
+            /// The shard for thread index. Only that thread may use it until the reduction
+            /// </summary>
+            uninit<T>& local(std::size_t index)
+            {
+                CPPSPT_ASSERT(index < m_count && "CPPSPT: shard index out of range!");
+
+                return m_shards[index].value;
+            }
+
+            /// <summary>
+            /// The shard for thread index, as an out parameter (whose first write constructs it)
+            /// </summary>
+            out<T> shard_out(std::size_t index)
+            {
+                return out<T>(local(index));
+            }
+
+            /// <summary>
+            /// Combines val into thread index's shard: the first value is stored as it is, later ones as combine(shard, val)
+            /// </summary>
+            template<typename Combine>
+            T& accumulate(std::size_t index, in<T> val, Combine combine)
+            {
+                uninit<T>& target = local(index);
+                if (!target.was_initialized())
+                {
+                    target = std::move(val);
+                }
+                else
+                {
+                    *target = combine(static_cast<const T&>(*target), static_cast<const T&>(val));
+                }
+                return *target;
+            }
+
+            /// <summary>
+            /// Folds the written shards with combine(a, b) -> T, in index order, and writes the result.
+            /// Every shard is empty afterwards. Returns false (leaving result unwritten) if no shard was written.
+            /// Must not run concurrently with writes to the shards
+            /// </summary>
+            template<typename Combine>
+            bool reduce(out<T> result, Combine combine)
+            {
+                std::size_t first = 0;
+                while (first < m_count && !m_shards[first].value.was_initialized())
+                {
+                    first++;
+                }
+                if (first == m_count)
+                {
+                    return false;
+                }
+
+                uninit<T>& head = m_shards[first].value;
+                T acc(std::move(*head));
+                head.reset();
+
+                for (std::size_t i = first + 1; i < m_count; i++)
+                {
+                    uninit<T>& value = m_shards[i].value;
+                    if (value.was_initialized())
+                    {
+                        acc = combine(static_cast<const T&>(acc), static_cast<const T&>(*value));
+                        value.reset();
+                    }
+                }
+
+                result = std::move(acc);
+                return true;
+            }
+        };
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_SHARDED_HPP
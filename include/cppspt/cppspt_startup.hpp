@@ -0,0 +1,539 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_STARTUP_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_STARTUP_HPP
+
+/*
+
+    Expensive globals, constructed in parallel at startup instead of one by one during static initialization
+
+    A startup_global<T> is an uninit<T> that registers itself (with a name, the names of the globals it depends on,
+    and a factory) when it's statically constructed, without constructing its value.
+    startup_registry::run() then constructs every registered value across several threads, each one only after its dependencies.
+
+    Any global can be used before run(), or before a worker reaches it: get() constructs it (after its dependencies) on the calling thread,
+    or waits if another thread is already constructing it. Globals that depend on each other in a cycle are never waited for:
+    run() returns false, and get() fails (try_get() returns nullptr), whichever threads are involved.
+    A factory that throws leaves its global unconstructed, so the next get() tries again.
+
+    The time each value took to construct is recorded, for profiling startup.
+
+*/
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<typename T>
+        class startup_global;
+    }
+
+    /// <summary>
+    /// A global uninit value, constructed by a startup_registry or on first use
+    /// </summary>
+    /// <typeparam name="T"></typeparam>
+    template<typename T>
+    using startup_global = detail::startup_global<T>;
+
+    /// <summary>
+    /// How long one global took to construct
+    /// </summary>
+    struct startup_timing
+    {
+        const char* name;
+        std::uint64_t nanoseconds;
+
+        //Constructed by get() on first use, rather than by a run() worker
+        bool forced;
+    };
+
+    class startup_registry;
+
+    namespace detail
+    {
+        //The type erased part of a startup_global, which the registry tracks
+        struct startup_entry
+        {
+            enum state_type : int
+            {
+                pending,
+                constructing,
+                constructed
+            };
+
+            const char* name;
+            std::vector<const char*> dependencies;
+
+            void* owner;
+            void (*construct)(void* owner);
+            void (*destroy)(void* owner);
+
+            std::atomic<int> state;
+            std::thread::id constructor_thread;
+            std::uint64_t nanoseconds;
+            bool forced;
+
+            startup_entry(const char* name_, std::initializer_list<const char*> dependencies_) :
+                name(name_),
+                dependencies(dependencies_),
+                owner(nullptr),
+                construct(nullptr),
+                destroy(nullptr),
+                state(pending),
+                nanoseconds(0),
+                forced(false)
+            {
+            }
+        };
+    }
+
+    /// <summary>
+    /// The globals to construct at startup. Most programs use global(), which startup_globals register with by default
+    /// </summary>
+    class startup_registry
+    {
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_constructed;
+
+        std::vector<detail::startup_entry*> m_entries;
+
+        //In the order they finished constructing, so they can be destroyed in reverse
+        std::vector<detail::startup_entry*> m_construction_order;
+
+        detail::startup_entry* find_locked(const char* name) const
+        {
+            for (detail::startup_entry* e : m_entries)
+            {
+                if (std::strcmp(e->name, name) == 0)
+                {
+                    return e;
+                }
+            }
+            return nullptr;
+        }
+
+        //Threads waiting for an entry another thread is constructing (at most one each)
+        struct startup_wait
+        {
+            std::thread::id thread;
+            const detail::startup_entry* entry;
+        };
+        std::vector<startup_wait> m_waits;
+
+        //Whether waiting for e would never end: following who constructs e, what that thread waits for, and so on, leads back here.
+        //(Each thread only waits after checking this, so a cycle of waits is caught by the thread that would close it)
+        bool would_deadlock_locked(const detail::startup_entry& e, std::thread::id self) const
+        {
+            const detail::startup_entry* next = &e;
+            for (std::size_t steps = 0; steps <= m_waits.size(); steps++)
+            {
+                if (next->constructor_thread == self)
+                {
+                    return true;
+                }
+
+                auto wait = std::find_if(m_waits.begin(), m_waits.end(), [next](const startup_wait& w) { return w.thread == next->constructor_thread; });
+                if (wait == m_waits.end())
+                {
+                    return false;
+                }
+                next = wait->entry;
+            }
+            return false;
+        }
+
+        //Puts e back to pending after its construction failed, and wakes the threads waiting for it (which try it themselves)
+        void abandon(detail::startup_entry& e)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            e.constructor_thread = std::thread::id();
+            e.state.store(detail::startup_entry::pending, std::memory_order_release);
+            m_constructed.notify_all();
+        }
+
+        //Constructs e on this thread after its dependencies, or waits for the thread that is already constructing it.
+        //Returns false, leaving e pending, if e depends on itself: directly on this thread, or through threads waiting on each other.
+        //If a factory throws, e (and every global constructing after it on this thread) is left pending, and the exception propagates
+        bool construct(detail::startup_entry& e, bool forced)
+        {
+            const std::thread::id self = std::this_thread::get_id();
+
+            std::vector<detail::startup_entry*> dependencies;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                for (;;)
+                {
+                    int state = e.state.load(std::memory_order_acquire);
+                    if (state == detail::startup_entry::constructed)
+                    {
+                        return true;
+                    }
+                    if (state == detail::startup_entry::pending)
+                    {
+                        break;
+                    }
+
+                    if (would_deadlock_locked(e, self))
+                    {
+                        return false;
+                    }
+
+                    m_waits.push_back(startup_wait{ self, &e });
+                    m_constructed.wait(lock, [&e] { return e.state.load(std::memory_order_acquire) != detail::startup_entry::constructing; });
+                    m_waits.erase(std::find_if(m_waits.begin(), m_waits.end(), [self](const startup_wait& w) { return w.thread == self; }));
+                }
+
+                e.state.store(detail::startup_entry::constructing, std::memory_order_relaxed);
+                e.constructor_thread = self;
+                for (const char* name : e.dependencies)
+                {
+                    detail::startup_entry* dependency = find_locked(name);
+                    CPPSPT_ASSERT(dependency != nullptr && "CPPSPT: startup_global depends on an unregistered name!");
+                    if (dependency != nullptr)
+                    {
+                        dependencies.push_back(dependency);
+                    }
+                }
+            }
+
+            std::chrono::steady_clock::time_point start, end;
+            try
+            {
+                for (detail::startup_entry* dependency : dependencies)
+                {
+                    if (dependency->state.load(std::memory_order_acquire) != detail::startup_entry::constructed && !construct(*dependency, forced))
+                    {
+                        abandon(e);
+                        return false;
+                    }
+                }
+
+                start = std::chrono::steady_clock::now();
+                e.construct(e.owner);
+                end = std::chrono::steady_clock::now();
+            }
+            catch (...)
+            {
+                abandon(e);
+                throw;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            e.nanoseconds = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            e.forced = forced;
+            e.state.store(detail::startup_entry::constructed, std::memory_order_release);
+            m_construction_order.push_back(&e);
+            m_constructed.notify_all();
+            return true;
+        }
+
+    public:
+        startup_registry() {}
+
+        startup_registry(const startup_registry&) = delete;
+        startup_registry& operator=(const startup_registry&) = delete;
+
+        /// <summary>
+        /// The registry for the whole program. Created on first use, so it exists before any global registers with it
+        /// </summary>
+        static startup_registry& global()
+        {
+            static startup_registry registry;
+            return registry;
+        }
+
+        void add(detail::startup_entry& e)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            CPPSPT_ASSERT(find_locked(e.name) == nullptr && "CPPSPT: two startup_globals have the same name!");
+            m_entries.push_back(&e);
+        }
+
+        void remove(detail::startup_entry& e)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.erase(std::remove(m_entries.begin(), m_entries.end(), &e), m_entries.end());
+            m_construction_order.erase(std::remove(m_construction_order.begin(), m_construction_order.end(), &e), m_construction_order.end());
+        }
+
+        /// <summary>
+        /// Constructs e (after its dependencies) if it isn't yet. Called by startup_global on first use.
+        /// Returns false if e is in a dependency cycle; a throwing factory's exception propagates (see construct)
+        /// </summary>
+        bool force(detail::startup_entry& e)
+        {
+            return construct(e, true);
+        }
+
+        /// <summary>
+        /// Constructs every registered global, in dependency order, across options.thread_count() threads.
+        /// Returns false (constructing what it could) if a dependency is missing, there's a cycle, or a factory throws.
+        /// A global whose factory threw is left unconstructed, as are the globals depending on it; get() tries it again
+        /// </summary>
+        bool run(const parallel_options& options = parallel_options())
+        {
+            std::vector<detail::startup_entry*> entries;
+            std::vector<std::size_t> waiting_on;
+            std::vector<std::vector<std::size_t>> dependents;
+            bool resolved = true;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                entries = m_entries;
+                waiting_on.assign(entries.size(), 0);
+                dependents.resize(entries.size());
+
+                for (std::size_t i = 0; i < entries.size(); i++)
+                {
+                    for (const char* name : entries[i]->dependencies)
+                    {
+                        detail::startup_entry* dependency = find_locked(name);
+                        if (dependency == nullptr)
+                        {
+                            resolved = false;
+                            continue;
+                        }
+
+                        std::size_t index = static_cast<std::size_t>(std::find(entries.begin(), entries.end(), dependency) - entries.begin());
+                        dependents[index].push_back(i);
+                        waiting_on[i]++;
+                    }
+                }
+            }
+            CPPSPT_ASSERT(resolved && "CPPSPT: startup_global depends on an unregistered name!");
+
+            //The work queue: entries whose dependencies have all been constructed
+            std::mutex queue_mutex;
+            std::condition_variable queue_changed;
+            std::vector<std::size_t> ready;
+            std::size_t remaining = entries.size();
+            std::size_t busy = 0;
+            std::size_t failed = 0;
+
+            for (std::size_t i = 0; i < entries.size(); i++)
+            {
+                if (waiting_on[i] == 0)
+                {
+                    ready.push_back(i);
+                }
+            }
+
+            parallel_options workers = options;
+            workers.threads = static_cast<unsigned>(std::min<std::size_t>(options.thread_count(), std::max<std::size_t>(entries.size(), 1)));
+
+            run_parallel(workers, [&](unsigned)
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                for (;;)
+                {
+                    //Nothing ready and nothing being constructed means the rest are in a cycle
+                    queue_changed.wait(lock, [&] { return !ready.empty() || remaining == 0 || busy == 0; });
+                    if (ready.empty())
+                    {
+                        queue_changed.notify_all();
+                        return;
+                    }
+
+                    std::size_t index = ready.back();
+                    ready.pop_back();
+                    busy++;
+
+                    lock.unlock();
+                    bool constructed;
+                    try
+                    {
+                        constructed = construct(*entries[index], false);
+                    }
+                    catch (...)
+                    {
+                        //Thrown out of a worker thread, the exception would terminate the program
+                        constructed = false;
+                    }
+                    lock.lock();
+
+                    busy--;
+                    if (!constructed)
+                    {
+                        //Its dependents never become ready
+                        failed++;
+                        queue_changed.notify_all();
+                        continue;
+                    }
+
+                    remaining--;
+                    for (std::size_t dependent : dependents[index])
+                    {
+                        if (--waiting_on[dependent] == 0)
+                        {
+                            ready.push_back(dependent);
+                        }
+                    }
+                    queue_changed.notify_all();
+                }
+            });
+
+            CPPSPT_ASSERT((remaining == 0 || failed != 0) && "CPPSPT: startup_globals depend on each other in a cycle!");
+            return resolved && remaining == 0;
+        }
+
+        /// <summary>
+        /// Destroys every constructed global, dependents before their dependencies. They are constructed again on next use
+        /// </summary>
+        void destroy_all()
+        {
+            std::vector<detail::startup_entry*> order;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                order.swap(m_construction_order);
+            }
+
+            for (auto it = order.rbegin(); it != order.rend(); ++it)
+            {
+                (*it)->destroy((*it)->owner);
+                (*it)->nanoseconds = 0;
+                (*it)->forced = false;
+                (*it)->state.store(detail::startup_entry::pending, std::memory_order_release);
+            }
+        }
+
+        /// <summary>
+        /// The construction time of every constructed global, slowest first
+        /// </summary>
+        std::vector<startup_timing> timings()
+        {
+            std::vector<startup_timing> result;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (detail::startup_entry* e : m_construction_order)
+                {
+                    startup_timing timing;
+                    timing.name = e->name;
+                    timing.nanoseconds = e->nanoseconds;
+                    timing.forced = e->forced;
+                    result.push_back(timing);
+                }
+            }
+
+            std::stable_sort(result.begin(), result.end(), [](const startup_timing& a, const startup_timing& b) { return a.nanoseconds > b.nanoseconds; });
+            return result;
+        }
+    };
+
+    namespace detail
+    {
+        template<typename T>
+        class startup_global final
+        {
+        public:
+            //Captureless, so a global's factory needs no construction of its own
+            using factory_type = void (*)(out<T> dest);
+
+        private:
+            startup_entry m_entry;
+            startup_registry& m_registry;
+            factory_type m_factory;
+            uninit<T> m_value;
+
+            static void construct_value(void* owner)
+            {
+                startup_global& self = *static_cast<startup_global*>(owner);
+                if (self.m_factory != nullptr)
+                {
+                    self.m_factory(self.m_value);
+                }
+                else
+                {
+                    self.m_value.init();
+                }
+            }
+
+            static void destroy_value(void* owner)
+            {
+                static_cast<startup_global*>(owner)->m_value.reset();
+            }
+
+        public:
+            /// <summary>
+            /// Registers a global named name, built by factory (or default constructed) after the globals in dependencies
+            /// </summary>
+            startup_global(startup_registry& registry, const char* name, std::initializer_list<const char*> dependencies = {}, factory_type factory = nullptr) :
+                m_entry(name, dependencies),
+                m_registry(registry),
+                m_factory(factory)
+            {
+                m_entry.owner = this;
+                m_entry.construct = &construct_value;
+                m_entry.destroy = &destroy_value;
+                m_registry.add(m_entry);
+            }
+
+            startup_global(const char* name, std::initializer_list<const char*> dependencies = {}, factory_type factory = nullptr) :
+                startup_global(startup_registry::global(), name, dependencies, factory)
+            {
+            }
+
+            ~startup_global()
+            {
+                m_registry.remove(m_entry);
+            }
+
+            startup_global(const startup_global&) = delete;
+            startup_global& operator=(const startup_global&) = delete;
+
+            bool was_initialized() const
+            {
+                return m_entry.state.load(std::memory_order_acquire) == startup_entry::constructed;
+            }
+
+            /// <summary>
+            /// The value, constructing it first (on this thread, or by waiting for another) if it hasn't been.
+            /// Aborts, in every build, if the global is in a dependency cycle (use try_get to handle that).
+            /// If its factory throws, the exception propagates and the global is left unconstructed
+            /// </summary>
+            T& get()
+            {
+                if (CPPSPT_UNLIKELY(!was_initialized()) && !m_registry.force(m_entry))
+                {
+                    detail::assert_failure("startup_global is in a dependency cycle", __FILE__, __LINE__);
+                }
+                return *m_value;
+            }
+
+            /// <summary>
+            /// The value, constructing it first if it hasn't been, or nullptr if it's in a dependency cycle
+            /// </summary>
+            T* try_get()
+            {
+                if (CPPSPT_UNLIKELY(!was_initialized()) && !m_registry.force(m_entry))
+                {
+                    return nullptr;
+                }
+                return &*m_value;
+            }
+
+            T& operator*() { return get(); }
+            T* operator->() { return &get(); }
+        };
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_STARTUP_HPP
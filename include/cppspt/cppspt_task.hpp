@@ -0,0 +1,483 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPSPT_INCLUDE_CPPSPT_TASK_HPP)
+#define CPPSPT_INCLUDE_CPPSPT_TASK_HPP
+
+/*
+
+    Tasks with inline storage, whose arguments are captured as in parameters, and a thread pool that runs them
+
+    A std::function<void()> holding a lambda that captured its arguments pays twice: each argument is copied into the lambda
+    (even when the caller passed an rvalue, unless every capture is written as an init-capture with std::move),
+    and the lambda is copied to the heap unless it fits a small buffer (16 bytes in libstdc++).
+
+    make_task(f, args...) captures each argument as an in<T>: it is moved into the task if the caller passed an rvalue
+    (or an in that was moved), and copied otherwise, once, straight into the task's storage. The function & arguments
+    live in a fixed buffer inside the task; only a closure too large (or too aligned) for it goes to the heap.
+    Running a task calls f with its arguments as rvalues, so a task runs once.
+
+    thread_pool runs tasks on a fixed set of threads, through a bounded mpmc_queue of tasks.
+    Idle workers spin briefly, then sleep until a task is submitted.
+    An exception thrown by a task doesn't stop its worker: the first one is kept, and rethrown by the next wait().
+
+*/
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_queue.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cppspt
+{
+    namespace detail
+    {
+        template<std::size_t Capacity>
+        class inline_task;
+
+        class thread_pool;
+
+        //Sized so that a task (the buffer and its operations pointer) is one 64 byte cache line
+        static const std::size_t default_task_capacity = 64 - sizeof(void*);
+    }
+
+    /// <summary>
+    /// A move-only, run-once void() task, which stores its function & arguments inline when they fit in Capacity bytes
+    /// </summary>
+    template<std::size_t Capacity>
+    using inline_task = detail::inline_task<Capacity>;
+
+    /// <summary>
+    /// An inline_task the size of a cache line
+    /// </summary>
+    using task = detail::inline_task<detail::default_task_capacity>;
+
+    /// <summary>
+    /// A fixed set of threads, running the tasks submitted to them
+    /// </summary>
+    using thread_pool = detail::thread_pool;
+
+    namespace detail
+    {
+        //An argument as it is stored in a task: by value, and an in<T> stores its T
+        template<typename T>
+        struct task_arg
+        {
+            using type = typename std::decay<T>::type;
+        };
+
+        template<typename T>
+        struct task_arg<in<T>>
+        {
+            using type = T;
+        };
+
+        template<typename T>
+        using task_arg_t = typename task_arg<typename std::decay<T>::type>::type;
+
+        //An in parameter passed on by name is consumed: moved on if its caller moved, like resolve()
+        template<typename T>
+        in<T> as_task_in(in<T>& param) { return in<T>(std::move(param)); }
+
+        template<typename T>
+        in<T> as_task_in(in<T>&& param) { return in<T>(std::move(param)); }
+
+        template<typename T>
+        in<T> as_task_in(const in<T>& param) { return in<T>(param); }
+
+        template<typename T>
+        in<task_arg_t<T>> as_task_in(T&& val) { return in<task_arg_t<T>>(std::forward<T>(val)); }
+
+        //A function and its arguments, each constructed once from an in
+        template<typename F, typename ... Args>
+        class bound_call final
+        {
+        private:
+            F m_func;
+            std::tuple<uninit<Args>...> m_args;
+
+            template<std::size_t ... Is>
+            void call(std::index_sequence<Is...>)
+            {
+                m_func(std::move(*std::get<Is>(m_args))...);
+            }
+
+        public:
+            template<typename G>
+            bound_call(G&& func, in<Args> ... args) :
+                m_func(std::forward<G>(func)),
+                m_args(std::move(args)...)
+            {
+            }
+
+            void operator()()
+            {
+                call(std::index_sequence_for<Args...>());
+            }
+        };
+
+        struct task_ops
+        {
+            void (*run)(void* storage);
+            void (*relocate)(void* from, void* to);
+            void (*destroy)(void* storage);
+            bool is_inline;
+        };
+
+        template<typename Closure>
+        struct inline_task_ops
+        {
+            static void run(void* storage) { (*static_cast<Closure*>(storage))(); }
+
+            static void relocate(void* from, void* to)
+            {
+                Closure* source = static_cast<Closure*>(from);
+                new (to) Closure(std::move(*source));
+                source->~Closure();
+            }
+
+            static void destroy(void* storage) { static_cast<Closure*>(storage)->~Closure(); }
+
+            static const task_ops* get()
+            {
+                static const task_ops ops = { &run, &relocate, &destroy, true };
+                return &ops;
+            }
+        };
+
+        //The buffer holds a pointer to the closure
+        template<typename Closure>
+        struct heap_task_ops
+        {
+            static Closure*& ptr(void* storage) { return *static_cast<Closure**>(storage); }
+
+            static void run(void* storage) { (*ptr(storage))(); }
+
+            static void relocate(void* from, void* to)
+            {
+                new (to) Closure*(ptr(from));
+            }
+
+            static void destroy(void* storage) { delete ptr(storage); }
+
+            static const task_ops* get()
+            {
+                static const task_ops ops = { &run, &relocate, &destroy, false };
+                return &ops;
+            }
+        };
+
+        template<std::size_t Capacity>
+        class inline_task final
+        {
+        private:
+            static_assert(Capacity >= sizeof(void*), "CPPSPT: an inline_task must at least hold a pointer!");
+
+            alignas(std::max_align_t) unsigned char m_storage[Capacity];
+            const task_ops* m_ops;
+
+            template<typename Closure>
+            using fits_inline = std::integral_constant<bool, sizeof(Closure) <= Capacity && alignof(Closure) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible<Closure>::value>;
+
+            template<typename Closure, typename ... Ts>
+            void emplace(std::true_type, Ts&& ... args)
+            {
+                new (m_storage) Closure(std::forward<Ts>(args)...);
+                m_ops = inline_task_ops<Closure>::get();
+            }
+
+            template<typename Closure, typename ... Ts>
+            void emplace(std::false_type, Ts&& ... args)
+            {
+                new (m_storage) Closure*(new Closure(std::forward<Ts>(args)...));
+                m_ops = heap_task_ops<Closure>::get();
+            }
+
+            void clear()
+            {
+                if (m_ops != nullptr)
+                {
+                    m_ops->destroy(m_storage);
+                    m_ops = nullptr;
+                }
+            }
+
+        public:
+            inline_task() : m_ops(nullptr) {}
+
+            /// <summary>
+            /// A task calling func(args...), with each argument captured as an in: moved if it is an rvalue, and copied otherwise
+            /// </summary>
+            template<typename F, typename ... Args>
+            inline_task(F&& func, in<Args> ... args) : m_ops(nullptr)
+            {
+                using closure = bound_call<typename std::decay<F>::type, Args...>;
+                emplace<closure>(fits_inline<closure>(), std::forward<F>(func), std::move(args)...);
+            }
+
+            inline_task(inline_task&& other) noexcept : m_ops(other.m_ops)
+            {
+                if (m_ops != nullptr)
+                {
+                    m_ops->relocate(other.m_storage, m_storage);
+                    other.m_ops = nullptr;
+                }
+            }
+
+            inline_task& operator=(inline_task&& other) noexcept
+            {
+                if (&other != this)
+                {
+                    clear();
+                    m_ops = other.m_ops;
+                    if (m_ops != nullptr)
+                    {
+                        m_ops->relocate(other.m_storage, m_storage);
+                        other.m_ops = nullptr;
+                    }
+                }
+                return *this;
+            }
+
+            inline_task(const inline_task&) = delete;
+            inline_task& operator=(const inline_task&) = delete;
+
+            ~inline_task()
+            {
+                clear();
+            }
+
+            explicit operator bool() const { return m_ops != nullptr; }
+
+            //Whether the function & arguments are stored inside the task (false if they were too large, and went to the heap)
+            bool is_inline() const { return m_ops == nullptr || m_ops->is_inline; }
+
+            /// <summary>
+            /// Runs the task, which is left empty
+            /// </summary>
+            void operator()()
+            {
+                CPPSPT_ASSERT(m_ops != nullptr && "CPPSPT: running an empty task!");
+
+                m_ops->run(m_storage);
+                clear();
+            }
+        };
+    }
+
+    /// <summary>
+    /// A task calling func(args...). Each argument is captured as an in<T>: moved into the task if the caller passed an rvalue
+    /// (or an in parameter which was moved), and copied otherwise
+    /// </summary>
+    template<typename Task = task, typename F, typename ... Args>
+    Task make_task(F&& func, Args&& ... args)
+    {
+        return Task(std::forward<F>(func), detail::as_task_in(std::forward<Args>(args))...);
+    }
+
+    namespace detail
+    {
+        class thread_pool final
+        {
+        private:
+            mpmc_queue<task> m_tasks;
+            std::vector<std::thread> m_workers;
+
+            std::atomic<bool> m_stopping;
+            std::atomic<std::size_t> m_queued;      //Submitted but not yet taken by a worker
+            std::atomic<std::size_t> m_pending;     //Submitted but not finished
+
+            //Idle workers sleep here; submitters only take the lock when a worker is asleep
+            std::mutex m_lock;
+            std::condition_variable m_wake;
+            std::atomic<unsigned> m_sleepers;
+
+            //wait() sleeps here until m_pending reaches 0. Both guarded by m_lock
+            std::condition_variable m_done;
+            std::exception_ptr m_error;
+
+            static const int spins_before_sleep = 64;
+
+            void wake_one()
+            {
+                if (m_sleepers.load() != 0)
+                {
+                    std::lock_guard<std::mutex> guard(m_lock);
+                    m_wake.notify_one();
+                }
+            }
+
+            void run(uninit<task>& next)
+            {
+                std::exception_ptr error;
+                try
+                {
+                    (*next)();
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                next.reset();
+
+                if (error)
+                {
+                    std::lock_guard<std::mutex> guard(m_lock);
+                    if (!m_error)
+                    {
+                        m_error = error;
+                    }
+                }
+
+                //The last task to finish wakes wait(), which checks m_pending under the lock
+                if (m_pending.fetch_sub(1, std::memory_order_release) == 1)
+                {
+                    std::lock_guard<std::mutex> guard(m_lock);
+                    m_done.notify_all();
+                }
+            }
+
+            void work()
+            {
+                uninit<task> next;
+                int idle = 0;
+                for (;;)
+                {
+                    if (m_tasks.try_pop(next))
+                    {
+                        m_queued.fetch_sub(1, std::memory_order_relaxed);
+                        idle = 0;
+                        run(next);
+                        continue;
+                    }
+
+                    if (m_stopping.load(std::memory_order_acquire))
+                    {
+                        return;
+                    }
+
+                    if (++idle < spins_before_sleep)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    //Sleeps unless a task is queued (or the pool stopped). A submitter counts its task before it reads m_sleepers,
+                    //and a sleeper counts itself before it reads m_queued, so one of them sees the other
+                    std::unique_lock<std::mutex> guard(m_lock);
+                    m_sleepers.fetch_add(1);
+                    m_wake.wait(guard, [this] { return m_queued.load() != 0 || m_stopping.load(); });
+                    m_sleepers.fetch_sub(1);
+                    idle = 0;
+                }
+            }
+
+        public:
+            /// <summary>
+            /// Starts threads workers (0 uses every hardware thread), sharing a queue of at least queue_capacity tasks
+            /// </summary>
+            explicit thread_pool(unsigned threads = 0, std::size_t queue_capacity = 1024) :
+                m_tasks(queue_capacity),
+                m_stopping(false),
+                m_queued(0),
+                m_pending(0),
+                m_sleepers(0)
+            {
+                if (threads == 0)
+                {
+                    threads = std::thread::hardware_concurrency();
+                    threads = (threads != 0) ? threads : 1;
+                }
+
+                m_workers.reserve(threads);
+                for (unsigned i = 0; i < threads; i++)
+                {
+                    m_workers.emplace_back([this] { work(); });
+                }
+            }
+
+            thread_pool(const thread_pool&) = delete;
+            thread_pool& operator=(const thread_pool&) = delete;
+
+            //Runs every task already submitted, then stops the workers. An exception not yet rethrown by wait() is dropped
+            ~thread_pool()
+            {
+                m_stopping.store(true, std::memory_order_release);
+                {
+                    std::lock_guard<std::mutex> guard(m_lock);
+                    m_wake.notify_all();
+                }
+                for (std::thread& worker : m_workers)
+                {
+                    worker.join();
+                }
+            }
+
+            std::size_t thread_count() const { return m_workers.size(); }
+
+            /// <summary>
+            /// Submits a task, unless the queue is full
+            /// </summary>
+            bool try_submit(in<task> work)
+            {
+                //Counted first, so a worker that takes the task can't count it down before it is counted
+                m_pending.fetch_add(1, std::memory_order_relaxed);
+                m_queued.fetch_add(1);
+                if (!m_tasks.try_push(std::move(work)))
+                {
+                    m_queued.fetch_sub(1, std::memory_order_relaxed);
+                    m_pending.fetch_sub(1, std::memory_order_relaxed);
+                    return false;
+                }
+                wake_one();
+                return true;
+            }
+
+            /// <summary>
+            /// Submits a task calling func(args...), with the arguments captured as by make_task. Waits for space if the queue is full
+            /// </summary>
+            template<typename F, typename ... Args>
+            void submit(F&& func, Args&& ... args)
+            {
+                task work = make_task(std::forward<F>(func), std::forward<Args>(args)...);
+                while (!try_submit(std::move(work)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            /// <summary>
+            /// Waits until every submitted task has finished. If any of them threw, rethrows the first exception (once)
+            /// </summary>
+            void wait()
+            {
+                std::unique_lock<std::mutex> guard(m_lock);
+                m_done.wait(guard, [this] { return m_pending.load(std::memory_order_acquire) == 0; });
+
+                if (m_error)
+                {
+                    std::exception_ptr error = m_error;
+                    m_error = nullptr;
+                    guard.unlock();
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+    }
+}
+
+#endif //CPPSPT_INCLUDE_CPPSPT_TASK_HPP
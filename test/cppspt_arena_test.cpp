@@ -0,0 +1,254 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_arena.hpp"
+
+#include "cppspt_test.hpp"
+#include "cppspt_tracking.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using arena_string = std::basic_string<char, std::char_traits<char>, cppspt::arena_allocator<char>>;
+
+static bool in_arena_buffer(const void* ptr, const char* buffer, std::size_t size)
+{
+    const char* address = static_cast<const char*>(ptr);
+    return address >= buffer && address < buffer + size;
+}
+
+arena_string keep_in_arena(cppspt::in<arena_string> str, cppspt::arena& request)
+{
+    return cppspt::resolve(str, cppspt::arena_allocator<char>(request));
+}
+
+//This test case checks alignment, reuse after reset, and growing past the initial buffer
+TEST_CASE("Testing Arena", "[CPPSPT::Arena]")
+{
+    alignas(std::max_align_t) char buffer[256];
+    cppspt::arena request(buffer, sizeof(buffer));
+
+    void* a = request.allocate(3, 1);
+    void* b = request.allocate(8, 8);
+    REQUIRE(in_arena_buffer(a, buffer, sizeof(buffer)));
+    REQUIRE(in_arena_buffer(b, buffer, sizeof(buffer)));
+    REQUIRE(reinterpret_cast<std::uintptr_t>(b) % 8 == 0);
+    REQUIRE(request.bytes_allocated() == 11);
+
+    //Past the buffer, allocations come from a chunk
+    void* big = request.allocate(1000);
+    REQUIRE(!in_arena_buffer(big, buffer, sizeof(buffer)));
+
+    //After a reset, the buffer & then the same chunk are reused, without touching the heap
+    request.reset();
+    REQUIRE(request.bytes_allocated() == 0);
+    cppspt_tracking::expect_at_most expectation(0, -1);
+    REQUIRE(request.allocate(3, 1) == a);
+    REQUIRE(request.allocate(1000) == big);
+    REQUIRE(expectation.satisfied());
+}
+
+//This test case checks that copies from lvalue ins land in the arena, and moves only move between equal allocators
+TEST_CASE("Testing Resolve with an Allocator", "[CPPSPT::Arena]")
+{
+    alignas(std::max_align_t) char buffer[1024];
+    cppspt::arena request(buffer, sizeof(buffer));
+    cppspt::arena other;
+
+    arena_string source(100, 'a', cppspt::arena_allocator<char>(other));
+
+    {
+        cppspt_tracking::expect_at_most expectation(0, -1);
+        arena_string copy = keep_in_arena(source, request);
+        REQUIRE(copy == source);
+        REQUIRE(in_arena_buffer(copy.data(), buffer, sizeof(buffer)));
+        REQUIRE(copy.get_allocator() == cppspt::arena_allocator<char>(request));
+        REQUIRE(expectation.satisfied());
+    }
+
+    //Moved from another arena: the contents are copied into this one
+    arena_string moved = keep_in_arena(std::move(source), request);
+    REQUIRE(moved == arena_string(100, 'a', cppspt::arena_allocator<char>(request)));
+    REQUIRE(in_arena_buffer(moved.data(), buffer, sizeof(buffer)));
+
+    //Moved from this arena: the buffer is taken
+    const char* data = moved.data();
+    arena_string taken = keep_in_arena(std::move(moved), request);
+    REQUIRE(taken.data() == data);
+
+    //Types which don't use the allocator are constructed as usual
+    std::string plain(100, 'p');
+    cppspt::in<std::string> plain_in(plain);
+    std::string plain_copy = cppspt::resolve(plain_in, cppspt::arena_allocator<char>(request));
+    REQUIRE(plain_copy == plain);
+    REQUIRE(!in_arena_buffer(plain_copy.data(), buffer, sizeof(buffer)));
+}
+
+//This test case checks constructing & assigning uninits with an allocator
+TEST_CASE("Testing Uninit with an Allocator", "[CPPSPT::Arena]")
+{
+    alignas(std::max_align_t) char buffer[1024];
+    cppspt::arena request(buffer, sizeof(buffer));
+    cppspt::arena_allocator<char> alloc(request);
+
+    cppspt::uninit<arena_string> str;
+    cppspt::init_with_allocator(str, alloc, std::size_t(50), 'x');
+    REQUIRE(*str == arena_string(50, 'x', alloc));
+    REQUIRE(in_arena_buffer(str->data(), buffer, sizeof(buffer)));
+
+    //Already initialized: init does nothing
+    cppspt::init_with_allocator(str, alloc, std::size_t(5), 'y');
+    REQUIRE(str->size() == 50);
+
+    cppspt::uninit<arena_string> assigned;
+    arena_string value(60, 'z', alloc);
+    cppspt::assign_with_allocator(assigned, value, alloc);
+    REQUIRE(*assigned == value);
+    REQUIRE(in_arena_buffer(assigned->data(), buffer, sizeof(buffer)));
+
+    cppspt::assign_with_allocator(assigned, arena_string(70, 'w', alloc), alloc);
+    REQUIRE(assigned->size() == 70);
+}
+
+//This test case checks that an arena vector keeps its storage & its values in the arena
+TEST_CASE("Testing Arena Vector", "[CPPSPT::Arena]")
+{
+    cppspt::arena request(1 << 16);
+    std::string long_value(100, 'v');
+
+    construction_count count = run_with_constructions([&]
+    {
+        cppspt::arena_vector<XString> counted(request);
+        for (int i = 0; i < 20; i++)
+        {
+            counted.push_back(XString(long_value));
+        }
+        counted.push_back_uninit();
+        REQUIRE(counted.size() == 21);
+        REQUIRE(!counted[20].was_initialized());
+    });
+    REQUIRE(count.constructions == count.destructions);
+
+    request.reset();
+    {
+        cppspt::arena_vector<arena_string> strings(request);
+        arena_string first(100, 'f', strings.get_allocator());
+
+        cppspt_tracking::expect_at_most expectation(0, -1);
+        strings.push_back(first);
+        strings.emplace_back(std::size_t(100), 'e');
+        for (int i = 0; i < 10; i++)
+        {
+            //Grows while copying one of its own elements
+            strings.push_back(*strings[0]);
+        }
+        REQUIRE(expectation.satisfied());
+
+        REQUIRE(strings.size() == 12);
+        REQUIRE(*strings[1] == arena_string(100, 'e', strings.get_allocator()));
+        for (int i = 2; i < 12; i++)
+        {
+            REQUIRE(*strings[i] == first);
+        }
+    }
+}
+
+namespace
+{
+    //Moves throw once moves_left runs out, and it can't be copied
+    struct fragile_move
+    {
+        static int moves_left;
+        static int live;
+
+        int value;
+
+        explicit fragile_move(int val) : value(val) { live++; }
+        fragile_move(const fragile_move&) = delete;
+        fragile_move(fragile_move&& other) : value(other.value)
+        {
+            if (moves_left-- == 0)
+            {
+                throw std::runtime_error("move");
+            }
+            live++;
+        }
+        ~fragile_move() { live--; }
+    };
+
+    int fragile_move::moves_left = 0;
+    int fragile_move::live = 0;
+}
+
+//This test case checks that a throw while an arena vector grows leaves the elements where they were, and destroys the new value
+TEST_CASE("Testing Throwing Growth of Arena Vector", "[CPPSPT::Arena]")
+{
+    cppspt::arena request(1 << 12);
+    {
+        cppspt::arena_vector<fragile_move> values(request);
+        for (int i = 0; i < 4; i++)
+        {
+            values.emplace_back(i);
+        }
+        REQUIRE(values.capacity() == 4);
+
+        fragile_move::moves_left = 2;
+        REQUIRE_THROWS_AS(values.emplace_back(4), std::runtime_error);
+        REQUIRE(values.size() == 4);
+        REQUIRE(values.capacity() == 4);
+        REQUIRE(fragile_move::live == 4);
+        for (int i = 0; i < 4; i++)
+        {
+            REQUIRE(values[i]->value == i);
+        }
+
+        fragile_move::moves_left = 1;
+        REQUIRE_THROWS_AS(values.reserve(8), std::runtime_error);
+        REQUIRE(values.capacity() == 4);
+        REQUIRE(fragile_move::live == 4);
+
+        fragile_move::moves_left = 100;
+        values.emplace_back(4);
+        REQUIRE(values.size() == 5);
+        REQUIRE(values[4]->value == 4);
+        REQUIRE(fragile_move::live == 5);
+
+        values.clear();
+        REQUIRE(fragile_move::live == 0);
+    }
+    REQUIRE(fragile_move::live == 0);
+}
+
+#if defined (CPPSPT_HAS_MEMORY_RESOURCE)
+
+//This test case checks the std::pmr overloads, and std::pmr containers over an arena
+TEST_CASE("Testing Resolve with a Memory Resource", "[CPPSPT::Arena]")
+{
+    alignas(std::max_align_t) char buffer[1024];
+    cppspt::arena request(buffer, sizeof(buffer));
+    cppspt::arena_resource resource(request);
+
+    std::pmr::string source(100, 'a');
+    cppspt::in<std::pmr::string> source_in(source);
+    std::pmr::string copy = cppspt::resolve(source_in, &resource);
+    REQUIRE(copy == source);
+    REQUIRE(copy.get_allocator().resource() == &resource);
+    REQUIRE(in_arena_buffer(copy.data(), buffer, sizeof(buffer)));
+
+    cppspt::uninit<std::pmr::string> str;
+    cppspt::assign_with_allocator(str, source, &resource);
+    REQUIRE(str->get_allocator().resource() == &resource);
+
+    cppspt::uninit<std::pmr::vector<std::pmr::string>> strings;
+    cppspt::init_with_allocator(strings, &resource);
+    strings->push_back(source);
+    REQUIRE(in_arena_buffer(strings->front().data(), buffer, sizeof(buffer)));
+}
+
+#endif
@@ -0,0 +1,211 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_binary.hpp"
+#include "cppspt_test.hpp"
+#include "cppspt_tracking.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct point
+{
+    float x;
+    float y;
+};
+
+struct tag
+{
+    std::string name;
+    std::vector<point> points;
+};
+
+//Runs of trivially copyable fields, around a string
+struct row
+{
+    std::int32_t a;
+    std::int16_t b;
+    double c;
+    std::string name;
+    char d;
+    std::uint64_t e;
+};
+
+struct message
+{
+    std::uint64_t id;
+    std::string text;
+    std::vector<int> values;
+    std::vector<tag> tags;
+    point origin;
+};
+
+namespace cppspt
+{
+    template<>
+    struct binary_fields<tag>
+    {
+        static auto fields() { return binary_members(&tag::name, &tag::points); }
+    };
+
+    template<>
+    struct binary_fields<row>
+    {
+        static auto fields() { return binary_members(&row::a, &row::b, &row::c, &row::name, &row::d, &row::e); }
+    };
+
+    template<>
+    struct binary_fields<message>
+    {
+        static auto fields() { return binary_members(&message::id, &message::text, &message::values, &message::tags, &message::origin); }
+    };
+}
+
+message make_message()
+{
+    message result;
+    result.id = 42;
+    result.text = "a message text that is too long for the small string buffer";
+    result.values = { 1, 2, 3, 4, 5 };
+    result.tags.push_back(tag{ "first", { point{ 1.0f, 2.0f }, point{ 3.0f, 4.0f } } });
+    result.tags.push_back(tag{ "second", {} });
+    result.origin = point{ 5.0f, 6.0f };
+    return result;
+}
+
+void require_equal(const message& a, const message& b)
+{
+    REQUIRE(a.id == b.id);
+    REQUIRE(a.text == b.text);
+    REQUIRE(a.values == b.values);
+    REQUIRE(a.tags.size() == b.tags.size());
+    for (std::size_t i = 0; i < a.tags.size(); i++)
+    {
+        REQUIRE(a.tags[i].name == b.tags[i].name);
+        REQUIRE(a.tags[i].points.size() == b.tags[i].points.size());
+        for (std::size_t j = 0; j < a.tags[i].points.size(); j++)
+        {
+            REQUIRE(a.tags[i].points[j].x == b.tags[i].points[j].x);
+            REQUIRE(a.tags[i].points[j].y == b.tags[i].points[j].y);
+        }
+    }
+    REQUIRE(a.origin.x == b.origin.x);
+    REQUIRE(a.origin.y == b.origin.y);
+}
+
+//This test case checks that described, raw, string & vector values round trip, into every kind of destination
+TEST_CASE("Testing Round Trip of Binary Reader", "[CPPSPT::Binary]")
+{
+    message original = make_message();
+
+    cppspt::binary_writer writer;
+    writer.write(original);
+    writer.write(original);
+    writer.write(original);
+    writer.write(17);
+
+    cppspt::binary_reader reader(writer.data(), writer.size());
+
+    //Into a T&
+    message direct;
+    REQUIRE(reader.read(direct));
+    require_equal(direct, original);
+
+    //Into an uninit, which is constructed
+    cppspt::uninit<message> deferred;
+    REQUIRE(reader.read(deferred));
+    REQUIRE(deferred.was_initialized());
+    require_equal(*deferred, original);
+
+    //By value
+    message returned = reader.read<message>();
+    require_equal(returned, original);
+
+    REQUIRE(reader.read<int>() == 17);
+    REQUIRE(reader.remaining() == 0);
+    REQUIRE(!reader.failed());
+}
+
+//This test case checks that a short buffer fails the reader, and that nothing is read past the end
+TEST_CASE("Testing Truncated Input to Binary Reader", "[CPPSPT::Binary]")
+{
+    cppspt::binary_writer writer;
+    writer.write(make_message());
+
+    for (std::size_t size = 0; size < writer.size(); size += 7)
+    {
+        cppspt::binary_reader reader(writer.data(), size);
+        cppspt::uninit<message> result;
+        REQUIRE(!reader.read(result));
+        REQUIRE(reader.failed());
+        REQUIRE(result.was_initialized());
+    }
+
+    //A length larger than the rest of the buffer fails without allocating
+    cppspt::binary_writer lengths;
+    lengths.write_length(1000000);
+    cppspt::binary_reader reader(lengths.data(), lengths.size());
+
+    cppspt_tracking::expect_at_most expectation(0, 0);
+    std::vector<int> values = reader.read<std::vector<int>>();
+    REQUIRE(expectation.satisfied());
+    REQUIRE(values.empty());
+    REQUIRE(reader.failed());
+}
+
+//This test case checks that strings & vectors are allocated once, at their final size, and never copied
+TEST_CASE("Testing Allocations of Binary Reader", "[CPPSPT::Binary]")
+{
+    tag original{ "a tag name that is too long for the small string buffer", { point{ 1.0f, 2.0f }, point{ 3.0f, 4.0f } } };
+
+    cppspt::binary_writer writer;
+    writer.write(original);
+
+    cppspt::binary_reader reader(writer.data(), writer.size());
+    cppspt::uninit<tag> result;
+
+    cppspt_tracking::tracking_scope scope;
+    REQUIRE(reader.read(result));
+    REQUIRE(scope.delta().allocations == 2);
+
+    REQUIRE(result->name == original.name);
+    REQUIRE(result->points.size() == 2);
+    REQUIRE(result->points[1].y == 4.0f);
+}
+
+//This test case checks that adjacent trivially copyable fields are read as one run, packed on the wire, and zeroed when it's cut short
+TEST_CASE("Testing Field Runs of Binary Reader", "[CPPSPT::Binary]")
+{
+    using runs = cppspt::detail::binary_field_runs<std::int32_t, std::int16_t, double, std::string, char, std::uint64_t>;
+    static_assert(runs::run_begin(2) == 0 && runs::offset_in_run(2) == 6 && runs::run_size(0) == 14, "the first three fields are one run");
+    static_assert(!runs::is_raw(3) && runs::run_begin(5) == 4 && runs::run_size(4) == 9, "the last two fields are another");
+
+    row original{ -7, 300, 2.5, "a row name", 'z', 0x0102030405060708ull };
+
+    cppspt::binary_writer writer;
+    writer.write(original);
+    REQUIRE(writer.size() == 14 + 4 + original.name.size() + 9);
+
+    cppspt::binary_reader reader(writer.data(), writer.size());
+    row result = reader.read<row>();
+    REQUIRE(!reader.failed());
+    REQUIRE(result.a == original.a);
+    REQUIRE(result.b == original.b);
+    REQUIRE(result.c == original.c);
+    REQUIRE(result.name == original.name);
+    REQUIRE(result.d == original.d);
+    REQUIRE(result.e == original.e);
+
+    //Cut inside the second run: the first is read, the second is zeroed as a whole
+    cppspt::binary_reader truncated(writer.data(), writer.size() - 1);
+    row partial = truncated.read<row>();
+    REQUIRE(truncated.failed());
+    REQUIRE(partial.c == original.c);
+    REQUIRE(partial.name == original.name);
+    REQUIRE(partial.d == 0);
+    REQUIRE(partial.e == 0);
+}
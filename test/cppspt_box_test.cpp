@@ -0,0 +1,170 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_box.hpp"
+#include "cppspt_test.hpp"
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct big_struct
+{
+    char bytes[256];
+    int id;
+};
+
+static_assert(cppspt::uninit_box<int>::is_inline, "An int should be stored inline");
+static_assert(!cppspt::uninit_box<big_struct>::is_inline, "A big struct should be boxed");
+static_assert(sizeof(cppspt::uninit_box<big_struct>) == sizeof(void*), "An empty box should cost one pointer");
+static_assert(cppspt::uninit_box<big_struct, sizeof(big_struct)>::is_inline, "InlineBytes should control inline storage");
+
+//So that a std::vector of boxes moves them when it grows
+static_assert(std::is_nothrow_move_constructible<cppspt::uninit_box<big_struct>>::value, "Moving a boxed value should be noexcept");
+static_assert(std::is_nothrow_move_assignable<cppspt::uninit_box<big_struct>>::value, "Moving a boxed value should be noexcept");
+static_assert(std::is_nothrow_move_constructible<cppspt::uninit_box<std::string, sizeof(std::string)>>::value, "Moving an inline value should be noexcept when T's move is");
+static_assert(std::is_nothrow_move_assignable<cppspt::uninit_box<std::string, sizeof(std::string)>>::value, "Moving an inline value should be noexcept when T's move is");
+
+void write_box(cppspt::out<NXString> str)
+{
+    str = NXString(XString("written"));
+}
+
+void write_big(cppspt::out<big_struct> val, int id)
+{
+    big_struct result;
+    result.id = id;
+    val = result;
+}
+
+//This test case checks that a box doesn't construct its value until initialized
+TEST_CASE("Testing Default Construction of Uninit Box", "[CPPSPT::UninitBox]")
+{
+    REQUIRE(run_with_history([] { cppspt::uninit_box<NXString> str; }) == "");
+    REQUIRE(run_with_history([] { cppspt::uninit_box<NXString, 0> str; }) == "");
+
+    cppspt::uninit_box<big_struct> big;
+    REQUIRE(!big.was_initialized());
+}
+
+//This test case checks that boxed values are moved and copied into the box like an uninit
+TEST_CASE("Testing Assignment of Uninit Box", "[CPPSPT::UninitBox]")
+{
+    auto assign_move = []
+    {
+        cppspt::uninit_box<NXString, 0> str;
+        str = NXString();
+    };
+
+    auto assign_copy = []
+    {
+        NXString val;
+        cppspt::uninit_box<NXString, 0> str;
+        str = val;
+    };
+
+    REQUIRE(run_with_history(assign_move) == "ctor move-ctor dtor dtor ");
+    REQUIRE(run_with_history(assign_copy) == "ctor copy-ctor dtor dtor ");
+
+    cppspt::uninit_box<big_struct> big;
+    big_struct val;
+    val.id = 5;
+    big = val;
+    REQUIRE(big.was_initialized());
+    REQUIRE(big->id == 5);
+
+    val.id = 6;
+    big = val;
+    REQUIRE(big->id == 6);
+
+    big.reset();
+    REQUIRE(!big.was_initialized());
+}
+
+//This test case checks that moving a boxed value only moves the pointer
+TEST_CASE("Testing Move of Uninit Box", "[CPPSPT::UninitBox]")
+{
+    auto move_box = []
+    {
+        cppspt::uninit_box<NXString, 0> str(NXString(XString("moved")));
+        cppspt::uninit_box<NXString, 0> other(std::move(str));
+        REQUIRE(!str.was_initialized());
+        REQUIRE(other->get().get() == "moved");
+    };
+
+    REQUIRE(run_with_history(move_box) == "ctor move-ctor dtor dtor ");
+
+    cppspt::uninit_box<NXString, 0> a(NXString(XString("a")));
+    cppspt::uninit_box<NXString, 0> b(a);
+    REQUIRE(a.was_initialized());
+    REQUIRE(b->get().get() == "a");
+
+    //Assigning an inline box to itself keeps its value
+    cppspt::uninit_box<std::string, sizeof(std::string)> inline_str(std::string(40, 's'));
+    cppspt::uninit_box<std::string, sizeof(std::string)>& same = inline_str;
+    inline_str = std::move(same);
+    REQUIRE(*inline_str == std::string(40, 's'));
+    inline_str = same;
+    REQUIRE(*inline_str == std::string(40, 's'));
+
+    //A growing vector moves its boxes rather than copying their values
+    std::vector<cppspt::uninit_box<XString, 0>> boxes;
+    boxes.emplace_back(XString("first"));
+    construction_count count = run_with_constructions([&]
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            boxes.emplace_back();
+        }
+    });
+    REQUIRE(count.copy_constructions == 0);
+    REQUIRE(boxes[0]->get() == "first");
+}
+
+//This test case checks that init constructs in place, once
+TEST_CASE("Testing Init of Uninit Box", "[CPPSPT::UninitBox]")
+{
+    cppspt::uninit_box<std::string, 0> str;
+    str.init(3, 'x');
+    REQUIRE(*str == "xxx");
+
+    str.init(4, 'y');
+    REQUIRE(*str == "xxx");
+
+    cppspt::uninit_box<std::string, sizeof(std::string)> inline_str;
+    inline_str.init(2, 'z');
+    REQUIRE(*inline_str == "zz");
+}
+
+//This test case checks that a box can be passed as an out parameter, both inline and boxed
+TEST_CASE("Testing Uninit Box as Out", "[CPPSPT::UninitBox]")
+{
+    cppspt::uninit_box<big_struct> big;
+    write_big(big, 7);
+    REQUIRE(big.was_initialized());
+    REQUIRE(big->id == 7);
+
+    write_big(big, 8);
+    REQUIRE(big->id == 8);
+
+    auto write_boxed = []
+    {
+        cppspt::uninit_box<NXString, 0> str;
+        write_box(str);
+        REQUIRE(str->get().get() == "written");
+    };
+
+    auto write_inline = []
+    {
+        cppspt::uninit_box<NXString, sizeof(NXString)> str;
+        write_box(str);
+        REQUIRE(str->get().get() == "written");
+    };
+
+    REQUIRE(run_with_history(write_boxed) == "ctor move-ctor dtor dtor ");
+    REQUIRE(run_with_history(write_inline) == "ctor move-ctor dtor dtor ");
+}
@@ -0,0 +1,272 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_cache.hpp"
+#include "cppspt_test.hpp"
+#include "cppspt_tracking.hpp"
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int s_cache_hash_calls = 0;
+
+struct counting_cache_hash
+{
+    std::size_t operator()(int key) const
+    {
+        s_cache_hash_calls++;
+        return std::hash<int>()(key);
+    }
+};
+
+//Every key lands in the same index position, so lookups & erases walk (and shift) one long probe run
+struct colliding_hash
+{
+    std::size_t operator()(int) const
+    {
+        return 0;
+    }
+};
+
+//Copying throws while s_fragile_copies_throw is set
+static bool s_fragile_copies_throw = false;
+
+struct fragile_cache_value
+{
+    int value;
+
+    fragile_cache_value(int val) : value(val) {}
+
+    fragile_cache_value(const fragile_cache_value& other) : value(other.value)
+    {
+        if (s_fragile_copies_throw)
+        {
+            throw std::runtime_error("copy");
+        }
+    }
+
+    fragile_cache_value& operator=(const fragile_cache_value& other)
+    {
+        if (s_fragile_copies_throw)
+        {
+            throw std::runtime_error("copy");
+        }
+        value = other.value;
+        return *this;
+    }
+};
+
+//This test case checks that hits are written into the caller's storage, and misses leave it alone
+TEST_CASE("Testing Get & Put of Clock Cache", "[CPPSPT::Cache]")
+{
+    cppspt::clock_cache<std::string, std::string> cache(4);
+    REQUIRE(cache.capacity() == 4);
+
+    std::string key = "key";
+    cache.put(key, std::string("value"));
+    cache.put(std::string("other"), key);
+    REQUIRE(cache.size() == 2);
+
+    std::string direct;
+    REQUIRE(cache.get(key, direct));
+    REQUIRE(direct == "value");
+
+    cppspt::uninit<std::string> deferred;
+    REQUIRE(!cache.get(std::string("missing"), deferred));
+    REQUIRE(!deferred.was_initialized());
+    REQUIRE(cache.get(std::string("other"), deferred));
+    REQUIRE(*deferred == "key");
+
+    //Replacing a value keeps the entry
+    cache.put(key, std::string("replaced"));
+    REQUIRE(cache.size() == 2);
+    REQUIRE(*cache.find(key) == "replaced");
+
+    REQUIRE(cache.erase(key));
+    REQUIRE(!cache.erase(key));
+    REQUIRE(cache.find(key) == nullptr);
+    REQUIRE(cache.size() == 1);
+}
+
+//This test case checks that moved keys & values are moved into the entries, and copied ones copied
+TEST_CASE("Testing Moves into Clock Cache", "[CPPSPT::Cache]")
+{
+    cppspt::clock_cache<int, NXString> cache(4);
+    NXString val(XString("a"));
+
+    REQUIRE(run_with_history([&] { cache.put(1, val); }) == "copy-ctor ");
+    REQUIRE(run_with_history([&] { cache.put(2, std::move(val)); }) == "move-ctor ");
+    REQUIRE(run_with_history([&] { cache.put(2, NXString(XString("b"))); }).find("copy") == std::string::npos);
+}
+
+//This test case checks the second chance: a referenced entry survives the next eviction
+TEST_CASE("Testing Clock Eviction of Clock Cache", "[CPPSPT::Cache]")
+{
+    cppspt::clock_cache<int, int> cache(3);
+    cache.put(1, 10);
+    cache.put(2, 20);
+    cache.put(3, 30);
+
+    int val;
+    REQUIRE(cache.get(1, val));
+    REQUIRE(cache.get(3, val));
+
+    //2 is the only unreferenced entry
+    cache.put(4, 40);
+    REQUIRE(cache.find(2) == nullptr);
+    REQUIRE(*cache.find(1) == 10);
+    REQUIRE(*cache.find(3) == 30);
+    REQUIRE(*cache.find(4) == 40);
+    REQUIRE(cache.size() == 3);
+
+    //Once every bit has been cleared, the clock takes the next entry after the hand
+    cache.put(5, 50);
+    cache.put(6, 60);
+    REQUIRE(cache.size() == 3);
+}
+
+//This test case checks that removing keys from the middle of a probe run leaves every other key reachable
+TEST_CASE("Testing Collisions in Clock Cache", "[CPPSPT::Cache]")
+{
+    cppspt::clock_cache<int, int, colliding_hash> cache(16);
+    for (int i = 0; i < 16; i++)
+    {
+        cache.put(i, i * 10);
+    }
+
+    for (int i = 0; i < 16; i += 3)
+    {
+        REQUIRE(cache.erase(i));
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        const int* val = cache.find(i);
+        REQUIRE((val != nullptr) == (i % 3 != 0));
+    }
+
+    //Erased entries are reused before any eviction
+    for (int i = 100; i < 106; i++)
+    {
+        cache.put(i, i);
+    }
+    REQUIRE(cache.size() == 16);
+    for (int i = 1; i < 16; i += 3)
+    {
+        REQUIRE(*cache.find(i) == i * 10);
+    }
+}
+
+//This test case checks that a put whose value throws leaves no half filled entry behind, and loses no entry
+TEST_CASE("Testing Throwing Put of Clock Cache", "[CPPSPT::Cache]")
+{
+    cppspt::clock_cache<std::string, fragile_cache_value> cache(2);
+    fragile_cache_value val(1);
+
+    //Into an unused entry
+    s_fragile_copies_throw = true;
+    REQUIRE_THROWS_AS(cache.put(std::string("a"), val), std::runtime_error);
+    s_fragile_copies_throw = false;
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.find(std::string("a")) == nullptr);
+
+    cache.put(std::string("a"), val);
+    cache.put(std::string("b"), val);
+    REQUIRE(cache.size() == 2);
+
+    //Over an evicted entry, whose old key & value are gone either way
+    s_fragile_copies_throw = true;
+    REQUIRE_THROWS_AS(cache.put(std::string("c"), val), std::runtime_error);
+    s_fragile_copies_throw = false;
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.find(std::string("c")) == nullptr);
+
+    //The freed entry is reused
+    cache.put(std::string("c"), val);
+    cache.put(std::string("d"), val);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.find(std::string("d"))->value == 1);
+}
+
+//This test case checks that a hashed_in is hashed once, however many layers it goes through
+TEST_CASE("Testing Hashed Keys in Clock Cache", "[CPPSPT::Cache]")
+{
+    cppspt::clock_cache<int, int, counting_cache_hash> cache(8);
+    cppspt::sharded_clock_cache<int, int, counting_cache_hash> sharded(8, 2);
+
+    s_cache_hash_calls = 0;
+    int raw_key = 5;
+    cppspt::hashed_in<int, counting_cache_hash> key(raw_key);
+    cache.put(key, 50);
+    sharded.put(key, 50);
+
+    int val = 0;
+    REQUIRE(cache.get(key, val));
+    REQUIRE(sharded.get(key, val));
+    REQUIRE(val == 50);
+    REQUIRE(s_cache_hash_calls == 1);
+}
+
+//This test case checks that a warm cache doesn't allocate to replace entries
+TEST_CASE("Testing Allocations of Clock Cache", "[CPPSPT::Cache]")
+{
+    cppspt::clock_cache<int, std::string> cache(64);
+    const std::string value(100, 'v');
+
+    for (int i = 0; i < 64; i++)
+    {
+        cache.put(i, value);
+    }
+
+    std::string result = value;
+    cppspt_tracking::expect_at_most expectation(0, -1);
+    for (int i = 64; i < 1000; i++)
+    {
+        cache.put(i, value);
+        cache.get(i - 1, result);
+    }
+    REQUIRE(expectation.satisfied());
+    REQUIRE(cache.size() == 64);
+}
+
+//This test case checks that shards can be used from several threads at once
+TEST_CASE("Testing Threads on Sharded Clock Cache", "[CPPSPT::Cache]")
+{
+    cppspt::sharded_clock_cache<int, int> cache(1024, 8);
+    REQUIRE(cache.shard_count() == 8);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&cache, t]
+        {
+            for (int i = 0; i < 10000; i++)
+            {
+                int key = (i * 4 + t) % 512;
+                int val;
+                if (!cache.get(key, val))
+                {
+                    cache.put(key, key * 2);
+                }
+                else if (val != key * 2)
+                {
+                    cache.put(-1, -1);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    int val;
+    REQUIRE(!cache.get(-1, val));
+    REQUIRE(cache.size() == 512);
+}
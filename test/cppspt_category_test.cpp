@@ -19,13 +19,13 @@ std::string append(cppspt::in<std::string> str)
 cppspt::uninit<std::string> repeat(int x)
 {
     std::string str(x, 'X');
-    return str;
+    return cppspt::uninit<std::string>(std::move(str));
 }
 
 cppspt::uninit<std::string> twice(cppspt::in<std::string> str)
 {
     std::string temp = cppspt::resolve(std::move(str));
-    return temp + temp;
+    return cppspt::uninit<std::string>(temp + temp);
 }
 
 TEST_CASE("Testing Category Usage", "[CPPSPT::Out]")
@@ -0,0 +1,156 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_category.hpp"
+#include "cppspt/cppspt_column.hpp"
+
+//Every third value is uninitialized
+cppspt::uninit_column<int> make_column(std::size_t size)
+{
+    cppspt::uninit_column<int> column;
+    for (std::size_t i = 0; i < size; i++)
+    {
+        if (i % 3 == 0)
+        {
+            column.push_back(cppspt::unitialized_t);
+        }
+        else
+        {
+            column.push_back(static_cast<int>(i));
+        }
+    }
+    return column;
+}
+
+TEST_CASE("Testing Column Storage", "[CPPSPT::Column]")
+{
+    cppspt::uninit_column<int> column = make_column(200);
+
+    REQUIRE(column.size() == 200);
+    REQUIRE(column.count() == 133);
+
+    REQUIRE(!column.was_initialized(0));
+    REQUIRE(column.was_initialized(1));
+    REQUIRE(column[130] == 130);
+    REQUIRE(!column.get(129).was_initialized());
+    REQUIRE(*column.get(131) == 131);
+
+    column.set(0, 7);
+    REQUIRE(column[0] == 7);
+
+    column.reset(1);
+    REQUIRE(!column.was_initialized(1));
+
+    //Shrinking clears the validity of the dropped values
+    column.resize(65);
+    column.resize(200);
+    REQUIRE(column.count() == 43);
+}
+
+TEST_CASE("Testing Column Functor & Monad Operations", "[CPPSPT::Column]")
+{
+    cppspt::uninit_column<int> column = make_column(200);
+
+    //fapply keeps the validity of the argument
+    cppspt::uninit_column<long long> doubled = cppspt::fapply([](int x) { return 2LL * x; }, column);
+    REQUIRE(doubled.count() == column.count());
+    REQUIRE(!doubled.was_initialized(99));
+    REQUIRE(doubled[100] == 200);
+
+    //Binary fapply is only initialized where both arguments are
+    cppspt::uninit_column<int> odds(200);
+    for (std::size_t i = 1; i < 200; i += 2)
+    {
+        odds.set(i, 1);
+    }
+    cppspt::uninit_column<int> sums = cppspt::fapply([](int x, int y) { return x + y; }, column, odds);
+    REQUIRE(sums.count() == 67);
+    REQUIRE(sums[1] == 2);
+    REQUIRE(!sums.was_initialized(2));
+    REQUIRE(!sums.was_initialized(3));
+
+    //mbind can uninitialize values
+    cppspt::uninit_column<int> evens = cppspt::mbind(column, [](int x) -> cppspt::uninit<int>
+    {
+        if (x % 2 == 0)
+        {
+            return cppspt::uninit<int>(x);
+        }
+        return cppspt::unitialized_t;
+    });
+    REQUIRE(evens.count() == 66);
+    REQUIRE(evens[2] == 2);
+    REQUIRE(!evens.was_initialized(1));
+
+    //filter matches mbind with a predicate
+    cppspt::uninit_column<int> filtered = cppspt::filter(column, [](int x) { return x % 2 == 0; });
+    REQUIRE(filtered.count() == evens.count());
+
+    //reduce only sees initialized values
+    int expected = 0;
+    for (int i = 0; i < 200; i++)
+    {
+        if (i % 3 != 0)
+        {
+            expected += i;
+        }
+    }
+    REQUIRE(cppspt::reduce(column, 0, [](int acc, int x) { return acc + x; }) == expected);
+    REQUIRE(cppspt::reduce(cppspt::uninit_column<int>(100), 5, [](int acc, int x) { return acc + x; }) == 5);
+}
+
+//This test case checks that pushing one of a column's own values works while the column grows
+TEST_CASE("Testing Column Self Push", "[CPPSPT::Column]")
+{
+    cppspt::uninit_column<int> column;
+    column.push_back(42);
+    for (int i = 0; i < 100; i++)
+    {
+        column.push_back(column[i]);
+    }
+    column.push_back(column.get(100));
+    REQUIRE(column.size() == 102);
+    REQUIRE(column.count() == 102);
+    REQUIRE(column[101] == 42);
+}
+
+//This test case checks that a column of bool keeps a plain value buffer, so the bulk operations work on it
+TEST_CASE("Testing Bool Columns", "[CPPSPT::Column]")
+{
+    cppspt::uninit_column<bool> column;
+    for (int i = 0; i < 130; i++)
+    {
+        if (i % 5 == 0)
+        {
+            column.push_back(cppspt::unitialized_t);
+        }
+        else
+        {
+            column.push_back(i % 2 == 0);
+        }
+    }
+    REQUIRE(column.size() == 130);
+    REQUIRE(column.count() == 104);
+    REQUIRE(column.values()[2]);
+    REQUIRE(!column.values()[3]);
+
+    cppspt::uninit_column<bool> negated = cppspt::fapply([](bool x) { return !x; }, column);
+    REQUIRE(negated.count() == column.count());
+    REQUIRE(!negated[2]);
+    REQUIRE(negated[3]);
+    REQUIRE(!negated.was_initialized(10));
+
+    cppspt::uninit_column<bool> copy = negated;
+    copy.resize(3);
+    copy.resize(8);
+    REQUIRE(copy[1]);
+    REQUIRE(!copy.was_initialized(4));
+    REQUIRE(!copy.values()[6]);
+
+    REQUIRE(cppspt::reduce(column, false, [](bool acc, bool x) { return acc || x; }));
+    REQUIRE(!cppspt::reduce(cppspt::filter(column, [](bool x) { return !x; }), false, [](bool acc, bool x) { return acc || x; }));
+}
@@ -0,0 +1,130 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_containers.hpp"
+#include "cppspt_test.hpp"
+
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct nx_less
+{
+    bool operator()(const NXString& a, const NXString& b) const
+    {
+        return a.get().get() < b.get().get();
+    }
+};
+
+struct nx_hash
+{
+    std::size_t operator()(const NXString& val) const
+    {
+        return std::hash<std::string>()(val.get().get());
+    }
+};
+
+struct nx_equal
+{
+    bool operator()(const NXString& a, const NXString& b) const
+    {
+        return a.get().get() == b.get().get();
+    }
+};
+
+template<typename Container>
+void test_emplace_in()
+{
+    Container container;
+    NXString val(XString("a"));
+
+    REQUIRE(run_with_history([&] { cppspt::emplace_in(container, val); }) == "copy-ctor ");
+    REQUIRE(run_with_history([&] { cppspt::emplace_in(container, std::move(val)); }) == "move-ctor ");
+    REQUIRE(container.size() == 2);
+    REQUIRE(container.back().get().get() == "a");
+}
+
+template<typename Map>
+void test_try_emplace_in(Map& map)
+{
+    NXString key(XString("key"));
+    NXString val(XString("val"));
+
+    //A new key constructs the key and the value once, in the node
+    REQUIRE(run_with_history([&] { REQUIRE(cppspt::try_emplace_in(map, key, val).second); }) == "copy-ctor copy-ctor ");
+
+    //An existing key constructs nothing
+    REQUIRE(run_with_history([&] { REQUIRE(!cppspt::try_emplace_in(map, std::move(key), std::move(val)).second); }) == "");
+    REQUIRE(key.get().get() == "key");
+
+    NXString other_key(XString("other"));
+    REQUIRE(run_with_history([&] { cppspt::try_emplace_in(map, std::move(other_key), std::move(val)); }) == "move-ctor move-ctor ");
+    REQUIRE(map.size() == 2);
+}
+
+//This test case checks that appending an in constructs the element once
+TEST_CASE("Testing Emplace In", "[CPPSPT::Containers]")
+{
+    construction_count count = run_with_constructions([]
+    {
+        std::vector<XString> vec;
+        vec.reserve(2);
+        XString val("a");
+        cppspt::emplace_in(vec, val);
+        cppspt::emplace_in(vec, XString("b"));
+    });
+
+    REQUIRE(count.constructions == 4);
+    REQUIRE(count.copy_constructions == 1);
+    REQUIRE(count.move_constructions == 1);
+
+    test_emplace_in<std::deque<NXString>>();
+
+    //(The vector is reserved, so that it doesn't reallocate between the two appends)
+    std::vector<NXString> vec;
+    vec.reserve(2);
+    NXString val(XString("a"));
+    REQUIRE(run_with_history([&] { cppspt::emplace_in(vec, val); }) == "copy-ctor ");
+    REQUIRE(run_with_history([&] { cppspt::emplace_in(vec, std::move(val)); }) == "move-ctor ");
+}
+
+//This test case checks that the bulk append reserves once, so existing elements are never moved
+TEST_CASE("Testing Emplace All In", "[CPPSPT::Containers]")
+{
+    std::vector<NXString> source(3, NXString(XString("x")));
+    std::vector<NXString> vec;
+
+    REQUIRE(run_with_history([&] { cppspt::emplace_all_in(vec, source.begin(), source.end()); }) == "copy-ctor copy-ctor copy-ctor ");
+    REQUIRE(vec.size() == 3);
+
+    std::vector<NXString> moved;
+    REQUIRE(run_with_history([&] { cppspt::emplace_all_in(moved, std::make_move_iterator(source.begin()), std::make_move_iterator(source.end())); }) == "move-ctor move-ctor move-ctor ");
+}
+
+//This test case checks that map insertion looks up through the in, and constructs key & value once
+TEST_CASE("Testing Try Emplace In", "[CPPSPT::Containers]")
+{
+    std::map<NXString, NXString, nx_less> map;
+    test_try_emplace_in(map);
+
+    std::unordered_map<NXString, NXString, nx_hash, nx_equal> unordered;
+    test_try_emplace_in(unordered);
+
+    std::map<std::string, int> counts;
+    std::vector<std::pair<std::string, int>> pairs = { { "a", 1 }, { "b", 2 }, { "a", 3 } };
+    cppspt::try_emplace_all_in(counts, pairs.begin(), pairs.end());
+    REQUIRE(counts.size() == 2);
+    REQUIRE(counts["a"] == 1);
+
+    std::unordered_map<std::string, int> unordered_counts;
+    cppspt::try_emplace_all_in(unordered_counts, std::make_move_iterator(pairs.begin()), std::make_move_iterator(pairs.end()));
+    REQUIRE(unordered_counts.size() == 2);
+    REQUIRE(unordered_counts["b"] == 2);
+}
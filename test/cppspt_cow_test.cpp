@@ -0,0 +1,79 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_cow.hpp"
+#include "cppspt_test.hpp"
+
+#include <string>
+
+std::size_t read_cow(cppspt::in_cow<NXString> str)
+{
+    return str->get().get().size();
+}
+
+std::string modify_cow(cppspt::in_cow<NXString> str, bool modify)
+{
+    if (modify)
+    {
+        NXString replacement(XString("modified"));
+        str.mut() = std::move(replacement);
+    }
+    return str->get().get();
+}
+
+NXString take_cow(cppspt::in_cow<NXString> str)
+{
+    return cppspt::resolve(str);
+}
+
+std::size_t cow_from_in(cppspt::in<NXString> str)
+{
+    cppspt::in_cow<NXString> cow(std::move(str));
+    cow.mut();
+    return cow.was_copied() ? 1 : 0;
+}
+
+//This test case checks that reading an in_cow never copies
+TEST_CASE("Testing In Cow Reads", "[CPPSPT::InCow]")
+{
+    NXString str(XString("hello"));
+
+    REQUIRE(run_with_history([&] { REQUIRE(read_cow(str) == 5); }) == "");
+    REQUIRE(run_with_history([&] { REQUIRE(modify_cow(str, false) == "hello"); }) == "");
+}
+
+//This test case checks that a borrowed value is copied on the first mutable access only, and a moved value never is
+TEST_CASE("Testing In Cow Writes", "[CPPSPT::InCow]")
+{
+    NXString str(XString("hello"));
+
+    REQUIRE(run_with_history([&] { REQUIRE(modify_cow(str, true) == "modified"); }) == "ctor copy-ctor move-assn dtor dtor ");
+    REQUIRE(str.get().get() == "hello");
+
+    REQUIRE(run_with_history([&] { REQUIRE(modify_cow(std::move(str), true) == "modified"); }) == "ctor move-assn dtor ");
+
+    std::string val = "abc";
+    cppspt::in_cow<std::string> cow(val);
+    REQUIRE(cow.is_borrowed());
+    cow.mut() += "d";
+    cow.mut() += "e";
+    REQUIRE(cow.was_copied());
+    REQUIRE(*cow == "abcde");
+    REQUIRE(val == "abc");
+}
+
+//This test case checks that resolving moves whenever the value is owned, and copies only a borrowed value
+TEST_CASE("Testing In Cow Resolve", "[CPPSPT::InCow]")
+{
+    NXString str(XString("hello"));
+
+    REQUIRE(run_with_history([&] { take_cow(str); }) == "copy-ctor dtor ");
+    REQUIRE(run_with_history([&] { take_cow(std::move(str)); }) == "move-ctor dtor ");
+
+    NXString other(XString("other"));
+    REQUIRE(run_with_history([&] { REQUIRE(cow_from_in(std::move(other)) == 0); }) == "");
+    REQUIRE(run_with_history([&] { REQUIRE(cow_from_in(other) == 1); }) == "copy-ctor dtor ");
+}
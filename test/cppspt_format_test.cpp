@@ -0,0 +1,115 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_format.hpp"
+#include "cppspt_test.hpp"
+
+#include <sstream>
+#include <string>
+
+std::ostream& operator<<(std::ostream& out, const NXString& str)
+{
+    return out << str.get().get();
+}
+
+template<typename T>
+std::string stream_to_string(const T& val)
+{
+    std::ostringstream stream;
+    stream << val;
+    return stream.str();
+}
+
+std::string stream_in(cppspt::in<NXString> str)
+{
+    return stream_to_string(str);
+}
+
+std::string stream_out(cppspt::out<int> val)
+{
+    return stream_to_string(val);
+}
+
+//This test case checks that the stream operators print the value, or "[Uninitialized]"
+TEST_CASE("Testing Stream Output", "[CPPSPT::Format]")
+{
+    cppspt::uninit<int> empty;
+    cppspt::uninit<int> full(42);
+    REQUIRE(stream_to_string(empty) == "[Uninitialized]");
+    REQUIRE(stream_to_string(full) == "42");
+
+    int val = 7;
+    REQUIRE(stream_out(val) == "7");
+    REQUIRE(stream_out(empty) == "[Uninitialized]");
+    REQUIRE(stream_out(full) == "42");
+}
+
+//This test case checks that printing reads through a const reference, without copying the value
+TEST_CASE("Testing Stream Output Without Copies", "[CPPSPT::Format]")
+{
+    cppspt::uninit<NXString> str(NXString(XString("hello")));
+    NXString lvalue(XString("world"));
+
+    REQUIRE(run_with_history([&] { REQUIRE(stream_to_string(str) == "hello"); }) == "");
+    REQUIRE(run_with_history([&] { REQUIRE(stream_in(lvalue) == "world"); }) == "");
+}
+
+#if CPPSPT_CPLUSPLUS >= 201703L
+
+//This test case checks to_chars for uninit, in and out
+TEST_CASE("Testing To Chars", "[CPPSPT::Format]")
+{
+    char buffer[32];
+
+    cppspt::uninit<int> empty;
+    cppspt::uninit<int> full(42);
+
+    std::to_chars_result result = cppspt::to_chars(buffer, buffer + sizeof(buffer), empty);
+    REQUIRE(result.ec == std::errc());
+    REQUIRE(std::string(buffer, result.ptr) == "[Uninitialized]");
+
+    result = cppspt::to_chars(buffer, buffer + sizeof(buffer), full);
+    REQUIRE(std::string(buffer, result.ptr) == "42");
+
+    result = cppspt::to_chars(buffer, buffer + 4, empty);
+    REQUIRE(result.ec == std::errc::value_too_large);
+
+    auto write_in = [&](cppspt::in<int> val) { return cppspt::to_chars(buffer, buffer + sizeof(buffer), val, 16); };
+    result = write_in(255);
+    REQUIRE(std::string(buffer, result.ptr) == "ff");
+
+    auto write_out = [&](cppspt::out<int> val) { return cppspt::to_chars(buffer, buffer + sizeof(buffer), val); };
+    result = write_out(empty);
+    REQUIRE(std::string(buffer, result.ptr) == "[Uninitialized]");
+    result = write_out(full);
+    REQUIRE(std::string(buffer, result.ptr) == "42");
+}
+
+#if defined (__cpp_lib_format)
+
+//This test case checks that std::format formats uninit, in and out with the underlying value's format specs
+TEST_CASE("Testing Formatters", "[CPPSPT::Format]")
+{
+    cppspt::uninit<int> empty;
+    cppspt::uninit<int> full(42);
+
+    REQUIRE(std::format("{}", empty) == "[Uninitialized]");
+    REQUIRE(std::format("{:>4}", full) == "  42");
+
+    auto format_in = [](cppspt::in<int> val) { return std::format("{:x}", val); };
+    REQUIRE(format_in(255) == "ff");
+
+    auto format_out = [](cppspt::out<int> val) { return std::format("{:03}", val); };
+    REQUIRE(format_out(empty) == "[Uninitialized]");
+    REQUIRE(format_out(full) == "042");
+
+    int val = 7;
+    REQUIRE(format_out(val) == "007");
+}
+
+#endif
+
+#endif
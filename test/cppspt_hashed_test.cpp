@@ -0,0 +1,126 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_cache.hpp"
+#include "cppspt/cppspt_hashed.hpp"
+#include "cppspt_test.hpp"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+static int s_hash_calls = 0;
+
+struct counting_hash
+{
+    std::size_t operator()(const std::string& key) const
+    {
+        s_hash_calls++;
+        return std::hash<std::string>()(key);
+    }
+};
+
+using hashed_string = cppspt::hashed_in<std::string, counting_hash>;
+
+//Three layers, each of which reads the hash
+std::size_t layer_3(const hashed_string& key)
+{
+    return key.hash() ^ key->size();
+}
+
+std::size_t layer_2(hashed_string key)
+{
+    return layer_3(key);
+}
+
+std::size_t layer_1(hashed_string key)
+{
+    return layer_2(key);
+}
+
+//This test case checks that the key is hashed once, however many layers read the hash
+TEST_CASE("Testing Hashed In", "[CPPSPT::HashedIn]")
+{
+    std::string key(100, 'k');
+
+    s_hash_calls = 0;
+    std::size_t result = layer_1(key);
+    REQUIRE(s_hash_calls == 1);
+    REQUIRE(result == (std::hash<std::string>()(key) ^ 100));
+
+    s_hash_calls = 0;
+    layer_1(hashed_string(key, 7));
+    REQUIRE(s_hash_calls == 0);
+}
+
+//This test case checks that copying a hashed_in borrows the key, and a moved key can still be moved into place
+TEST_CASE("Testing Hashed In Captures", "[CPPSPT::HashedIn]")
+{
+    NXString str(XString("key"));
+
+    auto borrow = [&]
+    {
+        cppspt::hashed_in<NXString, std::hash<std::string>> hashed(cppspt::in<NXString>(str), 1);
+        cppspt::hashed_in<NXString, std::hash<std::string>> copy(hashed);
+        REQUIRE(copy->get().get() == "key");
+    };
+
+    auto resolve_moved = [&]
+    {
+        cppspt::hashed_in<NXString, std::hash<std::string>> hashed(cppspt::in<NXString>(std::move(str)), 1);
+        NXString owned = cppspt::resolve(hashed.key());
+    };
+
+    REQUIRE(run_with_history(borrow) == "");
+    REQUIRE(run_with_history(resolve_moved) == "move-ctor dtor ");
+}
+
+//This test case checks the transparent hash & equality
+TEST_CASE("Testing Hashed In Functors", "[CPPSPT::HashedIn]")
+{
+    cppspt::hashed_in_hash<std::string> hash;
+    cppspt::hashed_in_equal<std::string> equal;
+
+    std::string key = "key";
+    cppspt::hashed_in<std::string> hashed(key);
+
+    REQUIRE(hash(hashed) == hash(key));
+    REQUIRE(equal(hashed, key));
+    REQUIRE(equal(key, hashed));
+    REQUIRE(!equal(hashed, std::string("other")));
+
+#if defined (__cpp_lib_generic_unordered_lookup)
+    std::unordered_map<std::string, int, cppspt::hashed_in_hash<std::string>, cppspt::hashed_in_equal<std::string>> map;
+    map.emplace("key", 1);
+    REQUIRE(map.find(hashed) != map.end());
+    REQUIRE(map.find(cppspt::hashed_in<std::string>(std::string("missing"))) == map.end());
+#endif
+}
+
+//This test case checks looking up a key that was hashed before it reached the container, at any standard:
+//std::unordered_map only takes a hashed_in from C++20, but the caches do already
+TEST_CASE("Testing Hashed In Lookup", "[CPPSPT::HashedIn]")
+{
+    cppspt::clock_cache<std::string, int, counting_hash> cache(8);
+    cache.put(std::string("key"), 1);
+    cache.put(std::string("other"), 2);
+
+    std::string key("key");
+    hashed_string hashed(key);
+
+    s_hash_calls = 0;
+    const int* found = cache.find(hashed);
+    REQUIRE(found != nullptr);
+    REQUIRE(*found == 1);
+
+    int value = 0;
+    REQUIRE(cache.get(hashed, value));
+    REQUIRE(value == 1);
+
+    //A key with the same hash, but not equal, misses
+    REQUIRE(cache.find(hashed_string(std::string("missing"), hashed.hash())) == nullptr);
+    REQUIRE(s_hash_calls == 0);
+}
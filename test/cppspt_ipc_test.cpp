@@ -0,0 +1,118 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_ipc.hpp"
+
+#if defined (__unix__) || defined (__APPLE__)
+
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+struct ipc_record
+{
+    long long sequence;
+    double values[3];
+};
+
+std::string temp_ring_name(const char* name)
+{
+    return std::string("/cppspt_ipc_test_") + name + "_" + std::to_string(::getpid());
+}
+
+//This test case checks that values pushed through one mapping are read in place through another
+TEST_CASE("Testing Push & Pop of IPC Ring", "[CPPSPT::IPC]")
+{
+    std::string name = temp_ring_name("push");
+
+    cppspt::ipc_ring<ipc_record> producer;
+    REQUIRE(producer.create(name.c_str(), 6));
+    REQUIRE(producer.capacity() == 8);
+
+    //The name is taken until the creator closes
+    cppspt::ipc_ring<ipc_record> duplicate;
+    REQUIRE(!duplicate.create(name.c_str(), 8));
+
+    cppspt::ipc_ring<ipc_record> consumer;
+    REQUIRE(consumer.open(name.c_str()));
+    REQUIRE(consumer.capacity() == 8);
+    REQUIRE(consumer.front() == nullptr);
+
+    //Constructed in the slot, through an out
+    for (long long i = 0; i < 8; i++)
+    {
+        REQUIRE(producer.try_push_with([i](cppspt::out<ipc_record> slot)
+        {
+            ipc_record r = { i, { 1.0, 2.0, 3.0 } };
+            slot = r;
+        }));
+    }
+    REQUIRE(!producer.try_push(ipc_record{ 8, { 0.0, 0.0, 0.0 } }));
+
+    //Read in place, then released
+    const ipc_record* first = consumer.front();
+    REQUIRE(first != nullptr);
+    REQUIRE(first->sequence == 0);
+    REQUIRE(first->values[2] == 3.0);
+    consumer.pop_front();
+
+    REQUIRE(producer.try_push(ipc_record{ 8, { 0.0, 0.0, 0.0 } }));
+
+    ipc_record popped;
+    for (long long i = 1; i <= 8; i++)
+    {
+        REQUIRE(consumer.try_pop(popped));
+        REQUIRE(popped.sequence == i);
+    }
+    REQUIRE(!consumer.try_pop(popped));
+
+    //Opening closed names, or with another type, fails
+    producer.close();
+    cppspt::ipc_ring<ipc_record> late;
+    REQUIRE(!late.open(name.c_str()));
+
+    REQUIRE(producer.create(name.c_str(), 8));
+    cppspt::ipc_ring<int> wrong_type;
+    REQUIRE(!wrong_type.open(name.c_str()));
+}
+
+//This test case checks that a blocked producer & consumer wake each other, through a ring smaller than the stream
+TEST_CASE("Testing Blocking Push & Pop of IPC Ring", "[CPPSPT::IPC]")
+{
+    std::string name = temp_ring_name("blocking");
+    const long long count = 100000;
+
+    cppspt::ipc_ring<ipc_record> producer;
+    REQUIRE(producer.create(name.c_str(), 16));
+
+    long long sum = 0;
+    bool in_order = true;
+    std::thread consumer_thread([&]
+    {
+        cppspt::ipc_ring<ipc_record> consumer;
+        consumer.open(name.c_str());
+        for (long long i = 0; i < count; i++)
+        {
+            const ipc_record& r = consumer.wait_front();
+            in_order = in_order && (r.sequence == i);
+            sum += r.sequence;
+            consumer.pop_front();
+        }
+    });
+
+    for (long long i = 0; i < count; i++)
+    {
+        producer.push(ipc_record{ i, { 0.0, 0.0, 0.0 } });
+    }
+    consumer_thread.join();
+
+    REQUIRE(in_order);
+    REQUIRE(sum == count * (count - 1) / 2);
+}
+
+#endif
@@ -0,0 +1,122 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_mapped.hpp"
+
+#if defined (__unix__) || defined (__APPLE__)
+
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
+struct point
+{
+    double x;
+    double y;
+    int id;
+};
+
+struct other_point
+{
+    double a;
+    double b;
+    int c;
+};
+
+static_assert(sizeof(other_point) == sizeof(point) && alignof(other_point) == alignof(point), "other_point only differs from point by type");
+
+std::string temp_mapped_path(const char* name)
+{
+    return std::string("/tmp/cppspt_mapped_test_") + name + "_" + std::to_string(::getpid()) + ".bin";
+}
+
+TEST_CASE("Testing Mapped Array Persistence", "[CPPSPT::Mapped]")
+{
+    std::string path = temp_mapped_path("persist");
+    std::remove(path.c_str());
+
+    {
+        cppspt::mapped_uninit_array<point> points;
+        REQUIRE(points.open(path.c_str(), 1000));
+        REQUIRE(points.capacity() == 1000);
+        REQUIRE(points.size() == 0);
+
+        point p = { 1.5, 2.5, 7 };
+        REQUIRE(points.push_back(p));
+        points.set(500, point{ 3.0, 4.0, 500 });
+        REQUIRE(points.size() == 501);
+        REQUIRE(!points.was_initialized(1));
+    }
+
+    {
+        //Reopening (with any capacity) gives back the same values
+        cppspt::mapped_uninit_array<point> points;
+        REQUIRE(points.open(path.c_str(), 0));
+        REQUIRE(points.capacity() == 1000);
+        REQUIRE(points.size() == 501);
+        REQUIRE(points.was_initialized(0));
+        REQUIRE(points[0].id == 7);
+        REQUIRE(points[500].y == 4.0);
+        REQUIRE(!points.was_initialized(499));
+
+        points.reset(500);
+    }
+
+    {
+        cppspt::mapped_options options;
+        options.read_only = true;
+        options.populate = true;
+
+        cppspt::mapped_uninit_array<point> points;
+        REQUIRE(points.open(path.c_str(), 1000, options));
+        REQUIRE(points.is_read_only());
+        REQUIRE(!points.was_initialized(500));
+        REQUIRE(points[0].x == 1.5);
+
+        //Writes are rejected, rather than faulting on the read only mapping
+        REQUIRE(!points.push_back(point{ 0.0, 0.0, 1 }));
+        REQUIRE(points.size() == 501);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Testing Mapped Array Header Checks", "[CPPSPT::Mapped]")
+{
+    std::string path = temp_mapped_path("header");
+    std::remove(path.c_str());
+
+    {
+        cppspt::mapped_uninit_array<point> points;
+        REQUIRE(points.open(path.c_str(), 100));
+    }
+
+    //A different type, or a different capacity, is rejected
+    cppspt::mapped_uninit_array<int> ints;
+    REQUIRE(!ints.open(path.c_str(), 100));
+    REQUIRE(!ints.is_open());
+
+    cppspt::mapped_uninit_array<point> points;
+    REQUIRE(!points.open(path.c_str(), 200));
+
+    //As is a different type of the same size & alignment
+    cppspt::mapped_uninit_array<other_point> others;
+    REQUIRE(!others.open(path.c_str(), 100));
+    REQUIRE(points.open(path.c_str(), 100));
+    points.close();
+
+    //Files that don't exist can't be created read-only
+    std::remove(path.c_str());
+    cppspt::mapped_options options;
+    options.read_only = true;
+    REQUIRE(!points.open(path.c_str(), 100, options));
+
+    std::remove(path.c_str());
+}
+
+#endif
@@ -8,7 +8,11 @@
 
 #include "cppspt_test.hpp"
 
-void dont_write_anything(cppspt::out<NXString> str)
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+void dont_write_anything(cppspt::out<NXString>)
 {
 }
 
@@ -37,3 +41,92 @@ TEST_CASE("Testing Out", "[CPPSPT::Out]")
     REQUIRE(run_with_history([] {NXString str; write_move(str); }) == "ctor ctor move-assn dtor dtor ");
     REQUIRE(run_with_history([] {cppspt::uninit<NXString> str; write_move(str); }) == "ctor move-ctor dtor dtor ");
 }
+
+void forward_out(cppspt::out<NXString> str)
+{
+    write_move(str);
+}
+
+//An out is just a (tagged) pointer to its target, so copying it is trivial
+static_assert(std::is_trivially_copy_constructible<cppspt::out<NXString>>::value, "out<T> should be trivially copyable");
+static_assert(std::is_trivially_destructible<cppspt::out<NXString>>::value, "out<T> should be trivially destructible");
+
+TEST_CASE("Testing Out Forwarding", "[CPPSPT::Out]")
+{
+    //Testing that a copied out still writes to the original target
+    REQUIRE(run_with_history([] {NXString str; forward_out(str); }) == "ctor ctor move-assn dtor dtor ");
+    REQUIRE(run_with_history([] {cppspt::uninit<NXString> str; forward_out(str); }) == "ctor move-ctor dtor dtor ");
+}
+
+void write_from_factory(cppspt::out<NXString> str)
+{
+    str.assign_from([] { return NXString(); });
+}
+
+//This test case checks that assign_from builds the result in uninitialized targets, and assigns it to live ones
+TEST_CASE("Testing Out Factory Assignment", "[CPPSPT::Out]")
+{
+    REQUIRE(run_with_history([] {NXString str; write_from_factory(str); }) == "ctor ctor move-assn dtor dtor ");
+    REQUIRE(run_with_history([] {cppspt::uninit<NXString> str; write_from_factory(str); }) == "ctor dtor ");
+
+    //An initialized uninit is assigned, like a direct target
+    REQUIRE(run_with_history([] {cppspt::uninit<NXString> str{ NXString() }; write_from_factory(str); }) == "ctor move-ctor dtor ctor move-assn dtor dtor ");
+
+    construction_count count = run_with_constructions([]
+    {
+        cppspt::uninit<XString> str;
+        cppspt::out<XString>(str).assign_from([] { return XString("made"); });
+        REQUIRE(str->get() == "made");
+    });
+    REQUIRE(count.constructions == 1);
+    REQUIRE(count.move_constructions == 0);
+    REQUIRE(count.move_assignments == 0);
+}
+
+#if CPPSPT_CPLUSPLUS >= 201703L
+
+//This test case checks that assign_from writes a type that can't be moved: built in place, or rebuilt over a live value
+TEST_CASE("Testing Out Factory Assignment of Non-Movable", "[CPPSPT::Out]")
+{
+    //Rebuilding over a live value destroys it first, so the factory must be noexcept
+    auto factory = []() noexcept { return nmString(NString("made")); };
+
+    REQUIRE(run_with_history([&]
+    {
+        cppspt::uninit<nmString> str;
+        cppspt::out<nmString>(str).assign_from(factory);
+        REQUIRE(str->val().get() == "made");
+    }) == "ctor copy-ctor dtor dtor ");
+
+    REQUIRE(run_with_history([&]
+    {
+        nmString str(NString("old"));
+        cppspt::out<nmString>(str).assign_from(factory);
+        REQUIRE(str.val().get() == "made");
+    }) == "ctor copy-ctor dtor dtor ctor copy-ctor dtor dtor ");
+}
+
+#endif
+
+namespace
+{
+    //Can be moved, but not assigned
+    struct fixed_string
+    {
+        const std::string value;
+
+        explicit fixed_string(std::string val) : value(std::move(val)) {}
+        fixed_string(fixed_string&& other) noexcept : value(other.value) {}
+    };
+}
+
+//This test case checks that rebuilding a value that can't be assigned keeps the old value when the factory throws
+TEST_CASE("Testing Out Factory Rebuild Throwing", "[CPPSPT::Out]")
+{
+    fixed_string str("old");
+    REQUIRE_THROWS_AS(cppspt::out<fixed_string>(str).assign_from([]() -> fixed_string { throw std::runtime_error("factory"); }), std::runtime_error);
+    REQUIRE(str.value == "old");
+
+    cppspt::out<fixed_string>(str).assign_from([] { return fixed_string("new"); });
+    REQUIRE(str.value == "new");
+}
@@ -0,0 +1,136 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_outs.hpp"
+
+#include "cppspt_test.hpp"
+
+#include <string>
+
+void write_pair(cppspt::outs<int, NXString> results)
+{
+    results.set<0>(7);
+    results.set<1>(NXString());
+}
+
+void emplace_pair(cppspt::outs<int, XString> results)
+{
+    results.emplace<0>(11);
+    results.emplace<1>(std::string("built"));
+}
+
+//One pointer per result, and one small integer for every kind
+static_assert(sizeof(cppspt::outs<char, short, double>) <= 4 * sizeof(void*), "outs should be a pointer per result, plus one word");
+static_assert(std::is_trivially_copy_constructible<cppspt::outs<int, std::string>>::value, "outs should be trivially copyable");
+
+TEST_CASE("Testing Outs", "[CPPSPT::Outs]")
+{
+    //Testing that live destinations are assigned, and uninit ones are constructed
+    REQUIRE(run_with_history([] { int id = 0; NXString str; write_pair({ id, str }); REQUIRE(id == 7); }) == "ctor ctor move-assn dtor dtor ");
+    REQUIRE(run_with_history([] { cppspt::uninit<int> id; cppspt::uninit<NXString> str; write_pair({ id, str }); REQUIRE(*id == 7); }) == "ctor move-ctor dtor dtor ");
+
+    //Testing a mix of destinations
+    REQUIRE(run_with_history([] { cppspt::uninit<int> id; NXString str; write_pair({ id, str }); REQUIRE(id.was_initialized()); }) == "ctor ctor move-assn dtor dtor ");
+}
+
+//This test case checks that emplacing into uninit destinations builds each result once, in place
+TEST_CASE("Testing Outs Emplace", "[CPPSPT::Outs]")
+{
+    construction_count count = run_with_constructions([]
+    {
+        cppspt::uninit<int> id;
+        cppspt::uninit<XString> name;
+        emplace_pair({ id, name });
+        REQUIRE(*id == 11);
+        REQUIRE(name->get() == "built");
+    });
+    REQUIRE(count.constructions == 1);
+    REQUIRE(count.move_constructions == 0);
+    REQUIRE(count.copy_constructions == 0);
+    REQUIRE(count.constructions == count.destructions);
+
+    //A live destination is assigned a temporary
+    count = run_with_constructions([]
+    {
+        int id = 0;
+        XString name;
+        emplace_pair({ id, name });
+        REQUIRE(name.get() == "built");
+    });
+    REQUIRE(count.move_assignments == 1);
+    REQUIRE(count.move_constructions == 0);
+}
+
+//This test case checks reading results back, and overwriting a result that was already written
+TEST_CASE("Testing Outs Access", "[CPPSPT::Outs]")
+{
+    int id = 0;
+    cppspt::uninit<std::string> name;
+    cppspt::outs<int, std::string> results(id, name);
+
+    REQUIRE(!results.targets_uninit<0>());
+    REQUIRE(results.targets_uninit<1>());
+
+    results.set<0>(3);
+    results.assign_from<1>([] { return std::string(40, 'a'); });
+    REQUIRE(results.get<0>() == 3);
+    REQUIRE(results.get<1>() == std::string(40, 'a'));
+
+    std::string other(40, 'b');
+    results.set<1>(other);
+    REQUIRE(*name == other);
+    REQUIRE(other == std::string(40, 'b'));
+
+    results.emplace<1>(std::size_t(5), 'c');
+    REQUIRE(*name == "ccccc");
+
+    //Arguments may refer to the value they replace
+    results.set<1>(std::string("abcdef"));
+    results.emplace<1>(*name, std::size_t(1), std::size_t(3));
+    REQUIRE(*name == "bcd");
+
+    //Emplacing one convertible argument into a live destination assigns it, keeping the string's buffer
+    std::string live(40, 'd');
+    const char* buffer = live.data();
+    cppspt::outs<int, std::string> live_results(id, live);
+    live_results.emplace<1>("short");
+    REQUIRE(live == "short");
+    REQUIRE(live.data() == buffer);
+
+    //A copy writes to the same destinations
+    cppspt::outs<int, std::string> copy = results;
+    copy.set<0>(9);
+    REQUIRE(id == 9);
+
+    //An uninit the caller already initialized holds a result before this outs writes it
+    cppspt::uninit<std::string> ready(std::string("ready"));
+    cppspt::outs<int, std::string> ready_results(id, ready);
+    REQUIRE(ready_results.get<1>() == "ready");
+
+#if CPPSPT_CPLUSPLUS >= 201703L
+    auto [bound_id, bound_name] = results;
+    REQUIRE(&bound_id == &id);
+    REQUIRE(&bound_name == &*name);
+#endif
+}
+
+#if CPPSPT_CPLUSPLUS >= 201703L
+
+//This test case checks that results which can't be moved are still built in place
+TEST_CASE("Testing Outs Non-movable Results", "[CPPSPT::Outs]")
+{
+    REQUIRE(run_with_history([]
+    {
+        cppspt::uninit<nmString> str;
+        cppspt::outs<nmString> results(str);
+        //A live destination would be rebuilt over its old value, so (as for out) the factory must be noexcept
+        results.assign_from<0>([]() noexcept { return nmString(NString("in place")); });
+        REQUIRE(str->val().get() == "in place");
+    }) == "ctor copy-ctor dtor dtor ");
+}
+
+#endif
@@ -0,0 +1,189 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_parallel.hpp"
+
+#include "cppspt_tracking.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+using TString = cppspt_tracking::tracked<std::string>;
+
+//Values constructed (and not yet destroyed) on any thread since the scope began
+long long live_values(const cppspt_tracking::tracking_scope& scope)
+{
+    cppspt_tracking::counts counts = scope.delta();
+    return counts.constructions - counts.destructions;
+}
+
+TEST_CASE("Testing Partition", "[CPPSPT::Parallel]")
+{
+    //Chunks cover the whole range with no gaps
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < 7; i++)
+    {
+        cppspt::chunk_range range = cppspt::partition(1000, 7, i, 16);
+        REQUIRE(range.begin == next);
+        REQUIRE((range.begin % 16 == 0 || range.begin == 1000));
+        next = range.end;
+    }
+    REQUIRE(next == 1000);
+
+    //More parts than values leaves some chunks empty
+    cppspt::chunk_range range = cppspt::partition(2, 4, 0);
+    REQUIRE(range.begin == range.end);
+}
+
+TEST_CASE("Testing Parallel Init & Destroy", "[CPPSPT::Parallel]")
+{
+    cppspt_tracking::tracking_scope scope(true);
+
+    {
+        cppspt::uninit_array<TString> values(10000, cppspt::parallel_options(4));
+
+        //Nothing is constructed until init
+        REQUIRE(live_values(scope) == 0);
+        REQUIRE(!values[0].was_initialized());
+
+        //Values that were already initialized are kept
+        values[5].init(std::string("first"));
+
+        values.parallel_init(cppspt::parallel_options(4), std::string("hello"));
+        REQUIRE(live_values(scope) == 10000);
+        REQUIRE(values[5]->get() == "first");
+
+        std::atomic<std::size_t> seen(0);
+        values.parallel_for(cppspt::parallel_options(3), [&](const cppspt::uninit<TString>* first, const cppspt::uninit<TString>* last)
+        {
+            for (; first != last; ++first)
+            {
+                if ((*first)->get() == "hello")
+                {
+                    seen++;
+                }
+            }
+        });
+        REQUIRE(seen == 9999);
+
+        values.parallel_destroy(cppspt::parallel_options(4));
+        REQUIRE(live_values(scope) == 0);
+
+        //Values that are still initialized are destroyed with the array
+        values[0].init(std::string("last"));
+        REQUIRE(live_values(scope) == 1);
+    }
+
+    REQUIRE(live_values(scope) == 0);
+
+    //Initializing from a shared argument copies it into each value, but never copies a value
+    REQUIRE(scope.delta().copies == 0);
+}
+
+//This test case checks that every chunk starts on its own page, even when the element size doesn't divide the page size
+TEST_CASE("Testing Parallel Chunks Start on Pages", "[CPPSPT::Parallel]")
+{
+    struct record
+    {
+        char bytes[71];
+    };
+    static_assert(sizeof(cppspt::uninit<record>) == 72, "an element size which doesn't divide the page");
+
+    const std::size_t page = cppspt::detail::page_size();
+    cppspt::uninit_array<record> values(100000, cppspt::parallel_options(3));
+
+    std::atomic<int> misaligned(0);
+    values.parallel_for(cppspt::parallel_options(3), [&](cppspt::uninit<record>* first, cppspt::uninit<record>* last)
+    {
+        if (first != last && reinterpret_cast<std::uintptr_t>(first) % page != 0)
+        {
+            misaligned++;
+        }
+    });
+    REQUIRE(misaligned == 0);
+}
+
+//This test case checks that pinned workers all run, and that the workers are joined when the calling thread's part throws
+TEST_CASE("Testing Run Parallel", "[CPPSPT::Parallel]")
+{
+    std::atomic<unsigned> ran(0);
+    cppspt::run_parallel(cppspt::parallel_options(3, true), [&](unsigned index)
+    {
+        ran |= 1u << index;
+    });
+    REQUIRE(ran == 7);
+
+    ran = 0;
+    bool threw = false;
+    try
+    {
+        cppspt::run_parallel(cppspt::parallel_options(3), [&](unsigned index)
+        {
+            if (index == 0)
+            {
+                throw std::runtime_error("calling thread");
+            }
+            ran |= 1u << index;
+        });
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    REQUIRE(threw);
+    REQUIRE(ran == 6);
+
+    //A worker's exception is rethrown on the calling thread, once every thread has finished
+    ran = 0;
+    threw = false;
+    try
+    {
+        cppspt::run_parallel(cppspt::parallel_options(3), [&](unsigned index)
+        {
+            if (index == 2)
+            {
+                throw std::runtime_error("worker");
+            }
+            ran |= 1u << index;
+        });
+    }
+    catch (const std::runtime_error& error)
+    {
+        threw = (std::string(error.what()) == "worker");
+    }
+    REQUIRE(threw);
+    REQUIRE(ran == 3);
+}
+
+//Constructing from a negative value throws
+struct picky_value
+{
+    int value;
+
+    explicit picky_value(int val) : value(val)
+    {
+        if (val < 0)
+        {
+            throw std::invalid_argument("negative");
+        }
+    }
+};
+
+//This test case checks that a constructor throwing on a worker reaches the caller, and the array stays usable
+TEST_CASE("Testing Throwing Parallel Init", "[CPPSPT::Parallel]")
+{
+    cppspt::uninit_array<picky_value> values(1000, cppspt::parallel_options(4));
+    REQUIRE_THROWS_AS(values.parallel_init(cppspt::parallel_options(4), -1), std::invalid_argument);
+
+    values.parallel_init(cppspt::parallel_options(4), 1);
+    for (const cppspt::uninit<picky_value>& value : values)
+    {
+        REQUIRE(value->value == 1);
+    }
+}
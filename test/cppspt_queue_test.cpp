@@ -0,0 +1,218 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_queue.hpp"
+
+#include "cppspt_test.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+template<typename Queue>
+void test_queue_constructions()
+{
+    //Pushing a move, then popping into an uninit moves twice. Nothing is default constructed or assigned
+    REQUIRE(run_with_history([] { Queue q(4); q.try_push(NXString()); cppspt::uninit<NXString> x; q.try_pop(x); }) == "ctor move-ctor dtor move-ctor dtor dtor ");
+
+    //Pushing a reference copies
+    REQUIRE(run_with_history([] { Queue q(4); NXString s; q.try_push(s); cppspt::uninit<NXString> x; q.try_pop(x); }) == "ctor copy-ctor move-ctor dtor dtor dtor ");
+
+    //Popping into an existing value move assigns
+    REQUIRE(run_with_history([] { Queue q(4); q.try_push(NXString()); NXString x; q.try_pop(x); }) == "ctor move-ctor dtor ctor move-assn dtor dtor ");
+
+    //Values left in the queue are destroyed with it
+    REQUIRE(run_with_history([] { Queue q(4); q.try_push(NXString()); }) == "ctor move-ctor dtor dtor ");
+}
+
+template<typename Queue>
+void test_queue_capacity()
+{
+    Queue q(3);
+    REQUIRE(q.capacity() == 4);
+
+    int x = 0;
+    REQUIRE(!q.try_pop(x));
+    for (int i = 0; i < 4; i++)
+    {
+        REQUIRE(q.try_push(i));
+    }
+    REQUIRE(!q.try_push(4));
+
+    REQUIRE(q.try_pop(x));
+    REQUIRE(x == 0);
+
+    //Batches only take what fits
+    std::vector<int> values = { 10, 11, 12 };
+    REQUIRE(q.try_push_n(values.begin(), values.end()) == 1);
+
+    std::vector<int> popped;
+    REQUIRE(q.try_pop_n(std::back_inserter(popped), 10) == 4);
+    REQUIRE(popped == std::vector<int>({ 1, 2, 3, 10 }));
+}
+
+TEST_CASE("Testing SPSC Queue", "[CPPSPT::Queue]")
+{
+    test_queue_constructions<cppspt::spsc_queue<NXString>>();
+    test_queue_capacity<cppspt::spsc_queue<int>>();
+
+    const int count = 100000;
+    cppspt::spsc_queue<int> q(64);
+
+    std::thread producer([&]
+    {
+        for (int i = 0; i < count; i++)
+        {
+            q.push(i);
+        }
+    });
+
+    bool in_order = true;
+    for (int i = 0; i < count; i++)
+    {
+        int x;
+        q.pop(x);
+        in_order = in_order && (x == i);
+    }
+    producer.join();
+
+    REQUIRE(in_order);
+}
+
+TEST_CASE("Testing MPMC Queue", "[CPPSPT::Queue]")
+{
+    test_queue_constructions<cppspt::mpmc_queue<NXString>>();
+    test_queue_capacity<cppspt::mpmc_queue<int>>();
+
+    const int producers = 4;
+    const int consumers = 4;
+    const int per_producer = 25000;
+    cppspt::mpmc_queue<int> q(128);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&q, p]
+        {
+            for (int i = 0; i < per_producer; i++)
+            {
+                q.push(p * per_producer + i);
+            }
+        });
+    }
+
+    std::vector<std::vector<int>> received(consumers);
+    for (int c = 0; c < consumers; c++)
+    {
+        threads.emplace_back([&q, &received, c]
+        {
+            for (int i = 0; i < per_producer * producers / consumers; i++)
+            {
+                int x;
+                q.pop(x);
+                received[c].push_back(x);
+            }
+        });
+    }
+
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    //Every value arrives exactly once
+    std::vector<int> seen(producers * per_producer, 0);
+    for (const std::vector<int>& values : received)
+    {
+        for (int x : values)
+        {
+            seen[x]++;
+        }
+    }
+    REQUIRE(std::count(seen.begin(), seen.end(), 1) == producers * per_producer);
+}
+
+namespace
+{
+    //Copies (or moves) throw once copies_left (or moves_left) runs out
+    struct fragile_value
+    {
+        static int copies_left;
+        static int moves_left;
+
+        int value;
+
+        explicit fragile_value(int val) : value(val) {}
+        fragile_value(const fragile_value& other) : value(other.value)
+        {
+            if (copies_left-- == 0)
+            {
+                throw std::runtime_error("copy");
+            }
+        }
+        fragile_value(fragile_value&& other) : value(other.value)
+        {
+            if (moves_left-- == 0)
+            {
+                throw std::runtime_error("move");
+            }
+        }
+        fragile_value& operator=(const fragile_value&) = default;
+        fragile_value& operator=(fragile_value&&) = default;
+    };
+
+    int fragile_value::copies_left = 1000;
+    int fragile_value::moves_left = 1000;
+}
+
+//This test case checks that a copy or move throwing in a push or pop doesn't leave its slots claimed
+TEST_CASE("Testing MPMC Queue Exceptions", "[CPPSPT::Queue]")
+{
+    cppspt::mpmc_queue<fragile_value> q(4);
+    fragile_value one(1);
+    fragile_value two(2);
+
+    //The slot of a push that threw is skipped
+    fragile_value::copies_left = 0;
+    REQUIRE_THROWS_AS(q.try_push(one), std::runtime_error);
+    fragile_value::copies_left = 1000;
+    REQUIRE(q.try_push(two));
+
+    cppspt::uninit<fragile_value> popped;
+    REQUIRE(q.try_pop(popped));
+    REQUIRE(popped->value == 2);
+    REQUIRE(!q.try_pop(popped));
+
+    //So are the slots a batch claimed after the value that threw
+    std::vector<fragile_value> batch(3, fragile_value(3));
+    fragile_value::copies_left = 1;
+    REQUIRE_THROWS_AS(q.try_push_n(batch.begin(), batch.end()), std::runtime_error);
+    fragile_value::copies_left = 1000;
+
+    std::vector<fragile_value> received;
+    received.reserve(4);
+    REQUIRE(q.try_pop_n(std::back_inserter(received), 4) == 1);
+    REQUIRE(received[0].value == 3);
+
+    //A pop that threw drops its value
+    REQUIRE(q.try_push(one));
+    popped.reset();
+    fragile_value::moves_left = 0;
+    REQUIRE_THROWS_AS(q.try_pop(popped), std::runtime_error);
+    fragile_value::moves_left = 1000;
+    REQUIRE(!q.try_pop(popped));
+
+    //Every slot is free again
+    for (int i = 0; i < 4; i++)
+    {
+        REQUIRE(q.try_push(two));
+    }
+    REQUIRE(q.try_pop_n(std::back_inserter(received), 4) == 4);
+    REQUIRE(received.size() == 5);
+}
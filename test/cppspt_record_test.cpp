@@ -0,0 +1,165 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_record.hpp"
+#include "cppspt_test.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+static_assert(sizeof(cppspt::uninit_record<int, int>) < sizeof(std::pair<cppspt::uninit<int>, cppspt::uninit<int>>), "A record should be smaller than a pair of uninits");
+static_assert(sizeof(cppspt::uninit_record<int, int>) == 3 * sizeof(int), "A record of two ints should need one extra (padded) byte");
+static_assert(sizeof(cppspt::uninit_record<int, int>::mask_type) == 1, "8 fields should share one byte");
+static_assert(sizeof(cppspt::uninit_record<char, char, char, char, char, char, char, char, char>::mask_type) == 2, "9 fields need a 16-bit mask");
+static_assert(std::is_nothrow_move_constructible<cppspt::uninit_record<int, std::string>>::value, "A record should move noexcept when its fields do");
+static_assert(!std::is_nothrow_move_constructible<cppspt::uninit_record<int, XString>>::value, "A record can't move noexcept when a field may throw");
+
+//A temporary field handle can't be passed as an out, which would point to the handle after it's gone
+static_assert(!std::is_convertible<cppspt::detail::record_field<int>, cppspt::out<int>>::value, "A temporary field handle shouldn't convert to an out");
+static_assert(std::is_convertible<cppspt::detail::record_field<int>&, cppspt::out<int>>::value, "A field handle should convert to an out");
+
+namespace
+{
+    //Throws from its copy constructor once copies_left runs out
+    struct throwing_copy
+    {
+        static int copies_left;
+        static int live;
+
+        throwing_copy() { live++; }
+        throwing_copy(const throwing_copy&)
+        {
+            if (copies_left-- == 0)
+            {
+                throw std::runtime_error("copy");
+            }
+            live++;
+        }
+        ~throwing_copy() { live--; }
+    };
+
+    int throwing_copy::copies_left = 0;
+    int throwing_copy::live = 0;
+}
+
+void write_field(cppspt::out<NXString> str)
+{
+    str = NXString(XString("written"));
+}
+
+//This test case checks that a record doesn't construct any field until it's initialized
+TEST_CASE("Testing Default Construction of Uninit Record", "[CPPSPT::UninitRecord]")
+{
+    REQUIRE(run_with_history([] { cppspt::uninit_record<NXString, NXString> record; }) == "");
+
+    cppspt::uninit_record<int, std::string, double> record;
+    REQUIRE(!record.any_initialized());
+    REQUIRE(!record.all_initialized());
+    REQUIRE(!record.was_initialized<1>());
+}
+
+//This test case checks that fields are constructed once through their handles, and destroyed once
+TEST_CASE("Testing Fields of Uninit Record", "[CPPSPT::UninitRecord]")
+{
+    auto assign_first = []
+    {
+        cppspt::uninit_record<NXString, NXString, NXString> record;
+        record.get<0>() = NXString();
+    };
+
+    auto assign_twice = []
+    {
+        NXString val;
+        cppspt::uninit_record<NXString, NXString> record;
+        record.get<1>() = val;
+        record.get<1>() = val;
+    };
+
+    REQUIRE(run_with_history(assign_first) == "ctor move-ctor dtor dtor ");
+    REQUIRE(run_with_history(assign_twice) == "ctor copy-ctor copy-assn dtor dtor ");
+
+    cppspt::uninit_record<int, std::string, double> record;
+    record.get<0>() = 1;
+    record.init<1>(3, 'x');
+    REQUIRE(record.initialized_mask() == 3);
+    REQUIRE(!record.all_initialized());
+
+    record.get<2>() = 2.5;
+    REQUIRE(record.all_initialized());
+    REQUIRE(record.value<0>() == 1);
+    REQUIRE(*record.get<1>() == "xxx");
+    REQUIRE(record.value<2>() == 2.5);
+
+    record.reset<1>();
+    REQUIRE(!record.was_initialized<1>());
+    REQUIRE(record.initialized_mask() == 5);
+}
+
+//This test case checks that a field handle can be passed as an out parameter
+TEST_CASE("Testing Uninit Record Fields as Out", "[CPPSPT::UninitRecord]")
+{
+    auto write_record = []
+    {
+        cppspt::uninit_record<NXString, NXString> record;
+        auto field = record.get<1>();
+        write_field(field);
+        REQUIRE(record.was_initialized<1>());
+        REQUIRE(!record.was_initialized<0>());
+        REQUIRE(record.value<1>().get().get() == "written");
+    };
+
+    REQUIRE(run_with_history(write_record) == "ctor move-ctor dtor dtor ");
+}
+
+//This test case checks that only the initialized fields are copied, moved & destroyed
+TEST_CASE("Testing Copy and Move of Uninit Record", "[CPPSPT::UninitRecord]")
+{
+    construction_count count = run_with_constructions([]
+    {
+        cppspt::uninit_record<XString, XString, XString, XString> record;
+        record.init<2>("two");
+
+        cppspt::uninit_record<XString, XString, XString, XString> copy(record);
+        REQUIRE(copy.initialized_mask() == 4);
+        REQUIRE(copy.value<2>().get() == "two");
+
+        cppspt::uninit_record<XString, XString, XString, XString> moved(std::move(copy));
+        REQUIRE(moved.value<2>().get() == "two");
+
+        moved = record;
+        REQUIRE(moved.initialized_mask() == 4);
+    });
+
+    REQUIRE(count.constructions == 4);
+    REQUIRE(count.destructions == 4);
+    REQUIRE(count.copy_constructions == 2);
+    REQUIRE(count.move_constructions == 1);
+}
+
+//This test case checks that the fields already copied are destroyed when copying a later one throws
+TEST_CASE("Testing Throwing Copy of Uninit Record", "[CPPSPT::UninitRecord]")
+{
+    using record_type = cppspt::uninit_record<throwing_copy, throwing_copy, throwing_copy>;
+    {
+        record_type record;
+        record.init<0>();
+        record.init<2>();
+        REQUIRE(throwing_copy::live == 2);
+
+        throwing_copy::copies_left = 1;
+        REQUIRE_THROWS_AS(record_type(record), std::runtime_error);
+        REQUIRE(throwing_copy::live == 2);
+
+        record_type target;
+        throwing_copy::copies_left = 1;
+        REQUIRE_THROWS_AS(target = record, std::runtime_error);
+        REQUIRE(target.initialized_mask() == 1);
+        REQUIRE(throwing_copy::live == 3);
+    }
+    REQUIRE(throwing_copy::live == 0);
+}
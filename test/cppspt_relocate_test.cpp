@@ -0,0 +1,228 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_relocate.hpp"
+
+#include "cppspt_test.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+//An owning handle, which is safe to relocate by copying its bytes
+struct counted_handle
+{
+    std::unique_ptr<int> value;
+
+    explicit counted_handle(int val) : value(new int(val))
+    {
+        s_construction_count.constructions++;
+    }
+
+    counted_handle(counted_handle&& other) : value(std::move(other.value))
+    {
+        s_construction_count.constructions++;
+        s_construction_count.move_constructions++;
+    }
+
+    ~counted_handle()
+    {
+        s_construction_count.destructions++;
+    }
+};
+
+namespace cppspt
+{
+    template<>
+    struct is_trivially_relocatable<counted_handle> : std::true_type {};
+}
+
+static_assert(cppspt::is_trivially_relocatable<int>::value, "trivially copyable types are relocatable");
+static_assert(cppspt::is_trivially_relocatable<std::unique_ptr<int>>::value, "unique_ptr with the default deleter is relocatable");
+static_assert(cppspt::is_trivially_relocatable<cppspt::uninit<counted_handle>>::value, "uninits of relocatable types are relocatable");
+static_assert(!cppspt::is_trivially_relocatable<std::string>::value, "types are only relocatable if they opt in");
+static_assert(!cppspt::is_trivially_relocatable<cppspt::uninit<XString>>::value, "types are only relocatable if they opt in");
+
+//This test case checks that growing & erasing relocatable values neither moves nor destroys them
+TEST_CASE("Testing Trivial Relocation in Uninit Vector", "[CPPSPT::Relocate]")
+{
+    construction_count count = run_with_constructions([]
+    {
+        cppspt::uninit_vector<counted_handle> handles;
+        for (int i = 0; i < 100; i++)
+        {
+            if (i % 10 == 0)
+            {
+                handles.push_back_uninit();
+            }
+            else
+            {
+                handles.emplace_back(i);
+            }
+        }
+        REQUIRE(handles.size() == 100);
+        REQUIRE(handles.capacity() >= 100);
+
+        //Constructed in place, then never moved
+        REQUIRE(s_construction_count.move_constructions == 0);
+        REQUIRE(s_construction_count.constructions - s_construction_count.destructions == 90);
+
+        handles.erase(1);
+        REQUIRE(handles.size() == 99);
+        REQUIRE(s_construction_count.constructions - s_construction_count.destructions == 89);
+        REQUIRE(s_construction_count.move_constructions == 0);
+
+        for (int i = 0; i < 99; i++)
+        {
+            int original = (i == 0) ? 0 : i + 1;
+            REQUIRE(handles[i].was_initialized() == (original % 10 != 0));
+            if (original % 10 != 0)
+            {
+                REQUIRE(*handles[i]->value == original);
+            }
+        }
+    });
+
+    REQUIRE(count.constructions == count.destructions);
+}
+
+//This test case checks that values which aren't relocatable, and whose move may throw (like XString's), are copied when growing
+TEST_CASE("Testing Relocation by Copy in Uninit Vector", "[CPPSPT::Relocate]")
+{
+    construction_count count = run_with_constructions([]
+    {
+        cppspt::uninit_vector<XString> strings;
+        strings.push_back_uninit();
+        for (int i = 1; i < 20; i++)
+        {
+            strings.push_back(XString(std::string(40, static_cast<char>('a' + i))));
+        }
+        REQUIRE(s_construction_count.move_constructions == 19);
+        REQUIRE(s_construction_count.copy_constructions > 19);
+
+        strings.erase(5);
+        strings.erase(0);
+        REQUIRE(strings.size() == 18);
+        for (int i = 0; i < 18; i++)
+        {
+            char expected = static_cast<char>('a' + ((i < 4) ? i + 1 : i + 2));
+            REQUIRE(strings[i]->get() == std::string(40, expected));
+        }
+
+        strings.pop_back();
+        REQUIRE(strings.size() == 17);
+    });
+
+    REQUIRE(count.constructions == count.destructions);
+}
+
+//This test case checks relocating overlapping ranges, in both directions
+TEST_CASE("Testing Overlapping Relocation", "[CPPSPT::Relocate]")
+{
+    using slot = cppspt::uninit<std::string>;
+    std::unique_ptr<char[]> buffer(new char[sizeof(slot) * 8]);
+    slot* slots = reinterpret_cast<slot*>(buffer.get());
+
+    for (int i = 0; i < 4; i++)
+    {
+        new (slots + i) slot(std::string(30, static_cast<char>('a' + i)));
+    }
+
+    //Up by two, then back down by one
+    cppspt::relocate_n(slots, 4, slots + 2);
+    for (int i = 0; i < 4; i++)
+    {
+        REQUIRE(*slots[i + 2] == std::string(30, static_cast<char>('a' + i)));
+    }
+
+    cppspt::relocate_n(slots + 2, 4, slots + 1);
+    cppspt::relocate(slots + 4, slots + 7);
+    REQUIRE(*slots[1] == std::string(30, 'a'));
+    REQUIRE(*slots[3] == std::string(30, 'c'));
+    REQUIRE(*slots[7] == std::string(30, 'd'));
+
+    slots[1].~slot();
+    slots[2].~slot();
+    slots[3].~slot();
+    slots[7].~slot();
+}
+
+//This test case checks pushing an element of the vector itself, when pushing has to grow the vector
+TEST_CASE("Testing Self Push in Uninit Vector", "[CPPSPT::Relocate]")
+{
+    cppspt::uninit_vector<std::string> strings;
+    strings.reserve(2);
+    strings.push_back(std::string(30, 'x'));
+    strings.push_back(std::string(30, 'y'));
+    REQUIRE(strings.size() == strings.capacity());
+
+    strings.push_back(*strings[0]);
+    REQUIRE(*strings[2] == std::string(30, 'x'));
+
+    strings.push_back(std::move(*strings[1]));
+    REQUIRE(*strings[3] == std::string(30, 'y'));
+}
+
+namespace
+{
+    //Copies throw once copies_left runs out; its move isn't noexcept either
+    struct fragile
+    {
+        static int copies_left;
+        static int live;
+
+        int value;
+
+        explicit fragile(int val) : value(val) { live++; }
+        fragile(const fragile& other) : value(other.value)
+        {
+            if (copies_left-- == 0)
+            {
+                throw std::runtime_error("copy");
+            }
+            live++;
+        }
+        fragile(fragile&& other) : value(other.value) { live++; }
+        fragile& operator=(fragile&& other) { value = other.value; return *this; }
+        ~fragile() { live--; }
+    };
+
+    int fragile::copies_left = 0;
+    int fragile::live = 0;
+}
+
+//This test case checks that a throw while growing leaves the elements where they were
+TEST_CASE("Testing Throwing Growth of Uninit Vector", "[CPPSPT::Relocate]")
+{
+    {
+        cppspt::uninit_vector<fragile> values;
+        for (int i = 0; i < 4; i++)
+        {
+            values.emplace_back(i);
+        }
+        REQUIRE(values.capacity() == 4);
+
+        fragile::copies_left = 2;
+        REQUIRE_THROWS_AS(values.emplace_back(4), std::runtime_error);
+        REQUIRE(values.size() == 4);
+        REQUIRE(values.capacity() == 4);
+        REQUIRE(fragile::live == 4);
+        for (int i = 0; i < 4; i++)
+        {
+            REQUIRE(values[i]->value == i);
+        }
+
+        fragile::copies_left = 100;
+        values.emplace_back(4);
+        values.erase(1);
+        REQUIRE(values.size() == 4);
+        REQUIRE(values[1]->value == 2);
+        REQUIRE(values[3]->value == 4);
+        REQUIRE(fragile::live == 4);
+    }
+    REQUIRE(fragile::live == 0);
+}
@@ -0,0 +1,107 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_retire.hpp"
+
+#include "cppspt_test.hpp"
+
+#include <string>
+#include <thread>
+
+//This test case checks that retired values are destroyed in drain, not when they are retired
+TEST_CASE("Testing Retire and Drain", "[CPPSPT::Retire]")
+{
+    construction_count count = run_with_constructions([]
+    {
+        cppspt::retire_queue queue(cppspt::retire_options(2, 0));
+        cppspt::retire_buffer<XString> buffer(queue);
+
+        XString a("a");
+        buffer.retire(std::move(a));
+        REQUIRE(buffer.size() == 1);
+        REQUIRE(queue.pending() == 0);
+
+        buffer.retire(XString("b"));
+        REQUIRE(buffer.size() == 0);
+        REQUIRE(queue.pending() == 2);
+
+        //The two values moved into the batch are still alive
+        REQUIRE(s_construction_count.constructions - s_construction_count.destructions == 3);
+
+        REQUIRE(queue.drain() == 2);
+        REQUIRE(queue.pending() == 0);
+        REQUIRE(s_construction_count.constructions - s_construction_count.destructions == 1);
+    });
+
+    REQUIRE(count.constructions == count.destructions);
+}
+
+//This test case checks retiring the old value of an uninit on assignment
+TEST_CASE("Testing Retire on Assign", "[CPPSPT::Retire]")
+{
+    cppspt::retire_queue queue;
+    cppspt::retire_buffer<std::string> buffer(queue);
+
+    cppspt::uninit<std::string> value;
+    buffer.assign(value, std::string("first"));
+    REQUIRE(buffer.size() == 0);
+
+    buffer.assign(value, std::string("second"));
+    REQUIRE(*value == "second");
+    REQUIRE(buffer.size() == 1);
+
+    buffer.retire(value);
+    REQUIRE(!value.was_initialized());
+    REQUIRE(buffer.size() == 2);
+
+    buffer.flush();
+    REQUIRE(queue.pending() == 2);
+    REQUIRE(queue.drain() == 2);
+}
+
+//This test case checks that a full queue makes the retiring thread destroy its own batch
+TEST_CASE("Testing Retire Backpressure", "[CPPSPT::Retire]")
+{
+    cppspt::retire_queue queue(cppspt::retire_options(1, 3));
+    cppspt::retire_buffer<std::string> buffer(queue);
+
+    for (int i = 0; i < 5; i++)
+    {
+        buffer.retire(std::string(100, 'x'));
+    }
+
+    REQUIRE(queue.pending() == 3);
+    REQUIRE(queue.destroyed_inline() == 2);
+}
+
+//This test case checks that the background thread destroys batches from several threads
+TEST_CASE("Testing Retire Background Thread", "[CPPSPT::Retire]")
+{
+    cppspt::retire_queue queue(cppspt::retire_options(8, 0));
+    queue.start();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&queue]
+        {
+            cppspt::retire_buffer<std::string> buffer(queue);
+            for (int i = 0; i < 1000; i++)
+            {
+                buffer.retire(std::string(100, 'x'));
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    queue.stop();
+    REQUIRE(queue.pending() == 0);
+}
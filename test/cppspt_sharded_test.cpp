@@ -0,0 +1,74 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_parallel.hpp"
+#include "cppspt/cppspt_sharded.hpp"
+
+#include "cppspt_test.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+//This test case checks a parallel sum, and that every shard has its own cache line
+TEST_CASE("Testing Sharded Out Sum", "[CPPSPT::Sharded]")
+{
+    cppspt::parallel_options options(4);
+    cppspt::sharded_out<long long> sum(options.thread_count());
+    REQUIRE(sum.shard_count() == 4);
+
+    for (std::size_t i = 0; i + 1 < sum.shard_count(); i++)
+    {
+        std::uintptr_t first = reinterpret_cast<std::uintptr_t>(&sum.local(i));
+        std::uintptr_t second = reinterpret_cast<std::uintptr_t>(&sum.local(i + 1));
+        REQUIRE(first % 64 == 0);
+        REQUIRE(second - first >= 64);
+    }
+
+    cppspt::run_parallel(options, [&](unsigned index)
+    {
+        for (long long i = 1; i <= 1000; i++)
+        {
+            sum.accumulate(index, i * (index + 1), std::plus<long long>());
+        }
+    });
+
+    cppspt::uninit<long long> total;
+    REQUIRE(sum.reduce(total, std::plus<long long>()));
+    REQUIRE(*total == 500500LL * (1 + 2 + 3 + 4));
+
+    //The shards are empty again
+    for (std::size_t i = 0; i < sum.shard_count(); i++)
+    {
+        REQUIRE(!sum.local(i).was_initialized());
+    }
+}
+
+//This test case checks that only written shards are constructed & combined, in index order
+TEST_CASE("Testing Sharded Out Reduction", "[CPPSPT::Sharded]")
+{
+    auto concat = [](const std::string& a, const std::string& b) { return a + b; };
+
+    construction_count count = run_with_constructions([]
+    {
+        cppspt::sharded_out<XString> shards(8);
+    });
+    REQUIRE(count.constructions == 0);
+
+    cppspt::sharded_out<std::string> shards(3);
+    std::string result = "unchanged";
+    REQUIRE(!shards.reduce(result, concat));
+    REQUIRE(result == "unchanged");
+
+    shards.shard_out(2) = std::string("c");
+    shards.accumulate(0, std::string("a"), concat);
+    shards.accumulate(0, std::string("b"), concat);
+    REQUIRE(!shards.local(1).was_initialized());
+
+    REQUIRE(shards.reduce(result, concat));
+    REQUIRE(result == "abc");
+}
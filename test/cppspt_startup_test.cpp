@@ -0,0 +1,249 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_startup.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/*
+
+    Each registry below is declared before the globals that register with it, so it's constructed first
+
+*/
+
+struct startup_value
+{
+    int order;
+    int sum;
+};
+
+static std::atomic<int> s_startup_order(0);
+static std::atomic<int> s_startup_constructions(0);
+
+static void record_construction(cppspt::out<startup_value> dest, int sum)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    s_startup_constructions++;
+
+    startup_value val;
+    val.order = ++s_startup_order;
+    val.sum = sum;
+    dest = val;
+}
+
+//A diamond: base <- (left, right) <- top, plus two independent globals
+static cppspt::startup_registry s_ordered_registry;
+
+static cppspt::startup_global<startup_value> g_base(s_ordered_registry, "base", {}, [](cppspt::out<startup_value> dest)
+{
+    record_construction(dest, 1);
+});
+
+static cppspt::startup_global<startup_value> g_left(s_ordered_registry, "left", { "base" }, [](cppspt::out<startup_value> dest)
+{
+    record_construction(dest, g_base->sum + 10);
+});
+
+static cppspt::startup_global<startup_value> g_right(s_ordered_registry, "right", { "base" }, [](cppspt::out<startup_value> dest)
+{
+    record_construction(dest, g_base->sum + 100);
+});
+
+static cppspt::startup_global<startup_value> g_top(s_ordered_registry, "top", { "left", "right" }, [](cppspt::out<startup_value> dest)
+{
+    record_construction(dest, g_left->sum + g_right->sum);
+});
+
+static cppspt::startup_global<startup_value> g_first_leaf(s_ordered_registry, "first leaf", {}, [](cppspt::out<startup_value> dest)
+{
+    record_construction(dest, 0);
+});
+
+static cppspt::startup_global<startup_value> g_second_leaf(s_ordered_registry, "second leaf", {}, [](cppspt::out<startup_value> dest)
+{
+    record_construction(dest, 0);
+});
+
+//This test case checks that run constructs every global once, after its dependencies, and times each
+TEST_CASE("Testing Dependency Order of Startup Registry", "[CPPSPT::Startup]")
+{
+    REQUIRE(!g_top.was_initialized());
+    s_startup_constructions = 0;
+
+    REQUIRE(s_ordered_registry.run(cppspt::parallel_options(4)));
+    REQUIRE(s_startup_constructions == 6);
+
+    REQUIRE(g_top.was_initialized());
+    REQUIRE(g_left->order > g_base->order);
+    REQUIRE(g_right->order > g_base->order);
+    REQUIRE(g_top->order > g_left->order);
+    REQUIRE(g_top->order > g_right->order);
+    REQUIRE(g_top->sum == 112);
+
+    std::vector<cppspt::startup_timing> timings = s_ordered_registry.timings();
+    REQUIRE(timings.size() == 6);
+    for (std::size_t i = 0; i < timings.size(); i++)
+    {
+        REQUIRE(!timings[i].forced);
+        REQUIRE(timings[i].nanoseconds >= 10000000);
+        if (i != 0)
+        {
+            REQUIRE(timings[i - 1].nanoseconds >= timings[i].nanoseconds);
+        }
+    }
+
+    //Running again constructs nothing
+    REQUIRE(s_ordered_registry.run(cppspt::parallel_options(4)));
+    REQUIRE(s_startup_constructions == 6);
+
+    //Destroyed values are constructed again
+    s_ordered_registry.destroy_all();
+    REQUIRE(!g_base.was_initialized());
+    REQUIRE(s_ordered_registry.timings().empty());
+
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(s_ordered_registry.run(cppspt::parallel_options(3)));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    REQUIRE(s_startup_constructions == 12);
+    REQUIRE(g_top->sum == 112);
+
+    //Three levels of 20ms each (the leaves run alongside), rather than six in a row
+    REQUIRE(elapsed < std::chrono::milliseconds(110));
+}
+
+static cppspt::startup_registry s_forced_registry;
+
+static cppspt::startup_global<std::string> g_prefix(s_forced_registry, "prefix", {}, [](cppspt::out<std::string> dest)
+{
+    dest = std::string("forced: ");
+});
+
+static cppspt::startup_global<std::string> g_message(s_forced_registry, "message", { "prefix" }, [](cppspt::out<std::string> dest)
+{
+    dest = *g_prefix + "message";
+});
+
+//Default constructed
+static cppspt::startup_global<std::string> g_empty(s_forced_registry, "empty");
+
+//This test case checks that using a global before run constructs it, and its dependencies, on the calling thread
+TEST_CASE("Testing First Use of Startup Global", "[CPPSPT::Startup]")
+{
+    REQUIRE(!g_prefix.was_initialized());
+    REQUIRE(*g_message == "forced: message");
+    REQUIRE(g_prefix.was_initialized());
+    REQUIRE(!g_empty.was_initialized());
+
+    std::vector<cppspt::startup_timing> timings = s_forced_registry.timings();
+    REQUIRE(timings.size() == 2);
+    REQUIRE(timings[0].forced);
+    REQUIRE(timings[1].forced);
+
+    REQUIRE(s_forced_registry.run(cppspt::parallel_options(2)));
+    REQUIRE(g_empty->empty());
+
+    timings = s_forced_registry.timings();
+    REQUIRE(timings.size() == 3);
+    for (const cppspt::startup_timing& timing : timings)
+    {
+        REQUIRE(timing.forced == (std::strcmp(timing.name, "empty") != 0));
+    }
+
+    s_forced_registry.destroy_all();
+}
+
+static cppspt::startup_registry s_racing_registry;
+static std::atomic<int> s_racing_constructions(0);
+
+static cppspt::startup_global<int> g_slow(s_racing_registry, "slow", {}, [](cppspt::out<int> dest)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    s_racing_constructions++;
+    dest = 42;
+});
+
+//This test case checks that threads using a global while it's being constructed wait for it, instead of constructing it again
+TEST_CASE("Testing Concurrent First Use of Startup Global", "[CPPSPT::Startup]")
+{
+    std::atomic<int> sum(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&sum] { sum += *g_slow; });
+    }
+    REQUIRE(s_racing_registry.run(cppspt::parallel_options(2)));
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    REQUIRE(sum == 4 * 42);
+    REQUIRE(s_racing_constructions == 1);
+}
+
+static cppspt::startup_registry s_cycle_registry;
+
+static cppspt::startup_global<int> g_cycle_a(s_cycle_registry, "a", { "b" }, [](cppspt::out<int> dest) { dest = 1; });
+static cppspt::startup_global<int> g_cycle_b(s_cycle_registry, "b", { "a" }, [](cppspt::out<int> dest) { dest = 2; });
+
+//This test case checks that using a global in a dependency cycle fails instead of waiting forever, from one thread or two
+TEST_CASE("Testing Startup Global Cycles", "[CPPSPT::Startup]")
+{
+    REQUIRE(g_cycle_a.try_get() == nullptr);
+    REQUIRE(!g_cycle_a.was_initialized());
+    REQUIRE(!g_cycle_b.was_initialized());
+
+    //Each thread forces one half of the cycle
+    for (int i = 0; i < 20; i++)
+    {
+        std::atomic<int> failures(0);
+        std::thread other([&failures] { failures += (g_cycle_b.try_get() == nullptr); });
+        failures += (g_cycle_a.try_get() == nullptr);
+        other.join();
+        REQUIRE(failures == 2);
+    }
+    REQUIRE(s_cycle_registry.timings().empty());
+}
+
+static cppspt::startup_registry s_throwing_registry;
+static std::atomic<int> s_throwing_attempts(0);
+
+static cppspt::startup_global<int> g_throwing(s_throwing_registry, "throwing", {}, [](cppspt::out<int> dest)
+{
+    if (s_throwing_attempts++ < 2)
+    {
+        throw std::runtime_error("not yet");
+    }
+    dest = 7;
+});
+
+static cppspt::startup_global<int> g_after_throwing(s_throwing_registry, "after throwing", { "throwing" }, [](cppspt::out<int> dest)
+{
+    dest = *g_throwing + 1;
+});
+
+//This test case checks that a factory which throws leaves its global unconstructed, to be tried again, without ending the program
+TEST_CASE("Testing Throwing Startup Global", "[CPPSPT::Startup]")
+{
+    //Inside run, the exception stays on its worker
+    REQUIRE(!s_throwing_registry.run(cppspt::parallel_options(2)));
+    REQUIRE(!g_throwing.was_initialized());
+    REQUIRE(!g_after_throwing.was_initialized());
+
+    //On first use, it reaches the caller
+    REQUIRE_THROWS_AS(g_after_throwing.get(), std::runtime_error);
+    REQUIRE(!g_throwing.was_initialized());
+
+    REQUIRE(*g_after_throwing == 8);
+    REQUIRE(s_throwing_registry.run(cppspt::parallel_options(2)));
+    REQUIRE(s_throwing_attempts == 3);
+}
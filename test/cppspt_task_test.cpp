@@ -0,0 +1,216 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_task.hpp"
+
+#include "cppspt_test.hpp"
+#include "cppspt_tracking.hpp"
+
+#include <array>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+static_assert(sizeof(cppspt::task) == 64, "a task is one cache line");
+
+namespace
+{
+    struct append_to
+    {
+        std::string* target;
+
+        void operator()(const XString& val, int times) const
+        {
+            for (int i = 0; i < times; i++)
+            {
+                *target += val.get();
+            }
+        }
+    };
+
+    //Passes its in parameter on to a task
+    cppspt::task forward_task(cppspt::in<XString> val, std::string& target)
+    {
+        return cppspt::make_task(append_to{ &target }, val, 1);
+    }
+}
+
+//This test case checks that each argument is copied into a task if it is an lvalue, and moved if it is an rvalue
+TEST_CASE("Testing Task Captures", "[CPPSPT::Task]")
+{
+    std::string target;
+    XString val(std::string(40, 'a'));
+
+    construction_count count = run_with_constructions([&]
+    {
+        cppspt::task work = cppspt::make_task(append_to{ &target }, val, 2);
+        REQUIRE(work);
+        work();
+        REQUIRE(!work);
+    });
+    REQUIRE(count.copy_constructions == 1);
+    REQUIRE(count.move_constructions == 0);
+    REQUIRE(target == std::string(80, 'a'));
+
+    target.clear();
+    count = run_with_constructions([&]
+    {
+        cppspt::task work = cppspt::make_task(append_to{ &target }, XString(std::string(40, 'b')), 1);
+        work();
+    });
+    REQUIRE(count.copy_constructions == 0);
+    REQUIRE(count.move_constructions == 1);
+    REQUIRE(target == std::string(40, 'b'));
+
+    //Moving a task relocates its arguments (or, as XString's move may throw, its heap closure), without copying them
+    target.clear();
+    count = run_with_constructions([&]
+    {
+        cppspt::task work = cppspt::make_task(append_to{ &target }, val, 1);
+        REQUIRE(!work.is_inline());
+        cppspt::task moved(std::move(work));
+        REQUIRE(!work);
+        moved();
+    });
+    REQUIRE(count.copy_constructions == 1);
+    REQUIRE(count.move_constructions == 0);
+    REQUIRE(target == std::string(40, 'a'));
+}
+
+//This test case checks that an in parameter passed on to a task keeps whether its caller moved
+TEST_CASE("Testing Task In Parameters", "[CPPSPT::Task]")
+{
+    std::string target;
+    XString val(std::string("in"));
+
+    construction_count count = run_with_constructions([&]
+    {
+        forward_task(val, target)();
+    });
+    REQUIRE(count.copy_constructions == 1);
+    REQUIRE(count.move_constructions == 0);
+
+    count = run_with_constructions([&]
+    {
+        forward_task(std::move(val), target)();
+    });
+    REQUIRE(count.copy_constructions == 0);
+    REQUIRE(count.move_constructions == 1);
+    REQUIRE(target == "inin");
+
+    //A const in is only borrowed, so its value is copied
+    XString other(std::string("const"));
+    const cppspt::in<XString> borrowed(std::move(other));
+    count = run_with_constructions([&]
+    {
+        cppspt::make_task(append_to{ &target }, borrowed, 1)();
+    });
+    REQUIRE(count.copy_constructions == 1);
+    REQUIRE(target == "ininconst");
+}
+
+//This test case checks that small tasks are stored inline, without allocating, and large ones on the heap
+TEST_CASE("Testing Task Storage", "[CPPSPT::Task]")
+{
+    int sum = 0;
+    {
+        cppspt_tracking::expect_at_most expectation(0, 0);
+        cppspt::task work = cppspt::make_task([&sum](int a, int b) { sum += a + b; }, 1, 2);
+        REQUIRE(work.is_inline());
+        work();
+        REQUIRE(expectation.satisfied());
+    }
+    REQUIRE(sum == 3);
+
+    //A long string's buffer is moved in, not reallocated
+    std::string moved_from(100, 'x');
+    std::string result;
+    {
+        cppspt_tracking::expect_at_most expectation(0, 0);
+        cppspt::task work = cppspt::make_task([&result](std::string&& s) { result = std::move(s); }, std::move(moved_from));
+        REQUIRE(work.is_inline());
+        work();
+        REQUIRE(expectation.satisfied());
+    }
+    REQUIRE(result == std::string(100, 'x'));
+
+    std::array<long long, 16> big;
+    big.fill(2);
+    long long total = 0;
+    cppspt::task work = cppspt::make_task([&total](const std::array<long long, 16>& values)
+    {
+        for (long long value : values)
+        {
+            total += value;
+        }
+    }, big);
+    REQUIRE(!work.is_inline());
+
+    cppspt::task moved(std::move(work));
+    moved();
+    REQUIRE(total == 32);
+
+    //A larger inline_task holds it
+    cppspt::inline_task<256> large = cppspt::make_task<cppspt::inline_task<256>>([&total](const std::array<long long, 16>& values)
+    {
+        total += values[0];
+    }, big);
+    REQUIRE(large.is_inline());
+    large();
+    REQUIRE(total == 34);
+}
+
+//This test case checks that a thread pool runs every task submitted, including while its queue is full
+TEST_CASE("Testing Thread Pool", "[CPPSPT::Task]")
+{
+    std::atomic<long long> sum(0);
+    {
+        cppspt::thread_pool pool(4, 8);
+        REQUIRE(pool.thread_count() == 4);
+
+        for (long long i = 1; i <= 1000; i++)
+        {
+            pool.submit([&sum](long long value, const std::string& name) { sum += value * static_cast<long long>(name.size()); }, i, std::string("ab"));
+        }
+        pool.wait();
+        REQUIRE(sum.load() == 1001000);
+
+        //Tasks still queued when the pool is destroyed are run first
+        for (long long i = 0; i < 100; i++)
+        {
+            pool.submit([&sum] { sum += 1; });
+        }
+    }
+    REQUIRE(sum.load() == 1001100);
+}
+
+//This test case checks that a task throwing doesn't stop the pool, and that wait rethrows its exception once
+TEST_CASE("Testing Thread Pool Exceptions", "[CPPSPT::Task]")
+{
+    std::atomic<int> ran(0);
+    cppspt::thread_pool pool(2, 8);
+
+    for (int i = 0; i < 20; i++)
+    {
+        pool.submit([&ran](int value)
+        {
+            ran++;
+            if (value % 10 == 3)
+            {
+                throw std::runtime_error("task");
+            }
+        }, i);
+    }
+    REQUIRE_THROWS_AS(pool.wait(), std::runtime_error);
+    REQUIRE(ran.load() == 20);
+
+    pool.wait();
+    pool.submit([&ran] { ran++; });
+    pool.wait();
+    REQUIRE(ran.load() == 21);
+}
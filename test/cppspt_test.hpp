@@ -28,7 +28,14 @@ struct construction_count
     int move_assignments = 0;
 };
 
-static construction_count s_construction_count;
+//One counter shared by every test file (the inline functions below must all see the same object)
+inline construction_count& shared_construction_count()
+{
+    static construction_count count;
+    return count;
+}
+
+static construction_count& s_construction_count = shared_construction_count();
 
 template<typename T>
 class construction_counter
@@ -101,7 +108,14 @@ inline construction_count run_with_constructions(std::function<void()> func)
 
 */
 
-static std::string s_history;
+//One history shared by every test file (the inline functions below must all see the same object)
+inline std::string& shared_history()
+{
+    static std::string history;
+    return history;
+}
+
+static std::string& s_history = shared_history();
 
 template<typename T>
 class noisy
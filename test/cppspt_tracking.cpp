@@ -0,0 +1,268 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppspt_tracking.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+/*
+
+    Registry of every thread's counters, and the replaced global operator new & delete
+
+*/
+
+namespace cppspt_tracking
+{
+    namespace
+    {
+        std::mutex s_registry_mutex;
+        thread_counters* s_registry_head = nullptr;
+
+        //Counters of threads that have exited
+        counts s_retired;
+
+        //Set once the calling thread's counters are destroyed (deallocations can still happen after that)
+        thread_local bool t_counters_destroyed = false;
+
+        //Counters shared by threads that are exiting. Never destroyed, for the same reason
+        thread_counters& exiting_thread_counters()
+        {
+            alignas(thread_counters) static unsigned char storage[sizeof(thread_counters)];
+            static thread_counters* counters = new (storage) thread_counters(true);
+            return *counters;
+        }
+    }
+
+    thread_counters::thread_counters(bool shared_) :
+        constructions(0),
+        destructions(0),
+        copies(0),
+        moves(0),
+        allocations(0),
+        deallocations(0),
+        allocated_bytes(0),
+        deallocated_bytes(0),
+        prev(nullptr),
+        next(nullptr),
+        shared(shared_)
+    {
+        std::lock_guard<std::mutex> lock(s_registry_mutex);
+        next = s_registry_head;
+        if (next != nullptr)
+        {
+            next->prev = this;
+        }
+        s_registry_head = this;
+    }
+
+    thread_counters::~thread_counters()
+    {
+        t_counters_destroyed = true;
+
+        std::lock_guard<std::mutex> lock(s_registry_mutex);
+        s_retired += snapshot();
+
+        if (prev != nullptr)
+        {
+            prev->next = next;
+        }
+        else
+        {
+            s_registry_head = next;
+        }
+
+        if (next != nullptr)
+        {
+            next->prev = prev;
+        }
+    }
+
+    counts thread_counters::snapshot() const
+    {
+        counts result;
+        result.constructions = constructions.load(std::memory_order_relaxed);
+        result.destructions = destructions.load(std::memory_order_relaxed);
+        result.copies = copies.load(std::memory_order_relaxed);
+        result.moves = moves.load(std::memory_order_relaxed);
+        result.allocations = allocations.load(std::memory_order_relaxed);
+        result.deallocations = deallocations.load(std::memory_order_relaxed);
+        result.allocated_bytes = allocated_bytes.load(std::memory_order_relaxed);
+        result.deallocated_bytes = deallocated_bytes.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    thread_counters& this_thread_counters()
+    {
+        if (t_counters_destroyed)
+        {
+            return exiting_thread_counters();
+        }
+
+        thread_local thread_counters counters;
+        return counters;
+    }
+
+    counts thread_counts()
+    {
+        return this_thread_counters().snapshot();
+    }
+
+    counts total_counts()
+    {
+        std::lock_guard<std::mutex> lock(s_registry_mutex);
+
+        counts result = s_retired;
+        for (thread_counters* counters = s_registry_head; counters != nullptr; counters = counters->next)
+        {
+            result += counters->snapshot();
+        }
+        return result;
+    }
+}
+
+/*
+
+    Every allocation is prefixed by a header holding its size (and, for over-aligned allocations, the start of the block),
+    so that unsized deletes can still count bytes
+
+*/
+
+namespace
+{
+    struct alignas(alignof(std::max_align_t)) allocation_header
+    {
+        std::size_t size;
+        void* block;
+    };
+
+    void* tracked_allocate(std::size_t size, std::size_t alignment)
+    {
+        if (alignment < alignof(allocation_header))
+        {
+            alignment = alignof(allocation_header);
+        }
+
+        void* block = std::malloc(size + sizeof(allocation_header) + alignment);
+        if (block == nullptr)
+        {
+            return nullptr;
+        }
+
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(block) + sizeof(allocation_header);
+        address = (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+
+        allocation_header* header = reinterpret_cast<allocation_header*>(address) - 1;
+        header->size = size;
+        header->block = block;
+
+        cppspt_tracking::thread_counters& counters = cppspt_tracking::this_thread_counters();
+        cppspt_tracking::bump(counters, counters.allocations);
+        cppspt_tracking::bump(counters, counters.allocated_bytes, static_cast<long long>(size));
+
+        return reinterpret_cast<void*>(address);
+    }
+
+    void* tracked_allocate_or_throw(std::size_t size, std::size_t alignment)
+    {
+        void* ptr = tracked_allocate(size, alignment);
+        if (ptr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    void tracked_deallocate(void* ptr)
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+
+        allocation_header* header = static_cast<allocation_header*>(ptr) - 1;
+
+        cppspt_tracking::thread_counters& counters = cppspt_tracking::this_thread_counters();
+        cppspt_tracking::bump(counters, counters.deallocations);
+        cppspt_tracking::bump(counters, counters.deallocated_bytes, static_cast<long long>(header->size));
+
+        std::free(header->block);
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    return tracked_allocate_or_throw(size, 0);
+}
+
+void* operator new[](std::size_t size)
+{
+    return tracked_allocate_or_throw(size, 0);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return tracked_allocate(size, 0);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return tracked_allocate(size, 0);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    tracked_deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    tracked_deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    tracked_deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    tracked_deallocate(ptr);
+}
+
+#if defined (__cpp_aligned_new)
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return tracked_allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return tracked_allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    tracked_deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    tracked_deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    tracked_deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    tracked_deallocate(ptr);
+}
+
+#endif
@@ -0,0 +1,254 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/*
+
+    Thread-safe instrumentation for tests and benchmarks
+
+    Every thread keeps its own counters of constructions, copies & moves (of tracked<T> values),
+    and of heap allocations (through the replaced global operator new & delete in cppspt_tracking.cpp).
+    A tracking_scope snapshots the counters on creation, and reports what happened since,
+    either on the current thread only or summed over every thread.
+
+*/
+
+namespace cppspt_tracking
+{
+    /// <summary>
+    /// A snapshot of the counters
+    /// </summary>
+    struct counts
+    {
+        long long constructions = 0;
+        long long destructions = 0;
+        long long copies = 0;           //Copy constructions & copy assignments
+        long long moves = 0;            //Move constructions & move assignments
+        long long allocations = 0;
+        long long deallocations = 0;
+        long long allocated_bytes = 0;
+        long long deallocated_bytes = 0;
+
+        counts operator-(const counts& other) const
+        {
+            counts result;
+            result.constructions = constructions - other.constructions;
+            result.destructions = destructions - other.destructions;
+            result.copies = copies - other.copies;
+            result.moves = moves - other.moves;
+            result.allocations = allocations - other.allocations;
+            result.deallocations = deallocations - other.deallocations;
+            result.allocated_bytes = allocated_bytes - other.allocated_bytes;
+            result.deallocated_bytes = deallocated_bytes - other.deallocated_bytes;
+            return result;
+        }
+
+        counts& operator+=(const counts& other)
+        {
+            constructions += other.constructions;
+            destructions += other.destructions;
+            copies += other.copies;
+            moves += other.moves;
+            allocations += other.allocations;
+            deallocations += other.deallocations;
+            allocated_bytes += other.allocated_bytes;
+            deallocated_bytes += other.deallocated_bytes;
+            return *this;
+        }
+    };
+
+    /// <summary>
+    /// The live counters of one thread. Only the owning thread writes them, any thread may read them
+    /// </summary>
+    struct thread_counters
+    {
+        std::atomic<long long> constructions;
+        std::atomic<long long> destructions;
+        std::atomic<long long> copies;
+        std::atomic<long long> moves;
+        std::atomic<long long> allocations;
+        std::atomic<long long> deallocations;
+        std::atomic<long long> allocated_bytes;
+        std::atomic<long long> deallocated_bytes;
+
+        //Intrusive list of every thread's counters (a std::vector would allocate from inside operator new)
+        thread_counters* prev;
+        thread_counters* next;
+
+        //Set on the counters that exiting threads share, which several threads can bump at once
+        bool shared;
+
+        explicit thread_counters(bool shared_ = false);
+        ~thread_counters();
+
+        counts snapshot() const;
+    };
+
+    /// <summary>
+    /// The counters of the calling thread
+    /// </summary>
+    thread_counters& this_thread_counters();
+
+    /// <summary>
+    /// The counters of the calling thread, as a snapshot
+    /// </summary>
+    counts thread_counts();
+
+    /// <summary>
+    /// The counters summed over every thread (including threads that have exited)
+    /// </summary>
+    counts total_counts();
+
+    //Adds amount to one of counters' members
+    inline void bump(thread_counters& counters, std::atomic<long long>& counter, long long amount = 1)
+    {
+        if (counters.shared)
+        {
+            counter.fetch_add(amount, std::memory_order_relaxed);
+            return;
+        }
+
+        //Only the owning thread writes, so a relaxed load & store is enough (and cheaper than fetch_add)
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// Measures the counters from its creation
+    /// </summary>
+    class tracking_scope
+    {
+    private:
+        bool m_all_threads;
+        counts m_start;
+
+    public:
+        //all_threads: measure every thread, rather than only the calling thread
+        explicit tracking_scope(bool all_threads = false) :
+            m_all_threads(all_threads),
+            m_start(all_threads ? total_counts() : thread_counts())
+        {
+        }
+
+        counts delta() const
+        {
+            return (m_all_threads ? total_counts() : thread_counts()) - m_start;
+        }
+    };
+
+    /// <summary>
+    /// A tracking scope that checks an upper bound on allocations and copies.
+    /// Negative limits are unchecked. Use as REQUIRE(expectation.satisfied()) at the end of the scope
+    /// </summary>
+    class expect_at_most
+    {
+    private:
+        tracking_scope m_scope;
+        long long m_allocations;
+        long long m_copies;
+
+    public:
+        expect_at_most(long long allocations, long long copies, bool all_threads = false) :
+            m_scope(all_threads),
+            m_allocations(allocations),
+            m_copies(copies)
+        {
+        }
+
+        counts delta() const
+        {
+            return m_scope.delta();
+        }
+
+        bool satisfied() const
+        {
+            counts c = delta();
+            return (m_allocations < 0 || c.allocations <= m_allocations) && (m_copies < 0 || c.copies <= m_copies);
+        }
+    };
+
+    /// <summary>
+    /// Wraps a T, counting its constructions, copies, moves and destructions on the current thread
+    /// </summary>
+    template<typename T>
+    class tracked
+    {
+    private:
+        T m_val;
+
+    public:
+        tracked()
+        {
+            thread_counters& counters = this_thread_counters();
+            bump(counters, counters.constructions);
+        }
+
+        tracked(const T& val) : m_val(val)
+        {
+            thread_counters& counters = this_thread_counters();
+            bump(counters, counters.constructions);
+        }
+
+        tracked(T&& val) : m_val(std::move(val))
+        {
+            thread_counters& counters = this_thread_counters();
+            bump(counters, counters.constructions);
+        }
+
+        tracked(const tracked<T>& other) : m_val(other.m_val)
+        {
+            thread_counters& counters = this_thread_counters();
+            bump(counters, counters.constructions);
+            bump(counters, counters.copies);
+        }
+
+        tracked(tracked<T>&& other) : m_val(std::move(other.m_val))
+        {
+            thread_counters& counters = this_thread_counters();
+            bump(counters, counters.constructions);
+            bump(counters, counters.moves);
+        }
+
+        ~tracked()
+        {
+            thread_counters& counters = this_thread_counters();
+            bump(counters, counters.destructions);
+        }
+
+        tracked<T>& operator=(const tracked<T>& other)
+        {
+            thread_counters& counters = this_thread_counters();
+            bump(counters, counters.copies);
+            m_val = other.m_val;
+            return *this;
+        }
+
+        tracked<T>& operator=(tracked<T>&& other)
+        {
+            thread_counters& counters = this_thread_counters();
+            bump(counters, counters.moves);
+            m_val = std::move(other.m_val);
+            return *this;
+        }
+
+        bool operator==(const tracked<T>& other) const
+        {
+            return m_val == other.m_val;
+        }
+
+        const T& get() const
+        {
+            return m_val;
+        }
+
+        T& get()
+        {
+            return m_val;
+        }
+    };
+}
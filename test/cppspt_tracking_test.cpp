@@ -0,0 +1,122 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch.hpp"
+
+#include "cppspt/cppspt.hpp"
+#include "cppspt/cppspt_queue.hpp"
+
+#include "cppspt_tracking.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using TString = cppspt_tracking::tracked<std::string>;
+
+void copy_from_in(cppspt::in<TString> str)
+{
+    TString copy = str;
+}
+
+void resolve_from_in(cppspt::in<TString> str)
+{
+    TString moved = cppspt::resolve(str);
+}
+
+TEST_CASE("Testing Tracking Counts", "[CPPSPT::Tracking]")
+{
+    {
+        cppspt_tracking::tracking_scope scope;
+
+        TString str(std::string(100, 'x'));
+        copy_from_in(str);
+        resolve_from_in(TString());
+
+        cppspt_tracking::counts counts = scope.delta();
+        REQUIRE(counts.constructions == 4);
+        REQUIRE(counts.copies == 1);
+        REQUIRE(counts.moves == 1);
+        REQUIRE(counts.destructions == 3);
+        REQUIRE(counts.allocations == 2);
+        REQUIRE(counts.deallocations == 1);
+        REQUIRE(counts.allocated_bytes >= 200);
+    }
+
+    //Counts on other threads are only seen when asked for
+    cppspt_tracking::tracking_scope this_thread;
+    cppspt_tracking::tracking_scope all_threads(true);
+
+    std::thread worker([] { TString a, b; a = b; });
+    worker.join();
+
+    REQUIRE(this_thread.delta().copies == 0);
+    REQUIRE(all_threads.delta().copies == 1);
+    REQUIRE(all_threads.delta().constructions == 2);
+}
+
+TEST_CASE("Testing Allocation & Copy Expectations", "[CPPSPT::Tracking]")
+{
+    cppspt_tracking::expect_at_most none(0, 0);
+    std::string small = "small";
+    REQUIRE(none.satisfied());
+
+    std::vector<int> values(100);
+    REQUIRE(!none.satisfied());
+
+    cppspt_tracking::expect_at_most unlimited_allocations(-1, 0);
+    std::vector<int> more(100);
+    REQUIRE(unlimited_allocations.satisfied());
+}
+
+TEST_CASE("Testing Queue Guarantees Under Concurrency", "[CPPSPT::Tracking]")
+{
+    const int producers = 4;
+    const int per_producer = 10000;
+    cppspt::mpmc_queue<TString> q(256);
+
+    std::vector<std::thread> threads;
+    threads.reserve(2 * producers);
+
+    //Moving values through the queue never copies, and only the strings (and the threads) allocate
+    cppspt_tracking::expect_at_most guard(producers * per_producer + 2 * producers, 0, true);
+
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&q]
+        {
+            for (int i = 0; i < per_producer; i++)
+            {
+                q.push(TString(std::string(64, 'x')));
+            }
+        });
+        threads.emplace_back([&q]
+        {
+            cppspt::uninit<TString> dest;
+            for (int i = 0; i < per_producer; i++)
+            {
+                q.pop(dest);
+            }
+        });
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    cppspt_tracking::counts counts = guard.delta();
+    REQUIRE(guard.satisfied());
+    REQUIRE(counts.copies == 0);
+
+    //A warmed up queue of ints doesn't allocate at all
+    cppspt::spsc_queue<int> ints(64);
+    cppspt_tracking::expect_at_most no_allocations(0, 0);
+    for (int i = 0; i < 1000; i++)
+    {
+        int x;
+        ints.push(i);
+        ints.pop(x);
+    }
+    REQUIRE(no_allocations.satisfied());
+}
@@ -24,7 +24,7 @@ void assign_to_uninit(cppspt::in<NXString> str)
 
 void move_construct_uninit_then_assign(cppspt::in<NXString> strToAssign)
 {
-    cppspt::uninit<NXString> copy = NXString();
+    cppspt::uninit<NXString> copy{ NXString() };
     copy = std::move(strToAssign);
 }
 
@@ -138,4 +138,65 @@ TEST_CASE("Testing Construction-Assignement of Uninitialized", "[CPPSPT::Uninit]
     REQUIRE(count.copy_assignments == 1);
     REQUIRE(count.move_assignments == 0);
 
-}
\ No newline at end of file
+}
+
+NXString make_nxstring()
+{
+    return NXString();
+}
+
+//This test case checks that init_with constructs the factory's result in place, with no temporary to move from
+TEST_CASE("Testing Factory Construction of Uninitialized", "[CPPSPT::Uninit]")
+{
+    auto init_from_factory = []
+    {
+        cppspt::uninit<NXString> str;
+        str.init_with(make_nxstring);
+    };
+
+    auto assign_from_factory = []
+    {
+        cppspt::uninit<NXString> str;
+        str = make_nxstring();
+    };
+
+    REQUIRE(run_with_history(init_from_factory) == "ctor dtor ");
+    REQUIRE(run_with_history(assign_from_factory) == "ctor move-ctor dtor dtor ");
+
+    //An initialized value is replaced, not assigned
+    REQUIRE(run_with_history([]
+    {
+        cppspt::uninit<NXString> str;
+        str.init_with([] { return NXString(); });
+        str.init_with([] { return NXString(); });
+    }) == "ctor dtor ctor dtor ");
+
+    construction_count count = run_with_constructions([]
+    {
+        cppspt::uninit<XString> str;
+        XString& val = str.init_with([] { return XString("made"); });
+        REQUIRE(val.get() == "made");
+        REQUIRE(str.was_initialized());
+    });
+    REQUIRE(count.constructions == 1);
+    REQUIRE(count.destructions == 1);
+    REQUIRE(count.copy_constructions == 0);
+    REQUIRE(count.move_constructions == 0);
+    REQUIRE(count.copy_assignments == 0);
+    REQUIRE(count.move_assignments == 0);
+}
+
+#if CPPSPT_CPLUSPLUS >= 201703L
+
+//This test case checks that, with guaranteed copy elision, init_with can construct a type that can't be moved
+TEST_CASE("Testing Factory Construction of Non-Movable Uninitialized", "[CPPSPT::Uninit]")
+{
+    REQUIRE(run_with_history([]
+    {
+        cppspt::uninit<nmString> str;
+        str.init_with([] { return nmString(NString("made")); });
+        REQUIRE(str->val().get() == "made");
+    }) == "ctor copy-ctor dtor dtor ");
+}
+
+#endif